@@ -0,0 +1,77 @@
+#include "bench-common.h"
+
+#include <new>
+#include <memory>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+
+using namespace ASM;
+
+//Global allocation counters, the benchmark runs single threaded in direct mode
+static size_t allocationsCount = 0;
+static size_t allocatedBytes = 0;
+
+void* operator new(size_t size)
+{
+    ++allocationsCount;
+    allocatedBytes += size;
+
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+int main(int argc, const char** argv)
+{
+    const size_t lines = Bench::GetArgOr(argc, argv, 1, 1000000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 3);
+
+    const std::string source = Bench::GenerateSource(lines);
+
+    std::cout << "Parsing " << lines << " lines (" << source.size() / (1024 * 1024) << " MB)" << std::endl;
+
+    double bestParse = 0, bestTeardown = 0;
+    size_t allocations = 0, bytes = 0, nodes = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+        Lexer lexer(*context);
+        Parser parser(*context, lexer);
+
+        const size_t allocationsBefore = allocationsCount;
+        const size_t bytesBefore = allocatedBytes;
+
+        Bench::Timer timer;
+        AbstractSyntaxTree ast = parser.Parse();
+        const double parseSeconds = timer.Seconds();
+
+        allocations = allocationsCount - allocationsBefore;
+        bytes = allocatedBytes - bytesBefore;
+        nodes = ast.size();
+
+        //Tree and everything it owns is released with the context
+        timer.Reset();
+        ast = AbstractSyntaxTree();
+        context.reset();
+        const double teardownSeconds = timer.Seconds();
+
+        if (bestParse == 0 || parseSeconds < bestParse)
+            bestParse = parseSeconds;
+        if (bestTeardown == 0 || teardownSeconds < bestTeardown)
+            bestTeardown = teardownSeconds;
+    }
+
+    std::cout << nodes << " top level nodes, " << allocations << " allocations ("
+        << allocations / static_cast<double>(nodes) << " per node), " << bytes / (1024 * 1024) << " MB requested" << std::endl;
+
+    Bench::Report("ast/parse", bestParse, source.size());
+    Bench::Report("ast/teardown", bestTeardown, source.size());
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#ifndef __BENCH_COMMON_H
+#define __BENCH_COMMON_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace Bench
+{
+    class Timer
+    {
+    private:
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    public:
+        inline void Reset() { begin = std::chrono::steady_clock::now(); }
+
+        inline double Seconds() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+    };
+
+    //Deterministic pseudo random generator, keeps generated sources identical between runs
+    class Random
+    {
+    private:
+        uint64_t state;
+    public:
+        Random(uint64_t seed = 0x9E3779B97F4A7C15ull) : state(seed) {}
+
+        inline uint64_t Next()
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            return state;
+        }
+
+        inline uint64_t Next(uint64_t bound) { return Next() % bound; }
+    };
+
+    inline size_t GetArgOr(int argc, const char** argv, int index, size_t defaultValue)
+    {
+        return (argc > index ? std::strtoull(argv[index], nullptr, 10) : defaultValue);
+    }
+
+    inline void Report(const std::string& name, double seconds, size_t bytes)
+    {
+        std::cout << std::left << std::setw(32) << name
+            << std::right << std::fixed << std::setprecision(3) << std::setw(10) << seconds * 1000 << " ms"
+            << std::setw(12) << std::setprecision(1) << (bytes / (1024.0 * 1024.0)) / seconds << " MB/s" << std::endl;
+    }
+
+    //Generates instruction dense source with comments, data lines, labels and constants
+    inline std::string GenerateSource(size_t lines, uint64_t seed = 1)
+    {
+        static const char* mnemonics[] = { "mov", "add", "sub", "xor", "and", "or", "cmp", "test", "xchg" };
+        static const char* regs[] = { "ax", "bx", "cx", "dx", "si", "di", "bp", "al", "bl", "cl", "dl", "ah" };
+
+        Random random(seed);
+        std::string source;
+
+        source.reserve(lines * 28);
+        source += "org 100h\n";
+
+        for (size_t i = 0; i < lines; ++i)
+        {
+            const uint64_t kind = random.Next(100);
+
+            if (kind < 5)
+            {
+                source += "; generated comment line " + std::to_string(i) + ", with [some] text + symbols\n";
+            }
+            else if (kind < 8)
+            {
+                source += "CONST_" + std::to_string(i) + " equ " + std::to_string(i) + " * 2 + 1\n";
+            }
+            else if (kind < 12)
+            {
+                source += "label_" + std::to_string(i) + ":\n";
+            }
+            else if (kind < 18)
+            {
+                source += "    db \"text " + std::to_string(i) + "\", 0" + std::to_string(random.Next(10)) + "Fh, 'c', 13, 10 ; data\n";
+            }
+            else
+            {
+                const char* reg = regs[random.Next(std::size(regs))];
+
+                source += '\t';
+                source += mnemonics[random.Next(std::size(mnemonics))];
+                source += ' ';
+
+                switch (random.Next(4))
+                {
+                case 0:
+                    source += std::string(reg) + ", " + regs[random.Next(std::size(regs))];
+                    break;
+                case 1:
+                    source += std::string("ax, ") + std::to_string(random.Next(0x7FFF));
+                    break;
+                case 2:
+                    source += std::string("word [bx+si+") + std::to_string(random.Next(100)) + "], ax";
+                    break;
+                default:
+                    source += std::string("cx, 0x") + "1F2E";
+                    break;
+                }
+
+                source += '\n';
+            }
+        }
+
+        return source;
+    }
+
+    //Source without errors, so every build goes up to writing its output
+    inline std::string GenerateValidSource(size_t lines, uint64_t seed)
+    {
+        static const char* instructions[] =
+        {
+            "mov ax, bx", "add ax, 1234h", "sub cx, dx", "xor si, si", "cmp al, 10",
+            "mov word [bx+si+4], ax", "inc di", "push ax", "pop bx", "db \"text\", 13, 10"
+        };
+
+        Random random(seed);
+        std::string source = "org 100h\n";
+
+        for (size_t i = 0; i < lines; ++i)
+        {
+            if (i % 16 == 0)
+                source += "label_" + std::to_string(i) + ":\n";
+
+            if (i % 16 == 15)
+                source += "\tjmp label_" + std::to_string(i / 16 * 16) + "\n";
+            else
+                source += std::string("\t") + instructions[random.Next(std::size(instructions))] + "\n";
+        }
+
+        return source;
+    }
+}
+
+#endif
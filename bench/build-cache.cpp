@@ -0,0 +1,123 @@
+#include "bench-common.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "cli/cli-handler.h"
+
+using namespace ASM;
+
+//Builds all files with one invocation of the command line handler, returns false if any build failed
+static bool Build(const std::vector<std::string>& files, const std::vector<std::string>& options)
+{
+    std::vector<std::string> args = { "wh-asm" };
+    args.insert(args.end(), options.begin(), options.end());
+
+    for (auto& file : files)
+    {
+        args.push_back("-i");
+        args.push_back(file);
+    }
+
+    std::vector<const char*> argv;
+
+    for (auto& arg : args)
+        argv.push_back(arg.c_str());
+
+    std::ostringstream log;
+    std::streambuf* coutBuffer = std::cout.rdbuf(log.rdbuf());
+
+    CLI::CommandLineInterfaceHandler handler(argv.size(), argv.data());
+    const bool result = handler.Handle();
+
+    std::cout.rdbuf(coutBuffer);
+
+    return result;
+}
+
+static std::vector<std::string> ReadOutputs(const std::vector<std::string>& files)
+{
+    std::vector<std::string> outputs;
+
+    for (auto& file : files)
+    {
+        std::ifstream in(std::filesystem::path(file).replace_extension(""), std::ios::binary);
+        std::ostringstream content;
+
+        content << in.rdbuf();
+        outputs.push_back(std::move(content).str());
+    }
+
+    return outputs;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t filesCount = Bench::GetArgOr(argc, argv, 1, 64);
+    const size_t lines = Bench::GetArgOr(argc, argv, 2, 5000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 3, 3);
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "wh-asm-build-cache";
+    const std::filesystem::path cacheDirectory = directory / "cache";
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::string> files;
+    size_t sourceSize = 0;
+
+    for (size_t i = 0; i < filesCount; ++i)
+    {
+        const std::string source = Bench::GenerateValidSource(lines, i + 1);
+        const std::filesystem::path file = directory / ("file-" + std::to_string(i) + ".asm");
+
+        std::ofstream(file, std::ios::binary) << source;
+
+        files.push_back(file.string());
+        sourceSize += source.size();
+    }
+
+    std::cout << "Building " << filesCount << " files of " << lines << " lines (" << sourceSize / (1024 * 1024) << " MB)" << std::endl;
+
+    bool isSucceeded = Build(files, {});
+    const std::vector<std::string> expected = ReadOutputs(files);
+
+    const std::vector<std::string> cacheOptions = { "-cache", cacheDirectory.string() };
+
+    double bestCold = 0;
+    double bestWarm = 0;
+    bool isIdentical = true;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        std::filesystem::remove_all(cacheDirectory);
+
+        Bench::Timer coldTimer;
+        isSucceeded &= Build(files, cacheOptions);
+
+        const double coldSeconds = coldTimer.Seconds();
+
+        isIdentical &= (ReadOutputs(files) == expected);
+
+        Bench::Timer warmTimer;
+        isSucceeded &= Build(files, cacheOptions);
+
+        const double warmSeconds = warmTimer.Seconds();
+
+        isIdentical &= (ReadOutputs(files) == expected);
+
+        if (bestCold == 0 || coldSeconds < bestCold)
+            bestCold = coldSeconds;
+        if (bestWarm == 0 || warmSeconds < bestWarm)
+            bestWarm = warmSeconds;
+    }
+
+    std::filesystem::remove_all(directory);
+
+    std::cout << (isSucceeded && isIdentical ? "Cached outputs are identical" : "Cached outputs differ or failed to build") << std::endl;
+
+    Bench::Report("build-cache/cold", bestCold, sourceSize);
+    Bench::Report("build-cache/warm", bestWarm, sourceSize);
+
+    return (isSucceeded && isIdentical ? 0 : 1);
+}
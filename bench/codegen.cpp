@@ -0,0 +1,59 @@
+#include "bench-common.h"
+
+#include <memory>
+#include <sstream>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+
+using namespace ASM;
+
+int main(int argc, const char** argv)
+{
+    const size_t lines = Bench::GetArgOr(argc, argv, 1, 500000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 3);
+
+    const std::string source = Bench::GenerateSource(lines);
+
+    std::cout << "Generating code for " << lines << " lines (" << source.size() / (1024 * 1024) << " MB)" << std::endl;
+
+    //Messages for generated source aren't interesting
+    std::ostringstream log;
+
+    double best = 0;
+    size_t codeSize = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        //Code generator fills sections and symbols of the context, so each pass starts from scratch
+        auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+        context->SetLogOutput(log);
+
+        Lexer lexer(*context);
+        Parser parser(*context, lexer);
+        AbstractSyntaxTree ast = parser.Parse();
+
+        Codegen::CodeGenerator codeGenerator(*context);
+
+        Bench::Timer timer;
+        TranslationUnit& unit = codeGenerator.ProccessAST(ast);
+        const double seconds = timer.Seconds();
+
+        codeSize = 0;
+
+        for (auto& pair : unit.GetSectionMap())
+            codeSize += pair.second.GetCode()->size();
+
+        if (best == 0 || seconds < best)
+            best = seconds;
+
+        log.str("");
+    }
+
+    std::cout << codeSize << " bytes of machine code" << std::endl;
+
+    Bench::Report("codegen", best, source.size());
+
+    return 0;
+}
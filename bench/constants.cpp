@@ -0,0 +1,85 @@
+#include "bench-common.h"
+
+#include <memory>
+#include <sstream>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+#include "linking/linker.h"
+
+using namespace ASM;
+
+//EQU header where every constant is built from the previous ones, used by many instructions
+static std::string GenerateConstantChains(size_t constants, size_t uses)
+{
+    Bench::Random random(11);
+    std::string source = "org 100h\nCONST_0 equ 1\n";
+
+    for (size_t i = 1; i < constants; ++i)
+    {
+        source += "CONST_" + std::to_string(i) + " equ (CONST_" + std::to_string(i - 1) +
+            " + CONST_" + std::to_string(random.Next(i)) + ") & 0FFFh\n";
+    }
+
+    source += "start:\n";
+
+    for (size_t i = 0; i < uses; ++i)
+    {
+        source += "\tmov ax, CONST_" + std::to_string(constants - 1 - random.Next(constants / 10 + 1)) + "\n";
+        source += "\tdw CONST_" + std::to_string(random.Next(constants)) + " + start\n";
+    }
+
+    return source;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t constants = Bench::GetArgOr(argc, argv, 1, 2000);
+    const size_t uses = Bench::GetArgOr(argc, argv, 2, 2000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 3, 3);
+
+    const std::string source = GenerateConstantChains(constants, uses);
+
+    //Messages for generated source aren't interesting
+    std::ostringstream log;
+
+    double bestCodegen = 0;
+    double bestLink = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+        context->SetLogOutput(log);
+
+        Lexer lexer(*context);
+        Parser parser(*context, lexer);
+        AbstractSyntaxTree ast = parser.Parse();
+
+        Codegen::CodeGenerator codeGenerator(*context);
+
+        Bench::Timer codegenTimer;
+        codeGenerator.ProccessAST(ast);
+        const double codegenSeconds = codegenTimer.Seconds();
+
+        Linker linker(*context);
+
+        Bench::Timer linkTimer;
+        auto object = linker.Link(LinkingFormat::RawBinary);
+        const double linkSeconds = linkTimer.Seconds();
+
+        if (bestCodegen == 0 || codegenSeconds < bestCodegen)
+            bestCodegen = codegenSeconds;
+        if (bestLink == 0 || linkSeconds < bestLink)
+            bestLink = linkSeconds;
+
+        log.str("");
+    }
+
+    std::cout << constants << " chained constants, " << uses << " uses" << std::endl;
+
+    Bench::Report("constants/codegen", bestCodegen, source.size());
+    Bench::Report("constants/link", bestLink, source.size());
+
+    return 0;
+}
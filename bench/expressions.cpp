@@ -0,0 +1,101 @@
+#include "bench-common.h"
+
+#include <memory>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+
+using namespace ASM;
+
+//Long flat constant expressions, like the ones in generated EQU headers
+static std::string GenerateLongExpressions(size_t lines, size_t operators)
+{
+    static const char* ops[] = { " + ", " - ", " * ", " / ", " & ", " | ", " ^ ", " << ", " >> " };
+
+    Bench::Random random(3);
+    std::string source;
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        source += "LONG_" + std::to_string(i) + " equ " + std::to_string(random.Next(1000));
+
+        for (size_t j = 0; j < operators; ++j)
+        {
+            source += ops[random.Next(std::size(ops))];
+            source += std::to_string(random.Next(1000) + 1);
+        }
+
+        source += '\n';
+    }
+
+    return source;
+}
+
+//Deeply nested parens and prefix operators
+static std::string GenerateNestedExpressions(size_t lines, size_t depth)
+{
+    std::string source;
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        source += "NESTED_" + std::to_string(i) + " equ ";
+
+        for (size_t j = 0; j < depth; ++j)
+            source += (j % 2 == 0 ? "(" : "-(");
+
+        source += std::to_string(i);
+
+        for (size_t j = 0; j < depth; ++j)
+            source += (j % 2 == 0 ? " + 1)" : " * 2)");
+
+        source += '\n';
+    }
+
+    return source;
+}
+
+static double ParseBest(const std::string& source, size_t repeats, size_t& nodes)
+{
+    double best = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+        Lexer lexer(*context);
+        Parser parser(*context, lexer);
+
+        Bench::Timer timer;
+        AbstractSyntaxTree ast = parser.Parse();
+        const double seconds = timer.Seconds();
+
+        nodes = ast.size();
+
+        if (best == 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t lines = Bench::GetArgOr(argc, argv, 1, 10000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 3);
+    const size_t depth = Bench::GetArgOr(argc, argv, 3, 1000);
+
+    const std::string longSource = GenerateLongExpressions(lines, 64);
+    const std::string nestedSource = GenerateNestedExpressions(lines / 10 + 1, depth);
+
+    size_t longNodes = 0, nestedNodes = 0;
+
+    const double longSeconds = ParseBest(longSource, repeats, longNodes);
+    const double nestedSeconds = ParseBest(nestedSource, repeats, nestedNodes);
+
+    std::cout << longNodes << " long constants (64 operators), "
+        << nestedNodes << " nested constants (depth " << depth << ")" << std::endl;
+
+    Bench::Report("expressions/long", longSeconds, longSource.size());
+    Bench::Report("expressions/nested", nestedSeconds, nestedSource.size());
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef __BENCH_INSTRUCTION_COMBINATIONS_H
+#define __BENCH_INSTRUCTION_COMBINATIONS_H
+
+#include <string>
+#include <string_view>
+
+#include "arch/8086/arch-8086.h"
+
+namespace Bench
+{
+    //Operands of every kind that selection tells apart, `$near` is replaced by the closest lable
+    inline const char* operandSamples[] =
+    {
+        "al", "cl", "ah", "ax", "bx", "dx", "sp", "si", "eax", "es", "cs", "ds", "ss", "cr0",
+        "[bx]", "[bx+si+4]", "[bp]", "[1234h]", "byte [bx]", "word [bx+di]", "byte [10h]", "word [1234h]", "dword [bx]",
+        "0", "1", "-1", "5", "127", "128", "-128", "200", "-200", "255", "1000", "-1000", "40000", "70000",
+        "CONST", "CONST * 300", "$near", "far_lable", "far_lable + 1000"
+    };
+
+    //Every mnemonic with no operands, with each sample, and with each pair of samples
+    inline std::string GenerateInstructionCombinations()
+    {
+        constexpr size_t samplesCount = std::size(operandSamples);
+
+        std::string source = "org 100h\nCONST equ 3\nnop\nfar_lable:\n";
+        size_t lines = 0;
+        size_t lastLable = 0;
+
+        auto addLine = [&](std::string_view mnemonic, std::string operands)
+        {
+            if (lines++ % 16 == 0)
+            {
+                lastLable = lines;
+                source += "near_" + std::to_string(lastLable) + ":\n";
+            }
+
+            for (size_t position = operands.find("$near"); position != std::string::npos; position = operands.find("$near"))
+                operands.replace(position, 5, "near_" + std::to_string(lastLable));
+
+            source += "\t";
+            source += mnemonic;
+            source += " " + operands + "\n";
+        };
+
+        for (std::string_view mnemonic : ASM::Arch::MnemonicNames)
+        {
+            addLine(mnemonic, "");
+
+            for (size_t i = 0; i < samplesCount; ++i)
+            {
+                addLine(mnemonic, operandSamples[i]);
+
+                for (size_t j = 0; j < samplesCount; ++j)
+                    addLine(mnemonic, std::string(operandSamples[i]) + ", " + operandSamples[j]);
+            }
+        }
+
+        return source;
+    }
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "bench-common.h"
+#include "instruction-combinations.h"
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+
+using namespace ASM;
+using namespace ASM::AST;
+using Codegen::InstructionSelector;
+
+int main(int argc, const char** argv)
+{
+    const size_t repeats = Bench::GetArgOr(argc, argv, 1, 5);
+
+    const std::string source = Bench::GenerateInstructionCombinations();
+
+    //Most combinations are invalid, messages aren't interesting
+    std::ostringstream log;
+
+    auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+    context->SetLogOutput(log);
+
+    Lexer lexer(*context);
+    Parser parser(*context, lexer);
+    AbstractSyntaxTree ast = parser.Parse();
+
+    Codegen::CodeGenerator codeGenerator(*context);
+    codeGenerator.ProccessAST(ast);
+
+    std::vector<InstructionStmt*> statements;
+
+    for (Node* node : ast)
+        if (node->Is<InstructionStmt>())
+            statements.push_back(node->GetAs<InstructionStmt>());
+
+    double bestLookup = 0;
+    double bestScoring = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        Bench::Timer lookupTimer;
+
+        for (InstructionStmt* stmt : statements)
+            codeGenerator.ChooseInstructionByOperands(stmt->GetMnemonic(), stmt->GetOperands(), stmt->GetSectionStmtOffset());
+
+        const double lookupSeconds = lookupTimer.Seconds();
+
+        //Selection before the tables, evaluating the operands and scoring every form
+        Bench::Timer scoringTimer;
+
+        for (InstructionStmt* stmt : statements)
+        {
+            auto evaluations = codeGenerator.EvaluateOperands(stmt->GetOperands());
+
+            InstructionSelector::SelectByScoring(stmt->GetForms(), std::span(evaluations.data(), evaluations.size()), stmt->GetSectionStmtOffset());
+        }
+
+        const double scoringSeconds = scoringTimer.Seconds();
+
+        if (bestLookup == 0 || lookupSeconds < bestLookup)
+            bestLookup = lookupSeconds;
+        if (bestScoring == 0 || scoringSeconds < bestScoring)
+            bestScoring = scoringSeconds;
+    }
+
+    std::cout << statements.size() << " statements" << std::endl;
+
+    Bench::Report("selection/lookup", bestLookup, source.size());
+    Bench::Report("selection/scoring", bestScoring, source.size());
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "bench-common.h"
+
+#include "syntax/lexer.h"
+#include "syntax/scanner.h"
+
+using namespace ASM;
+
+static size_t LexAll(AssemblyContext& context)
+{
+    Lexer lexer(context);
+    Token token;
+    size_t count = 0;
+
+    while (lexer.GetNextToken(token) || token.Is(TokKind::eof) == false)
+        ++count;
+
+    return count;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t lines = Bench::GetArgOr(argc, argv, 1, 2000000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 3);
+
+    AssemblyContext context(Bench::GenerateSource(lines), Arch::Arch8086::InstructionSet);
+
+    std::cout << "Lexing " << lines << " lines (" << context.GetSource().size() / (1024 * 1024) << " MB)" << std::endl;
+
+    const std::pair<Scanner::Implementation, const char*> implementations[] =
+    {
+        { Scanner::Implementation::Scalar, "scalar" },
+        { Scanner::Implementation::SSE2,   "sse2" },
+        { Scanner::Implementation::AVX2,   "avx2" }
+    };
+
+    for (auto& [implementation, name] : implementations)
+    {
+        if (Scanner::SetImplementation(implementation) == false)
+        {
+            std::cout << name << ": not supported" << std::endl;
+            continue;
+        }
+
+        double best = 0;
+        size_t tokens = 0;
+
+        for (size_t i = 0; i < repeats; ++i)
+        {
+            Bench::Timer timer;
+            tokens = LexAll(context);
+
+            const double seconds = timer.Seconds();
+
+            if (best == 0 || seconds < best)
+                best = seconds;
+        }
+
+        Bench::Report(std::string("lexer/") + name + " (" + std::to_string(tokens) + " tokens)", best, context.GetSource().size());
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "bench-common.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "cli/cli-handler.h"
+
+using namespace ASM;
+
+//Builds all files with one invocation of the command line handler, returns false if any build failed
+static bool Build(const std::vector<std::string>& files, size_t jobs)
+{
+    std::vector<std::string> args = { "wh-asm", "-j", std::to_string(jobs) };
+
+    for (auto& file : files)
+    {
+        args.push_back("-i");
+        args.push_back(file);
+    }
+
+    std::vector<const char*> argv;
+
+    for (auto& arg : args)
+        argv.push_back(arg.c_str());
+
+    //Messages for generated sources aren't interesting
+    std::ostringstream log;
+    std::streambuf* coutBuffer = std::cout.rdbuf(log.rdbuf());
+
+    CLI::CommandLineInterfaceHandler handler(argv.size(), argv.data());
+    const bool result = handler.Handle();
+
+    std::cout.rdbuf(coutBuffer);
+
+    return result;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t filesCount = Bench::GetArgOr(argc, argv, 1, 64);
+    const size_t lines = Bench::GetArgOr(argc, argv, 2, 5000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 3, 3);
+    const size_t workers = Bench::GetArgOr(argc, argv, 4, std::thread::hardware_concurrency());
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "wh-asm-multi-file";
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::string> files;
+    size_t sourceSize = 0;
+
+    for (size_t i = 0; i < filesCount; ++i)
+    {
+        const std::string source = Bench::GenerateValidSource(lines, i + 1);
+        const std::filesystem::path file = directory / ("file-" + std::to_string(i) + ".asm");
+
+        std::ofstream(file, std::ios::binary) << source;
+
+        files.push_back(file.string());
+        sourceSize += source.size();
+    }
+
+    std::cout << "Building " << filesCount << " files of " << lines << " lines (" << sourceSize / (1024 * 1024) << " MB), "
+        << std::thread::hardware_concurrency() << " hardware threads, " << workers << " jobs" << std::endl;
+
+    double bestSerial = 0;
+    double bestParallel = 0;
+    bool isSucceeded = true;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        Bench::Timer serialTimer;
+        isSucceeded &= Build(files, 1);
+
+        const double serialSeconds = serialTimer.Seconds();
+
+        Bench::Timer parallelTimer;
+        isSucceeded &= Build(files, workers);
+
+        const double parallelSeconds = parallelTimer.Seconds();
+
+        if (bestSerial == 0 || serialSeconds < bestSerial)
+            bestSerial = serialSeconds;
+        if (bestParallel == 0 || parallelSeconds < bestParallel)
+            bestParallel = parallelSeconds;
+    }
+
+    std::filesystem::remove_all(directory);
+
+    std::cout << (isSucceeded ? "All files are built" : "Some files failed to build") << std::endl;
+
+    Bench::Report("multi-file/serial", bestSerial, sourceSize);
+    Bench::Report("multi-file/parallel", bestParallel, sourceSize);
+
+    return (isSucceeded ? 0 : 1);
+}
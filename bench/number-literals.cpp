@@ -0,0 +1,104 @@
+#include "bench-common.h"
+
+#include "syntax/lexer.h"
+
+using namespace ASM;
+
+//Data tables in the style of lookup tables and bitmaps, mostly hexadecimal constants
+static std::string GenerateDataTables(size_t lines, uint64_t seed = 1)
+{
+    static const char* directives[] = { "db", "dw", "dd" };
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    Bench::Random random(seed);
+    std::string source;
+
+    source.reserve(lines * 64);
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        const uint64_t kind = random.Next(100);
+
+        source += "    ";
+        source += directives[random.Next(std::size(directives))];
+        source += ' ';
+
+        for (unsigned int j = 0; j < 8; ++j)
+        {
+            if (j > 0)
+                source += ", ";
+
+            if (kind < 50)
+            {
+                source += "0x";
+                for (unsigned int k = 0; k < 4; ++k)
+                    source += hexDigits[random.Next(16)];
+            }
+            else if (kind < 80)
+            {
+                source += '0';
+                for (unsigned int k = 0; k < 4; ++k)
+                    source += hexDigits[random.Next(16)];
+                source += 'h';
+            }
+            else if (kind < 90)
+            {
+                for (unsigned int k = 0; k < 8; ++k)
+                    source += static_cast<char>('0' + random.Next(2));
+                source += 'b';
+            }
+            else
+            {
+                source += std::to_string(random.Next(65536));
+            }
+        }
+
+        source += '\n';
+    }
+
+    return source;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t lines = Bench::GetArgOr(argc, argv, 1, 500000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 3);
+
+    AssemblyContext context(GenerateDataTables(lines), Arch::Arch8086::InstructionSet);
+
+    std::cout << "Lexing " << lines << " data table lines (" << context.GetSource().size() / (1024 * 1024) << " MB)" << std::endl;
+
+    double best = 0;
+    size_t numbers = 0;
+    int64_t checksum = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        Lexer lexer(context);
+        Token token;
+
+        numbers = 0;
+        checksum = 0;
+
+        Bench::Timer timer;
+
+        while (lexer.GetNextToken(token) || token.Is(TokKind::eof) == false)
+        {
+            if (token.Is(TokKind::num_constant))
+            {
+                checksum += token.GetNum();
+                ++numbers;
+            }
+        }
+
+        const double seconds = timer.Seconds();
+
+        if (best == 0 || seconds < best)
+            best = seconds;
+    }
+
+    Bench::Report("lexer/numbers (" + std::to_string(numbers) + " constants)", best, context.GetSource().size());
+    std::cout << "checksum " << checksum << std::endl;
+
+    return 0;
+}
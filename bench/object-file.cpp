@@ -0,0 +1,152 @@
+#include "bench-common.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+#include "linking/linker.h"
+#include "linking/object-file.h"
+
+using namespace ASM;
+
+//Data tables with two relocations on every line, values are masked so they fit a signed word at any size
+static std::string GenerateRelocations(size_t relocations)
+{
+    Bench::Random random(11);
+    std::string source = "org 100h\nMASK equ 7FFFh\n";
+
+    const size_t lines = relocations / 2;
+
+    source.reserve(lines * 48);
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        if (i % 16 == 0)
+            source += "entry_" + std::to_string(i / 16) + ":\n";
+
+        const size_t lable = i / 16;
+
+        source += "\tdw (entry_" + std::to_string(random.Next(lable + 1)) + " + " + std::to_string(random.Next(64)) + ") & MASK, "
+            "(entry_" + std::to_string(lable) + " - entry_" + std::to_string(random.Next(lable + 1)) + ") & MASK\n";
+    }
+
+    return source;
+}
+
+static std::string GetBytes(const AssembledObject& object)
+{
+    std::ostringstream out;
+    object.Serialize(out);
+
+    return std::move(out).str();
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t relocations = Bench::GetArgOr(argc, argv, 1, 1000000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 5);
+
+    const std::string source = GenerateRelocations(relocations);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "wh-asm-bench.obj";
+
+    //Messages for generated source aren't interesting
+    std::ostringstream log;
+
+    auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+    context->SetLogOutput(log);
+
+    Lexer lexer(*context);
+    Parser parser(*context, lexer);
+    AbstractSyntaxTree ast = parser.Parse();
+
+    Codegen::CodeGenerator codeGenerator(*context);
+    TranslationUnit& unit = codeGenerator.ProccessAST(ast);
+
+    size_t targets = 0;
+
+    for (auto& pair : unit.GetSectionMap())
+        targets += pair.second.GetLinkingTargets().size();
+
+    double bestSerialize = 0;
+    double bestMapped = 0;
+    double bestStream = 0;
+    double bestContextLink = 0;
+    double bestObjectLink = 0;
+    std::string serialized;
+    std::string contextOutput;
+    std::string objectOutput;
+    bool isLoaded = true;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        std::ostringstream out;
+
+        Bench::Timer serializeTimer;
+        ObjectFile(*context).Serialize(out);
+        const double serializeSeconds = serializeTimer.Seconds();
+
+        serialized = std::move(out).str();
+        std::ofstream(path, std::ios::binary).write(serialized.data(), serialized.size());
+
+        //Mapped file is checked and used in place, the stream is read into memory first
+        ObjectFile mapped;
+
+        Bench::Timer mappedTimer;
+        isLoaded &= mapped.Open(path.string());
+        const double mappedSeconds = mappedTimer.Seconds();
+
+        ObjectFile streamed;
+        std::ifstream in(path, std::ios::binary);
+
+        Bench::Timer streamTimer;
+        isLoaded &= streamed.Deserialize(in);
+        const double streamSeconds = streamTimer.Seconds();
+
+        Linker contextLinker(*context);
+
+        Bench::Timer contextLinkTimer;
+        auto contextLinked = contextLinker.Link(LinkingFormat::RawBinary);
+        const double contextLinkSeconds = contextLinkTimer.Seconds();
+
+        AssemblyContext messages(std::string(), Arch::Arch8086::InstructionSet);
+        messages.SetLogOutput(log);
+        Linker objectLinker(messages);
+
+        Bench::Timer objectLinkTimer;
+        auto objectLinked = objectLinker.Link(mapped, LinkingFormat::RawBinary);
+        const double objectLinkSeconds = objectLinkTimer.Seconds();
+
+        contextOutput = GetBytes(*contextLinked);
+        objectOutput = GetBytes(*objectLinked);
+
+        if (bestSerialize == 0 || serializeSeconds < bestSerialize)
+            bestSerialize = serializeSeconds;
+        if (bestMapped == 0 || mappedSeconds < bestMapped)
+            bestMapped = mappedSeconds;
+        if (bestStream == 0 || streamSeconds < bestStream)
+            bestStream = streamSeconds;
+        if (bestContextLink == 0 || contextLinkSeconds < bestContextLink)
+            bestContextLink = contextLinkSeconds;
+        if (bestObjectLink == 0 || objectLinkSeconds < bestObjectLink)
+            bestObjectLink = objectLinkSeconds;
+    }
+
+    std::filesystem::remove(path);
+
+    const bool isIdentical = (isLoaded && contextOutput == objectOutput);
+
+    std::cout << targets << " relocations, object " << serialized.size() / 1024 << " KB, "
+        << (isIdentical ? "linked object is identical" : "linked object differs") << std::endl;
+
+    Bench::Report("object/serialize", bestSerialize, serialized.size());
+    Bench::Report("object/load-mapped", bestMapped, serialized.size());
+    Bench::Report("object/load-stream", bestStream, serialized.size());
+    Bench::Report("link/context", bestContextLink, serialized.size());
+    Bench::Report("link/object", bestObjectLink, serialized.size());
+
+    return (isIdentical ? 0 : 1);
+}
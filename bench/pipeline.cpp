@@ -0,0 +1,64 @@
+#include "bench-common.h"
+
+#include <thread>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+
+using namespace ASM;
+
+//Lexes and parses whole source, returns count of top level nodes
+static size_t LexAndParse(const std::string& source, AssemblyMode mode, size_t workers)
+{
+    AssemblyContext context(source, Arch::Arch8086::InstructionSet);
+
+    if (mode == AssemblyMode::Parallel)
+        context.SetParallelMode();
+    else if (mode == AssemblyMode::Chunked)
+        context.SetChunkedMode(workers);
+
+    Lexer lexer(context);
+    Parser parser(context, lexer);
+
+    return parser.Parse().size();
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t lines = Bench::GetArgOr(argc, argv, 1, 1000000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 3);
+    const size_t workers = Bench::GetArgOr(argc, argv, 3, std::thread::hardware_concurrency());
+
+    const std::string source = Bench::GenerateSource(lines);
+
+    std::cout << "Lexing and parsing " << lines << " lines (" << source.size() / (1024 * 1024) << " MB), "
+        << std::thread::hardware_concurrency() << " hardware threads, " << workers << " chunked workers" << std::endl;
+
+    const std::pair<AssemblyMode, const char*> modes[] =
+    {
+        { AssemblyMode::Direct,   "direct" },
+        { AssemblyMode::Parallel, "parallel" },
+        { AssemblyMode::Chunked,  "chunked" }
+    };
+
+    for (auto& [mode, name] : modes)
+    {
+        double best = 0;
+        size_t nodes = 0;
+
+        for (size_t i = 0; i < repeats; ++i)
+        {
+            Bench::Timer timer;
+            nodes = LexAndParse(source, mode, workers);
+
+            const double seconds = timer.Seconds();
+
+            if (best == 0 || seconds < best)
+                best = seconds;
+        }
+
+        Bench::Report(std::string("pipeline/") + name + " (" + std::to_string(nodes) + " nodes)", best, source.size());
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "bench-common.h"
+
+#include <memory>
+#include <sstream>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+#include "linking/linker.h"
+
+using namespace ASM;
+
+//Jump and pointer tables, every entry is resolved by the linker
+static std::string GenerateTables(size_t labels)
+{
+    Bench::Random random(7);
+    std::string source = "org 100h\n";
+
+    for (size_t i = 0; i < labels; ++i)
+    {
+        source += "entry_" + std::to_string(i) + ":\n";
+        source += "\tmov bx, entry_" + std::to_string(random.Next(labels)) + " + 2\n";
+        source += "\tjmp entry_" + std::to_string(random.Next(labels)) + "\n";
+    }
+
+    source += "jump_table:\n";
+
+    for (size_t i = 0; i < labels; ++i)
+        source += "\tdw entry_" + std::to_string(i) + ", entry_" + std::to_string(random.Next(labels)) + " - jump_table\n";
+
+    source += "pointer_table:\n";
+
+    for (size_t i = 0; i < labels; ++i)
+        source += "\tdw jump_table + " + std::to_string(i * 4) + ", (pointer_table + " + std::to_string(i) + " * 2) & 0FFFFh\n";
+
+    return source;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t labels = Bench::GetArgOr(argc, argv, 1, 2000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 2, 20);
+
+    const std::string source = GenerateTables(labels);
+
+    //Messages for generated source aren't interesting
+    std::ostringstream log;
+
+    double best = 0;
+    size_t targets = 0;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+        context->SetLogOutput(log);
+
+        Lexer lexer(*context);
+        Parser parser(*context, lexer);
+        AbstractSyntaxTree ast = parser.Parse();
+
+        Codegen::CodeGenerator codeGenerator(*context);
+        TranslationUnit& unit = codeGenerator.ProccessAST(ast);
+
+        targets = 0;
+
+        for (auto& pair : unit.GetSectionMap())
+            targets += pair.second.GetLinkingTargets().size();
+
+        Linker linker(*context);
+
+        Bench::Timer timer;
+        auto object = linker.Link(LinkingFormat::RawBinary);
+        const double seconds = timer.Seconds();
+
+        if (best == 0 || seconds < best)
+            best = seconds;
+
+        log.str("");
+    }
+
+    std::cout << "Linking " << targets << " targets of " << labels << " labels" << std::endl;
+
+    Bench::Report("relocations", best, source.size());
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "bench-common.h"
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+
+using namespace ASM;
+
+//Generated lines split into sections, each one jumps to the start of the next.
+//Aligns and references to the section start are placed between blocks of lines, so positions in
+//the middle of a section matter.
+static std::string GenerateSections(size_t sections, size_t lines)
+{
+    constexpr size_t alignLines = 997;
+
+    const std::string body = Bench::GenerateSource(sections * lines);
+    std::string source;
+    size_t line = 0;
+
+    source.reserve(body.size() + sections * 64);
+
+    for (size_t begin = 0, end = body.find('\n'); end != std::string::npos; begin = end + 1, end = body.find('\n', begin))
+    {
+        if (line % lines == 0 && line / lines < sections)
+        {
+            const size_t section = line / lines;
+
+            source += "section s" + std::to_string(section) + "\n";
+            source += "start_" + std::to_string(section) + ":\n";
+            source += "\tjmp start_" + std::to_string((section + 1) % sections) + "\n";
+        }
+
+        if (line % alignLines == alignLines - 1)
+        {
+            const std::string start = "start_" + std::to_string(std::min(line / lines, sections - 1));
+
+            source += "align 16\n";
+            source += "\tcall " + start + "\n\tdw " + start + "\n";
+        }
+
+        source.append(body, begin, end - begin + 1);
+        ++line;
+    }
+
+    return source;
+}
+
+struct Generated
+{
+    //Code and linking target offsets of sections by name, so both runs are compared in the same order
+    std::map<std::string, std::pair<std::string, std::vector<std::pair<uint64_t, uint64_t>>>> sections;
+    std::vector<std::pair<int64_t, bool>> lables;
+    double seconds = 0;
+};
+
+static Generated Generate(const std::string& source, size_t workers)
+{
+    //Messages for generated source aren't interesting
+    std::ostringstream log;
+
+    auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+    context->SetLogOutput(log);
+    context->SetParallelCodegen(workers);
+
+    Lexer lexer(*context);
+    Parser parser(*context, lexer);
+    AbstractSyntaxTree ast = parser.Parse();
+
+    Codegen::CodeGenerator codeGenerator(*context);
+
+    Bench::Timer timer;
+    TranslationUnit& unit = codeGenerator.ProccessAST(ast);
+
+    Generated result;
+    result.seconds = timer.Seconds();
+
+    for (auto& [name, section] : unit.GetSectionMap())
+    {
+        auto& code = section.GetCode().code;
+
+        auto& [resultCode, resultTargets] = result.sections[name];
+
+        resultCode.assign(code.begin(), code.end());
+
+        for (auto& target : section.GetLinkingTargets())
+            resultTargets.emplace_back(target.GetSectionOffset(), target.GetRelativeOrigin());
+    }
+
+    for (SymbolId id : context->GetSymbolTable().GetSymbolIds())
+    {
+        const Symbol& symbol = context->GetSymbolTable().GetSymbol(id);
+
+        if (symbol.GetDeclaration().Is<AST::LableDecl>())
+            result.lables.emplace_back(symbol.GetValue().GetAsInt(), symbol.IsEvaluated());
+    }
+
+    return result;
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t sections = Bench::GetArgOr(argc, argv, 1, 8);
+    const size_t lines = Bench::GetArgOr(argc, argv, 2, 100000);
+    const size_t repeats = Bench::GetArgOr(argc, argv, 3, 3);
+    const size_t workers = Bench::GetArgOr(argc, argv, 4, std::thread::hardware_concurrency());
+
+    const std::string source = GenerateSections(sections, lines);
+
+    std::cout << "Generating " << sections << " sections of " << lines << " lines (" << source.size() / (1024 * 1024) << " MB), "
+        << std::thread::hardware_concurrency() << " hardware threads, " << workers << " codegen workers" << std::endl;
+
+    double bestSerial = 0;
+    double bestParallel = 0;
+    bool isIdentical = true;
+
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        Generated serial = Generate(source, 1);
+        Generated parallel = Generate(source, workers);
+
+        isIdentical &= (serial.sections == parallel.sections && serial.lables == parallel.lables);
+
+        if (bestSerial == 0 || serial.seconds < bestSerial)
+            bestSerial = serial.seconds;
+        if (bestParallel == 0 || parallel.seconds < bestParallel)
+            bestParallel = parallel.seconds;
+    }
+
+    std::cout << (isIdentical ? "Parallel output is identical" : "Parallel output differs") << std::endl;
+
+    Bench::Report("sections/serial", bestSerial, source.size());
+    Bench::Report("sections/parallel", bestParallel, source.size());
+
+    return (isIdentical ? 0 : 1);
+}
@@ -0,0 +1,222 @@
+#include "bench-common.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+#include "linking/linker.h"
+
+using namespace ASM;
+using namespace ASM::AST;
+
+//Building from forced chunks must give the same AST, names, messages and output as a serial build
+static constexpr size_t chunksCount = 4;
+
+struct BuildResult
+{
+    std::vector<NodeKind> kinds;
+    std::vector<size_t> offsets;
+    //Declared names and symbols of every expression, in AST order
+    std::vector<std::string> names;
+    std::vector<std::string> messages;
+    //Linked program, empty if there are errors
+    std::string output;
+};
+
+//Cached dependencies, ids are interned in a different order by chunks, so sorted names are compared
+static void AddDependencies(BuildResult& result, const StringInterner& interner, const Expression* expression)
+{
+    std::vector<std::string> names;
+
+    for (SymbolId id : expression->GetDependencies())
+        names.push_back(interner.Get(id));
+
+    std::sort(names.begin(), names.end());
+
+    std::string joined;
+
+    for (const std::string& name : names)
+        joined += name + ' ';
+
+    result.names.push_back(std::move(joined));
+}
+
+static void AddNames(BuildResult& result, const StringInterner& interner, Node* node)
+{
+    if (node->Is<NamedDecl>())
+        result.names.push_back(node->GetAs<NamedDecl>()->GetName());
+
+    if (node->Is<ConstantDecl>())
+    {
+        AddDependencies(result, interner, &node->GetAs<ConstantDecl>()->GetExpression());
+    }
+    else if (node->Is<InstructionStmt>())
+    {
+        for (Expression* operand : node->GetAs<InstructionStmt>()->GetOperands())
+            AddDependencies(result, interner, operand);
+    }
+    else if (node->Is<DefineDataStmt>())
+    {
+        for (Expression* unit : node->GetAs<DefineDataStmt>()->GetUnits())
+            AddDependencies(result, interner, unit);
+    }
+    else if (node->Is<ParametricStmt>() && node->GetAs<ParametricStmt>()->GetValueExpression() != nullptr)
+    {
+        AddDependencies(result, interner, node->GetAs<ParametricStmt>()->GetValueExpression());
+    }
+}
+
+static BuildResult Build(const std::string& source, bool isChunked)
+{
+    std::ostringstream log;
+
+    auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+    context->SetLogOutput(log);
+
+    if (isChunked)
+        context->SetChunkedMode(chunksCount);
+
+    Lexer lexer(*context);
+    Parser parser(*context, lexer);
+    AbstractSyntaxTree ast = parser.Parse();
+
+    BuildResult result;
+
+    for (Node* node : ast)
+    {
+        result.kinds.push_back(node->GetKind());
+
+        if (node->Is<SectionDecl>())
+            result.offsets.push_back(node->GetAs<SectionDecl>()->GetMaxCodeSize());
+        else if (node->Is<LableDecl>())
+            result.offsets.push_back(node->GetAs<LableDecl>()->GetSectionStmtOffset());
+        else if (node->Is<InstructionStmt>())
+            result.offsets.push_back(node->GetAs<InstructionStmt>()->GetSectionStmtOffset());
+
+        AddNames(result, context->GetInterner(), node);
+    }
+
+    if (context->GetErrorsCount() == 0)
+    {
+        Codegen::CodeGenerator codeGenerator(*context);
+        codeGenerator.ProccessAST(ast);
+
+        Linker linker(*context);
+        auto linked = linker.Link(LinkingFormat::RawBinary);
+
+        std::ostringstream out;
+
+        if (context->GetErrorsCount() == 0 && linked->Serialize(out))
+            result.output = std::move(out).str();
+    }
+
+    //Chunks report in any order, so messages are compared as a set
+    std::istringstream lines(log.str());
+
+    for (std::string line; std::getline(lines, line);)
+        result.messages.push_back(line);
+
+    std::sort(result.messages.begin(), result.messages.end());
+
+    return result;
+}
+
+//Local lables with jumps, operands, data and constants referring to them. Parent lables are far apart,
+//so every chunk starts with locals of a parent declared by a preceding chunk.
+static std::string GenerateLocals(size_t lines, size_t parentLines)
+{
+    Bench::Random random(7);
+    //Jumps to offset 0 are taken as unknown and get the short form, so nothing is placed there
+    std::string source = "org 100h\nnop\n";
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        const size_t parent = i / parentLines * parentLines;
+        const size_t nextParent = std::min(parent + parentLines, lines);
+
+        if (i == parent)
+            source += "parent_" + std::to_string(i) + ":\n";
+
+        //Targets are locals of the same parent, before or after the line
+        const std::string first = ".l" + std::to_string(parent + random.Next(nextParent - parent));
+        const std::string second = ".l" + std::to_string(parent + random.Next(nextParent - parent));
+
+        switch (random.Next(5))
+        {
+        case 0:
+            source += ".l" + std::to_string(i) + ": jmp " + first + "\n";
+            break;
+        case 1:
+            source += ".l" + std::to_string(i) + ": mov ax, " + first + " + 2\n";
+            break;
+        case 2:
+            source += ".l" + std::to_string(i) + ": dw " + first + " - " + second + "\n";
+            break;
+        case 3:
+            source += ".l" + std::to_string(i) + ":\nCONST_" + std::to_string(i) + " equ " + first + " - " + second + "\n";
+            break;
+        default:
+            source += ".l" + std::to_string(i) + ": add ax, " + std::to_string(i % 100) + "\n";
+            break;
+        }
+    }
+
+    return source;
+}
+
+//Replaces the first line of every chunk, keeping the size, so the chunks are split at the same places
+static std::string BreakChunkStarts(std::string source, const char* badLine)
+{
+    for (size_t i = 1; i < chunksCount; ++i)
+    {
+        const size_t begin = source.find('\n', source.size() * i / chunksCount) + 1;
+        const size_t end = source.find('\n', begin);
+        std::string line = std::string(badLine) + " ;";
+
+        line.resize(std::max(line.size(), end - begin), ' ');
+        source.replace(begin, end - begin, line);
+    }
+
+    return source;
+}
+
+static bool Check(const char* name, const std::string& source)
+{
+    const BuildResult serial = Build(source, false);
+    const BuildResult chunked = Build(source, true);
+
+    const bool isSame = (serial.kinds == chunked.kinds && serial.offsets == chunked.offsets && serial.names == chunked.names &&
+        serial.messages == chunked.messages && serial.output == chunked.output);
+
+    std::cout << (isSame ? "ok      " : "FAILED  ") << name << ": " << serial.kinds.size() << " nodes, "
+        << serial.messages.size() << " messages, " << serial.output.size() << " bytes" << std::endl;
+
+    return isSame;
+}
+
+int main()
+{
+    //Large enough for every chunk to get a thread
+    const std::string source = Bench::GenerateSource(8000);
+    const std::string locals = GenerateLocals(8000, 3000);
+
+    std::string bogus;
+
+    for (size_t i = 0; i < 20000; ++i)
+        bogus += "bogus" + std::to_string(i) + "\n";
+
+    bool isPassed = true;
+
+    isPassed &= Check("generated source", source);
+    isPassed &= Check("local lables at chunk start, parents in preceding chunks", locals);
+    //Unknown identifier isn't pushed, failed instruction is pushed and popped
+    isPassed &= Check("unknown identifier at chunk start", BreakChunkStarts(source, "bogus"));
+    isPassed &= Check("bad instruction at chunk start", BreakChunkStarts(source, "mov [bx, ax"));
+    isPassed &= Check("only unknown identifiers", bogus);
+
+    return (isPassed ? 0 : 1);
+}
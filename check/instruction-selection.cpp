@@ -0,0 +1,116 @@
+#include "bench-common.h"
+#include "instruction-combinations.h"
+
+#include <memory>
+#include <sstream>
+
+#include "syntax/lexer.h"
+#include "syntax/parser.h"
+#include "codegen/code-generator.h"
+
+using namespace ASM;
+using namespace ASM::AST;
+using Codegen::InstructionSelector;
+
+//Table lookups must choose the same forms as scoring every form, which is how the tables are filled
+static const Arch::Instruction* SelectByScoring(const Codegen::CodeGenerator& codeGenerator, InstructionStmt& stmt)
+{
+    auto evaluations = codeGenerator.EvaluateOperands(stmt.GetOperands());
+
+    return InstructionSelector::SelectByScoring(stmt.GetForms(), std::span(evaluations.data(), evaluations.size()), stmt.GetSectionStmtOffset());
+}
+
+//Compares every entry of the tables with scoring of the forms, after all of them are filled
+static size_t CheckTables()
+{
+    size_t mismatches = 0;
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t mnemonicIndex = 0; mnemonicIndex < Arch::MnemonicsCount; ++mnemonicIndex)
+        {
+            const auto mnemonic = static_cast<Arch::Mnemonic>(mnemonicIndex);
+            const auto& forms = Arch::Arch8086::InstructionSet.at(mnemonic);
+
+            auto check = [&](std::span<const InstructionSelector::OperandClass> classes)
+            {
+                const Arch::Instruction* selected = InstructionSelector::Select(mnemonic, classes);
+
+                if (pass == 0)
+                    return;
+
+                SmallVector<Arch::OperandEvaluation, 4> evaluations(classes.size());
+
+                for (size_t i = 0; i < classes.size(); ++i)
+                    InstructionSelector::MakeEvaluation(classes[i], evaluations[i]);
+
+                if (selected != InstructionSelector::SelectByScoring(forms, std::span(evaluations.data(), evaluations.size()), 0))
+                    ++mismatches;
+            };
+
+            check({});
+
+            for (size_t i = 0; i < InstructionSelector::classesCount; ++i)
+            {
+                const InstructionSelector::OperandClass single[] = { static_cast<uint8_t>(i) };
+                check(single);
+
+                for (size_t j = 0; j < InstructionSelector::classesCount; ++j)
+                {
+                    const InstructionSelector::OperandClass pair[] = { static_cast<uint8_t>(i), static_cast<uint8_t>(j) };
+                    check(pair);
+                }
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+int main()
+{
+    const std::string source = Bench::GenerateInstructionCombinations();
+
+    //Most combinations are invalid, messages aren't interesting
+    std::ostringstream log;
+
+    auto context = std::make_unique<AssemblyContext>(source, Arch::Arch8086::InstructionSet);
+    context->SetLogOutput(log);
+
+    Lexer lexer(*context);
+    Parser parser(*context, lexer);
+    AbstractSyntaxTree ast = parser.Parse();
+
+    Codegen::CodeGenerator codeGenerator(*context);
+    codeGenerator.ProccessAST(ast);
+
+    size_t statements = 0;
+    size_t selected = 0;
+    size_t mismatches = 0;
+
+    for (Node* node : ast)
+    {
+        if (node->Is<InstructionStmt>() == false)
+            continue;
+
+        InstructionStmt& stmt = *node->GetAs<InstructionStmt>();
+        const Arch::Instruction* lookup = codeGenerator.ChooseInstructionByOperands(stmt.GetMnemonic(), stmt.GetOperands(), stmt.GetSectionStmtOffset());
+
+        if (lookup != SelectByScoring(codeGenerator, stmt))
+        {
+            std::cout << "Mismatch: " << std::string_view(stmt.GetLocation().sourcePointer, stmt.GetLength()) << std::endl;
+            ++mismatches;
+        }
+
+        ++statements;
+        selected += (lookup != nullptr);
+    }
+
+    const size_t tableMismatches = CheckTables();
+    const bool isPassed = (mismatches == 0 && tableMismatches == 0);
+
+    std::cout << (isPassed ? "ok      " : "FAILED  ") << statements << " statements, " << selected << " with a form, "
+        << mismatches << " mismatches, " << tableMismatches << " table mismatches" << std::endl;
+
+    return (isPassed ? 0 : 1);
+}
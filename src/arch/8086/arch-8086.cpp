@@ -1,8 +1,10 @@
 #include "arch-8086.h"
 
+#include "utils/content-hash.h"
+
 using namespace ASM::Arch;
 
-const std::unordered_map<std::string, std::vector<Instruction>> Arch8086::InstructionSet = 
+static const std::unordered_map<std::string, InstructionTable::Forms_t> InstructionSetByName =
 {
     { "AAA", {{{0x37}, OpEn::ZO, {}}} },
     {
@@ -575,28 +577,35 @@ const std::unordered_map<std::string, std::vector<Instruction>> Arch8086::Instru
     }
 };
 
-const std::unordered_map<std::string, uint8_t> Arch8086::DefineDataMnemonics = 
+InstructionTable::InstructionTable(const std::unordered_map<std::string, Forms_t>& formsByName)
 {
-    {"DB", 1}, {"DW", 2}, {"DD", 4}, {"DQ", 8}, {"DT", 10},
-};
+    assert(formsByName.size() == MnemonicsCount);
 
-const std::unordered_map<std::string, uint8_t> Arch8086::ReserveDataMnemonics = 
-{
-    {"RESB", 1}, {"RESW", 2}, {"RESD", 4}, {"RESQ", 8}, {"REST", 10},
-};
+    ContentHash hash;
 
-const std::unordered_map<std::vector<RegisterIdentifier>, RM> Arch8086::RmRegsCombinations =
-{
-    {{RegisterIdentifier::BX, RegisterIdentifier::SI}, RM::BX_SI },
-    {{RegisterIdentifier::BX, RegisterIdentifier::DI}, RM::BX_DI },
-    {{RegisterIdentifier::BP, RegisterIdentifier::SI}, RM::BP_SI },
-    {{RegisterIdentifier::BP, RegisterIdentifier::DI}, RM::BP_DI },
-    {{RegisterIdentifier::SI}, RM::SI },
-    {{RegisterIdentifier::DI}, RM::DI },
-    {{RegisterIdentifier::BP}, RM::BP },
-    {{RegisterIdentifier::BX}, RM::BX },
-    {{}, RM::DISP_16}
-};
+    for (size_t i = 0; i < MnemonicsCount; ++i)
+    {
+        forms[i] = &formsByName.at(std::string(MnemonicNames[i]));
+        maxByteSizes[i] = 1;
+
+        hash.Update(MnemonicNames[i]);
+
+        for (auto& instruction : *forms[i])
+        {
+            maxByteSizes[i] = std::max<uint8_t>(maxByteSizes[i], instruction.GetMaxByteSize());
+
+            hash.Update(instruction.opcode.data(), instruction.opcode.size());
+            hash.Update(instruction.opcodeExtention).Update(instruction.feature).Update(instruction.opencode);
+
+            for (auto& operand : instruction.operands)
+                hash.Update(operand.type).Update(operand.size);
+        }
+    }
+
+    version = hash.GetLow();
+}
+
+const InstructionTable Arch8086::InstructionSet(InstructionSetByName);
 
 const std::unordered_map<RegisterIdentifier, InstructionPrefix> Arch8086::SregToSegOverride =
 {
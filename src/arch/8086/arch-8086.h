@@ -1,23 +1,73 @@
 #ifndef __ASM_ARCH_8086_H
 #define __ASM_ARCH_8086_H
 
+#include <array>
 #include <unordered_map>
 
 #include "instruction.h"
+#include "mnemonics.h"
 
 namespace ASM::Arch
 {
+    //Instruction forms indexed by mnemonic, refers to forms stored in the map it was built from
+    class InstructionTable
+    {
+    public:
+        using Forms_t = std::vector<Instruction>;
+    private:
+        std::array<const Forms_t*, MnemonicsCount> forms{};
+        //Largest encoding among all forms of a mnemonic, computed once on construction
+        std::array<uint8_t, MnemonicsCount> maxByteSizes{};
+        //Hash of all forms, changes whenever any form does
+        uint64_t version = 0;
+    public:
+        InstructionTable(const std::unordered_map<std::string, Forms_t>& formsByName);
+
+        inline const Forms_t& at(Mnemonic mnemonic) const { return *forms[static_cast<size_t>(mnemonic)]; }
+        inline uint8_t GetMaxByteSize(Mnemonic mnemonic) const { return maxByteSizes[static_cast<size_t>(mnemonic)]; }
+        inline uint64_t GetVersion() const { return version; }
+    };
+
+    //Bits of base and index registers allowed in 16-bit addressing, other registers have none
+    constexpr uint8_t GetRmRegBit(RegisterIdentifier reg)
+    {
+        switch (reg)
+        {
+        case RegisterIdentifier::BX: return 1 << 0;
+        case RegisterIdentifier::BP: return 1 << 1;
+        case RegisterIdentifier::SI: return 1 << 2;
+        case RegisterIdentifier::DI: return 1 << 3;
+        default: return 0;
+        }
+    }
+
     class Arch8086
     {
     public:
-        static const std::unordered_map<std::string, std::vector<Instruction>> InstructionSet;
-        static const std::unordered_map<std::vector<RegisterIdentifier>, RM> RmRegsCombinations;
-        static const std::unordered_map<std::string, uint8_t> DefineDataMnemonics;
-        static const std::unordered_map<std::string, uint8_t> ReserveDataMnemonics;
-        static const std::unordered_map<RegisterIdentifier, InstructionPrefix> SregToSegOverride;
+        static constexpr uint8_t InvalidRm = 0xFF;
+
+        //RM field by the mask of registers in a memory operand, no registers is a direct address
+        static constexpr std::array<uint8_t, 16> RmByRegsMask = []()
+        {
+            std::array<uint8_t, 16> result{};
+            result.fill(InvalidRm);
 
-        static inline bool HasMnemonic(const std::string& intendentMnemonic) { return (InstructionSet.count(intendentMnemonic) > 0); }
+            result[0] = static_cast<uint8_t>(RM::DISP_16);
+            result[GetRmRegBit(RegisterIdentifier::BX)] = static_cast<uint8_t>(RM::BX);
+            result[GetRmRegBit(RegisterIdentifier::BP)] = static_cast<uint8_t>(RM::BP);
+            result[GetRmRegBit(RegisterIdentifier::SI)] = static_cast<uint8_t>(RM::SI);
+            result[GetRmRegBit(RegisterIdentifier::DI)] = static_cast<uint8_t>(RM::DI);
+            result[GetRmRegBit(RegisterIdentifier::BX) | GetRmRegBit(RegisterIdentifier::SI)] = static_cast<uint8_t>(RM::BX_SI);
+            result[GetRmRegBit(RegisterIdentifier::BX) | GetRmRegBit(RegisterIdentifier::DI)] = static_cast<uint8_t>(RM::BX_DI);
+            result[GetRmRegBit(RegisterIdentifier::BP) | GetRmRegBit(RegisterIdentifier::SI)] = static_cast<uint8_t>(RM::BP_SI);
+            result[GetRmRegBit(RegisterIdentifier::BP) | GetRmRegBit(RegisterIdentifier::DI)] = static_cast<uint8_t>(RM::BP_DI);
+
+            return result;
+        }();
+
+        static const InstructionTable InstructionSet;
+        static const std::unordered_map<RegisterIdentifier, InstructionPrefix> SregToSegOverride;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -81,7 +81,7 @@ namespace ASM::Arch
         int64_t approximateValue = 0;
         uint8_t minRequiredSize = 0;
 
-        Sign sign;
+        Sign sign = Sign::none;
 
         inline bool Is(Kind expectedKind) const { return kind == expectedKind; }
     };
@@ -126,23 +126,4 @@ namespace ASM::Arch
     };
 }
 
-namespace std
-{
-    template<>
-    struct hash<std::vector<ASM::Arch::RegisterIdentifier>>
-    {
-        size_t operator()(const std::vector<ASM::Arch::RegisterIdentifier>& vec) const 
-        {
-            size_t seed = vec.size();
-
-            for(auto& i : vec) 
-            {
-              seed ^= (uint8_t)i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            }
-
-            return seed;
-        }
-    };
-}
-
 #endif
\ No newline at end of file
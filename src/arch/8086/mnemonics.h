@@ -0,0 +1,45 @@
+#ifndef __ASM_MNEMONICS_H
+#define __ASM_MNEMONICS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+//Every mnemonic of the instruction set, each must have an entry in Arch8086 instruction table
+#define ASM_8086_MNEMONICS(X)                                                          \
+    X(AAA)   X(AAD)    X(AAM)    X(ADD)    X(AND)    X(BT)     X(BTC)    X(CALL)     \
+    X(CLC)   X(CMP)    X(CPUID)  X(DEC)    X(DIV)    X(IDIV)   X(IMUL)   X(IN)       \
+    X(INC)   X(INT)    X(INT0)   X(INT1)   X(INT3)   X(IRET)   X(IRED)   X(JA)       \
+    X(JAE)   X(JB)     X(JBE)    X(JC)     X(JCXZ)   X(JECXZ)  X(JE)     X(JG)       \
+    X(JGE)   X(JL)     X(JLE)    X(JNA)    X(JNAE)   X(JNB)    X(JNBE)   X(JNC)      \
+    X(JNE)   X(JNG)    X(JNGE)   X(JNL)    X(JNLE)   X(JNO)    X(JNP)    X(JNS)      \
+    X(JNZ)   X(JO)     X(JP)     X(JPE)    X(JPO)    X(JS)     X(JZ)     X(JMP)      \
+    X(LEA)   X(LEAVE)  X(LOOP)   X(LOOPE)  X(LOOPNE) X(MOV)    X(MUL)    X(NOP)      \
+    X(NOT)   X(OR)     X(OUT)    X(POP)    X(POPA)   X(POPAD)  X(PUSH)   X(PUSHA)    \
+    X(PUSHAD) X(PUSHF) X(PUSHFD) X(RET)    X(SAL)    X(SAR)    X(SHL)    X(SHR)      \
+    X(STC)   X(SUB)    X(TEST)   X(XCHG)   X(XOR)
+
+namespace ASM::Arch
+{
+    enum class Mnemonic : uint8_t
+    {
+#define MNEMONIC_TO_ENUM(x) x,
+        ASM_8086_MNEMONICS(MNEMONIC_TO_ENUM)
+#undef MNEMONIC_TO_ENUM
+
+        Count
+    };
+
+    inline constexpr size_t MnemonicsCount = static_cast<size_t>(Mnemonic::Count);
+
+    inline constexpr std::string_view MnemonicNames[MnemonicsCount] =
+    {
+#define MNEMONIC_TO_NAME(x) #x,
+        ASM_8086_MNEMONICS(MNEMONIC_TO_NAME)
+#undef MNEMONIC_TO_NAME
+    };
+
+    inline constexpr std::string_view GetMnemonicName(Mnemonic mnemonic) { return MnemonicNames[static_cast<size_t>(mnemonic)]; }
+}
+
+#endif
@@ -0,0 +1,173 @@
+#include "build-cache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "utils/content-hash.h"
+
+using namespace ASM;
+using namespace ASM::CLI;
+
+BuildCache::BuildCache(const std::filesystem::path& directory, uint64_t sizeLimit)
+    : directory(directory), sizeLimit(sizeLimit)
+{
+    std::random_device random;
+
+    temporaryToken = (static_cast<uint64_t>(random()) << 32) | random();
+}
+
+bool BuildCache::Open()
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    return std::filesystem::is_directory(directory, error);
+}
+
+std::string BuildCache::MakeKey(std::string_view source, uint8_t format, uint64_t instructionSetVersion)
+{
+    ContentHash hash;
+
+    hash.Update(Version).Update(format).Update(instructionSetVersion).Update(source);
+
+    return hash.ToString();
+}
+
+bool BuildCache::Load(const std::string& key, Entry& entry)
+{
+    const std::filesystem::path path = directory / key;
+    std::ifstream in(path, std::ios::binary);
+    Header header;
+
+    if (in.is_open() == false ||
+        in.read(reinterpret_cast<char*>(&header), sizeof(header)).good() == false ||
+        header.magic != magic || header.version != Version)
+    {
+        ++misses;
+        return false;
+    }
+
+    //Sizes come from disk, a damaged or foreign entry is a miss before anything is allocated
+    std::error_code error;
+    const uint64_t fileSize = std::filesystem::file_size(path, error);
+
+    if (error || fileSize < sizeof(header) || header.outputSize > fileSize - sizeof(header) ||
+        header.logSize != fileSize - sizeof(header) - header.outputSize)
+    {
+        ++misses;
+        return false;
+    }
+
+    entry.output.resize(header.outputSize);
+    entry.log.resize(header.logSize);
+
+    in.read(entry.output.data(), entry.output.size());
+    in.read(entry.log.data(), entry.log.size());
+
+    //Truncated entry is left for eviction
+    if (in.gcount() != static_cast<std::streamsize>(entry.log.size()) || in.fail())
+    {
+        ++misses;
+        return false;
+    }
+
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+    ++hits;
+
+    return true;
+}
+
+void BuildCache::Store(const std::string& key, std::string_view output, std::string_view log)
+{
+    const std::filesystem::path temporary = directory / (key + '.' + std::to_string(temporaryToken) + '.' + std::to_string(temporaryCounter++) + ".tmp");
+
+    Header header;
+    header.outputSize = output.size();
+    header.logSize = log.size();
+
+    {
+        std::ofstream out(temporary, std::ios::binary);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(output.data(), output.size());
+        out.write(log.data(), log.size());
+
+        if (out.good() == false)
+        {
+            out.close();
+
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+
+            return;
+        }
+    }
+
+    //Other builds see either no entry or a complete one
+    std::error_code error;
+    std::filesystem::rename(temporary, directory / key, error);
+
+    if (error)
+        std::filesystem::remove(temporary, error);
+    else
+        ++stores;
+}
+
+void BuildCache::Evict()
+{
+    struct File
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        uint64_t size;
+    };
+
+    std::vector<File> files;
+    uint64_t totalSize = 0;
+    std::error_code error;
+    const auto now = std::filesystem::file_time_type::clock::now();
+
+    for (auto& item : std::filesystem::directory_iterator(directory, error))
+    {
+        if (item.is_regular_file(error) == false)
+            continue;
+
+        File file = { item.path(), item.last_write_time(error), item.file_size(error) };
+
+        if (error)
+            continue;
+
+        //Other builds may be writing their temporary files, only ones left by failed builds are removed
+        if (file.path.extension() == ".tmp")
+        {
+            if (now - file.lastUse > staleTemporaryAge)
+                std::filesystem::remove(file.path, error);
+
+            continue;
+        }
+
+        totalSize += file.size;
+        files.push_back(std::move(file));
+    }
+
+    if (totalSize <= sizeLimit)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const File& lhs, const File& rhs) { return lhs.lastUse < rhs.lastUse; });
+
+    for (File& file : files)
+    {
+        if (totalSize <= sizeLimit)
+            break;
+
+        if (std::filesystem::remove(file.path, error))
+        {
+            totalSize -= file.size;
+            ++evictions;
+        }
+    }
+}
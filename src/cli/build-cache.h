@@ -0,0 +1,76 @@
+#ifndef __ASM_BUILD_CACHE_H
+#define __ASM_BUILD_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace ASM::CLI
+{
+    //Outputs of earlier builds kept on disk, keyed by a hash of everything an output depends on.
+    //Each entry is a file named by its key, holding the output and the messages of the build.
+    //Modification time of an entry is its last use, least recently used entries are evicted
+    //first once the cache grows over its size limit.
+    class BuildCache
+    {
+    public:
+        //Bumped when generated code or the entry layout changes without a change of the instruction set
+        static constexpr uint32_t Version = 1;
+
+        struct Entry
+        {
+            std::string output;
+            std::string log;
+        };
+    private:
+        static constexpr uint32_t magic = 0x43485741;
+
+        struct Header
+        {
+            uint32_t magic = BuildCache::magic;
+            uint32_t version = BuildCache::Version;
+            uint64_t outputSize = 0;
+            uint64_t logSize = 0;
+        };
+
+        std::filesystem::path directory;
+        uint64_t sizeLimit = 0;
+
+        std::atomic<size_t> hits = 0;
+        std::atomic<size_t> misses = 0;
+        std::atomic<size_t> stores = 0;
+        size_t evictions = 0;
+
+        //Files are written under unique names and renamed to the key when complete,
+        //the token keeps names of different processes apart
+        uint64_t temporaryToken = 0;
+        std::atomic<size_t> temporaryCounter = 0;
+        //Older temporary files are left by failed builds
+        static constexpr std::chrono::hours staleTemporaryAge = std::chrono::hours(1);
+    public:
+        BuildCache(const std::filesystem::path& directory, uint64_t sizeLimit);
+
+        //Makes the directory, returns false if it can't be made
+        bool Open();
+
+        //Source bytes, output format and instruction set are all the output depends on
+        static std::string MakeKey(std::string_view source, uint8_t format, uint64_t instructionSetVersion);
+
+        //Marks the entry as used, counts a hit or a miss
+        bool Load(const std::string& key, Entry& entry);
+        void Store(const std::string& key, std::string_view output, std::string_view log);
+
+        //Removes least recently used entries until the cache fits its limit
+        void Evict();
+
+        inline size_t GetHits() const { return hits; }
+        inline size_t GetMisses() const { return misses; }
+        inline size_t GetStores() const { return stores; }
+        inline size_t GetEvictions() const { return evictions; }
+    };
+}
+
+#endif
@@ -2,6 +2,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
 
 #include "codegen/code-generator.h"
 #include "syntax/parser.h"
@@ -29,6 +33,16 @@ const std::unordered_map<std::string, ArgKind> Argument::StrToKind = {
     { "l",          ArgKind::linking },
     { "f",          ArgKind::format },
     { "format",     ArgKind::format },
+    { "p",          ArgKind::pipeline },
+    { "pipeline",   ArgKind::pipeline },
+    { "pp",         ArgKind::parallel_parse },
+    { "parallel-parse", ArgKind::parallel_parse },
+    { "pcg",        ArgKind::parallel_codegen },
+    { "parallel-codegen", ArgKind::parallel_codegen },
+    { "j",          ArgKind::jobs },
+    { "jobs",       ArgKind::jobs },
+    { "cache",      ArgKind::cache },
+    { "cache-size", ArgKind::cache_size },
 };
 
 const std::unordered_map<std::string, CommandLineInterfaceHandler::Target> CommandLineInterfaceHandler::StrToTarget =
@@ -88,6 +102,36 @@ CommandLineInterfaceHandler::CommandLineInterfaceHandler(int argc, const char**
         case ArgKind::log_out:
             config.logOutput = arg.GetValue();
             break;
+        case ArgKind::jobs:
+        {
+            const size_t jobs = std::strtoull(arg.GetValue().c_str(), nullptr, 10);
+
+            if (jobs == 0)
+            {
+                std::cout << "Jobs count must be a positive number, '" << arg.GetValue() << "' ignored" << std::endl;
+                break;
+            }
+
+            config.jobs = jobs;
+        }
+            break;
+        case ArgKind::cache:
+            config.cacheDirectory = arg.GetValue();
+            break;
+        case ArgKind::cache_size:
+        {
+            //In megabytes
+            const uint64_t size = std::strtoull(arg.GetValue().c_str(), nullptr, 10);
+
+            if (size == 0)
+            {
+                std::cout << "Cache size must be a positive number of megabytes, '" << arg.GetValue() << "' ignored" << std::endl;
+                break;
+            }
+
+            config.cacheSizeLimit = size * 1024 * 1024;
+        }
+            break;
         case ArgKind::format:
         {
             if (StrToTarget.count(arg.GetValue()) == 0)
@@ -128,23 +172,31 @@ CommandLineInterfaceHandler::CommandLineInterfaceHandler(int argc, const char**
             else
                 std::cout << "Incompatable output format with linking mode" << std::endl;
             break;
+        case ArgKind::pipeline:
+            config.pipeline = true;
+            break;
+        case ArgKind::parallel_parse:
+            config.parallelParse = true;
+            break;
+        case ArgKind::parallel_codegen:
+            config.parallelCodegen = true;
+            break;
         default:
             assert(false);
             break;
         }
     }
 
-    if (config.outputFile.empty() && config.inputFiles.empty() == false) {
+    if (config.outputFile.empty() && config.inputFiles.size() == 1) {
         config.outputFile = config.inputFiles.back();
         config.outputFile.replace_extension("");
     }
 }
 
-std::string CommandLineInterfaceHandler::logDebugStringBuffer = std::string();
-
-void CommandLineInterfaceHandler::PrintExpression(const AST::Expression* expression, bool inDepth, bool isLast, std::string& startString)
+void CommandLineInterfaceHandler::PrintExpression(Job& job, const AST::Expression* expression, bool inDepth, bool isLast)
 {
-    auto& out = context->GetLogOutput();
+    std::string& startString = job.debugIndent;
+    auto& out = job.context->GetLogOutput();
 
     uint8_t temp = 0;
 
@@ -170,9 +222,9 @@ void CommandLineInterfaceHandler::PrintExpression(const AST::Expression* express
 
         out << "\033[1msymbol\033[0m \'" << symbolExpr->GetName();
 
-        if (context->GetSymbolTable().HasSymbol(symbolExpr->GetName()))
+        if (job.context->GetSymbolTable().HasSymbol(symbolExpr->GetId()))
         {
-            auto& symbol = context->GetSymbolTable().GetSymbol(symbolExpr->GetName());
+            auto& symbol = job.context->GetSymbolTable().GetSymbol(symbolExpr->GetId());
     
             out << ": ";
     
@@ -194,29 +246,29 @@ void CommandLineInterfaceHandler::PrintExpression(const AST::Expression* express
     {
         out << "\033[1mbinary\033[0m \'" << expression->GetAs<AST::BinaryExpr>()->operation << '\'' << std::endl;
 
-        PrintExpression(expression->GetAs<AST::BinaryExpr>()->lhs.get(), true, false);
-        PrintExpression(expression->GetAs<AST::BinaryExpr>()->rhs.get(), true);
+        PrintExpression(job, expression->GetAs<AST::BinaryExpr>()->lhs, true, false);
+        PrintExpression(job, expression->GetAs<AST::BinaryExpr>()->rhs, true);
     }
     else if (expression->Is<AST::UnaryExpr>())
     {
         out << "\033[1munary\033[0m \'" << expression->GetAs<AST::UnaryExpr>()->GetOperation() << '\'' << std::endl;
 
-        PrintExpression(expression->GetAs<AST::UnaryExpr>()->GetExpression(), true);
+        PrintExpression(job, expression->GetAs<AST::UnaryExpr>()->GetExpression(), true);
     }
     else if (expression->Is<AST::MemoryExpr>())
     {
         out << "\033[1mmemory\033[0m" << std::endl;
 
         if (expression->GetAs<AST::MemoryExpr>()->GetSegOverride() != nullptr)
-            PrintExpression(expression->GetAs<AST::MemoryExpr>()->GetSegOverride(), true, false);
+            PrintExpression(job, expression->GetAs<AST::MemoryExpr>()->GetSegOverride(), true, false);
 
-        PrintExpression(expression->GetAs<AST::MemoryExpr>()->GetExpression(), true);
+        PrintExpression(job, expression->GetAs<AST::MemoryExpr>()->GetExpression(), true);
     }
     else if (expression->Is<AST::ParenExpr>())
     {
         out << "\033[1mparen\033[0m" << std::endl;
 
-        PrintExpression(expression->GetAs<AST::ParenExpr>()->GetExpression(), true);
+        PrintExpression(job, expression->GetAs<AST::ParenExpr>()->GetExpression(), true);
     }
 
     if (isLast == false)
@@ -225,14 +277,14 @@ void CommandLineInterfaceHandler::PrintExpression(const AST::Expression* express
         startString.pop_back();
 }
 
-void CommandLineInterfaceHandler::PrintSymbolDecl(const AST::Declaration* ptr)
+void CommandLineInterfaceHandler::PrintSymbolDecl(Job& job, const AST::Declaration* ptr)
 {
-    auto& out = context->GetLogOutput();
+    auto& out = job.context->GetLogOutput();
 
     if (ptr->Is<AST::ConstantDecl>())
     {
         out << "\033[1mConstant\033[0m: " << ptr->GetAs<AST::ConstantDecl>()->GetName() << std::endl;
-        PrintExpression(&ptr->GetAs<AST::ConstantDecl>()->GetExpression(), true);
+        PrintExpression(job, &ptr->GetAs<AST::ConstantDecl>()->GetExpression(), true);
     }
     else if (ptr->Is<AST::SectionDecl>())
     {
@@ -244,9 +296,9 @@ void CommandLineInterfaceHandler::PrintSymbolDecl(const AST::Declaration* ptr)
     }
 }
 
-void CommandLineInterfaceHandler::LogAST(AbstractSyntaxTree& ast)
+void CommandLineInterfaceHandler::LogAST(Job& job, AbstractSyntaxTree& ast)
 {
-    auto& out = context->GetLogOutput();
+    auto& out = job.context->GetLogOutput();
 
     out << "[AST Interpretation]:" << std::endl;
 
@@ -256,16 +308,16 @@ void CommandLineInterfaceHandler::LogAST(AbstractSyntaxTree& ast)
 
         if (ptr->Is<AST::SymbolDecl>())
         {
-            PrintSymbolDecl(ptr->GetAs<AST::SymbolDecl>());
+            PrintSymbolDecl(job, ptr->GetAs<AST::SymbolDecl>());
         }
         else if (ptr->Is<AST::InstructionStmt>())
         {
-            out << "\033[1mInstruction\033[0m: " << ptr->GetAs<AST::InstructionStmt>()->GetMnemonic() << std::endl;
+            out << "\033[1mInstruction\033[0m: " << Arch::GetMnemonicName(ptr->GetAs<AST::InstructionStmt>()->GetMnemonic()) << std::endl;
             
             auto& operands = ptr->GetAs<AST::InstructionStmt>()->GetOperands();
 
             for (auto& operand : operands)
-                PrintExpression(operand.get(), true, &operand == &operands.back());
+                PrintExpression(job, operand, true, &operand == &operands.back());
         }
         else if (ptr->Is<AST::DefineDataStmt>())
         {
@@ -274,36 +326,36 @@ void CommandLineInterfaceHandler::LogAST(AbstractSyntaxTree& ast)
             auto& operands = ptr->GetAs<AST::DefineDataStmt>()->GetUnits();
 
             for (auto& operand : operands)
-                PrintExpression(operand.get(), true, &operand == &operands.back());
+                PrintExpression(job, operand, true, &operand == &operands.back());
         }
         else if (ptr->Is<AST::AlignStmt>())
         {
             out << "\033[1mAlign\033[0m: " << std::endl;
-            PrintExpression(ptr->GetAs<AST::AlignStmt>()->GetValueExpression(), true);
+            PrintExpression(job, ptr->GetAs<AST::AlignStmt>()->GetValueExpression(), true);
         }
         else if (ptr->Is<AST::OffsetStmt>())
         {
             out << "\033[1mOffset\033[0m: " << std::endl;
-            PrintExpression(ptr->GetAs<AST::OffsetStmt>()->GetValueExpression(), true);   
+            PrintExpression(job, ptr->GetAs<AST::OffsetStmt>()->GetValueExpression(), true);   
         }
         else if (ptr->Is<AST::OrgStmt>())
         {
             out << "\033[1mOrigin\033[0m: " << std::endl;
-            PrintExpression(ptr->GetAs<AST::OrgStmt>()->GetValueExpression(), true);
+            PrintExpression(job, ptr->GetAs<AST::OrgStmt>()->GetValueExpression(), true);
         }
         else if (ptr->Is<AST::StackStmt>())
         {
             out << "\033[1mStack\033[0m: " << std::endl;
-            PrintExpression(ptr->GetAs<AST::StackStmt>()->GetValueExpression(), true);
+            PrintExpression(job, ptr->GetAs<AST::StackStmt>()->GetValueExpression(), true);
         }
     }
 
     out << std::endl;
 }
 
-void CommandLineInterfaceHandler::LogSection(ASM::Section& section)
+void CommandLineInterfaceHandler::LogSection(Job& job, ASM::Section& section)
 {
-    auto& out = context->GetLogOutput();
+    auto& out = job.context->GetLogOutput();
 
     out << "Section: " << section.GetName() << std::endl;
 
@@ -318,98 +370,99 @@ void CommandLineInterfaceHandler::LogSection(ASM::Section& section)
             << ' ' << (link.GetType() == ASM::LinkingTarget::Type::Integer ? "int" : "float")
             << std::dec << static_cast<uint16_t>(link.GetSize()) * 8 << "_t" << ':' << std::endl;
 
-            PrintExpression(link.GetExpression());
+            PrintExpression(job, link.GetExpression());
         }
     }
 
     out << std::endl;
 }
 
-void CommandLineInterfaceHandler::LogLinkingTarget(ASM::LinkingTarget& link)
+void CommandLineInterfaceHandler::LogLinkingTarget(Job& job, ASM::LinkingTarget& link)
 {
-    auto& out = context->GetLogOutput();
+    auto& out = job.context->GetLogOutput();
 
     out << "0x" << std::setfill('0') << std::setw(16) << link.GetSectionOffset()
     << ": " << (link.GetKind() == ASM::LinkingTarget::Kind::RelativeAddress ? "Relative" : "Value\\Absolute")
     << ' ' << (link.GetType() == ASM::LinkingTarget::Type::Integer ? "int" : "float")
     << std::dec << static_cast<uint16_t>(link.GetSize()) * 8 << "_t" << ':' << std::endl;
 
-    PrintExpression(link.GetExpression());
+    PrintExpression(job, link.GetExpression());
 }
 
-void CommandLineInterfaceHandler::LogSymbolTable(ASM::SymbolTable& symbolTable)
+void CommandLineInterfaceHandler::LogSymbolTable(Job& job, ASM::SymbolTable& symbolTable)
 {
-    auto& out = context->GetLogOutput();
+    auto& out = job.context->GetLogOutput();
 
     out << "[Symbol Table]:" << std::endl;
 
-    for (auto& pair : symbolTable.GetSymbolsMap())
+    for (SymbolId id : symbolTable.GetSymbolIds())
     {
-        out << "Symbol \'" << pair.first << "\':" << std::endl;
-        PrintSymbolDecl(&pair.second.GetDeclaration());
+        const Symbol& symbol = symbolTable.GetSymbol(id);
+
+        out << "Symbol \'" << symbol.GetDeclaration().GetName() << "\':" << std::endl;
+        PrintSymbolDecl(job, &symbol.GetDeclaration());
         
-        if (pair.second.IsEvaluated())
-            out << "Value: " << pair.second.GetValue().GetAsInt() << std::endl;
+        if (symbol.IsEvaluated())
+            out << "Value: " << symbol.GetValue().GetAsInt() << std::endl;
     }
 }
 
-bool CommandLineInterfaceHandler::Handle()
+std::filesystem::path CommandLineInterfaceHandler::GetOutputPath(const std::filesystem::path& input) const
 {
-    if (config.inputFiles.size() == 0)
-    {
-        std::cout << "No input files, use \'-i\' argument to provie file path" << std::endl;
-        return false;
-    }
+    if (config.inputFiles.size() == 1)
+        return config.outputFile;
 
-    std::ifstream in(config.inputFiles.back());
-    std::ofstream out(config.outputFile);
-    std::ofstream logOutput;
+    //With several inputs the output option names a directory
+    std::filesystem::path output = (config.outputFile.empty() ? input : config.outputFile / input.filename());
+    output.replace_extension("");
+
+    return output;
+}
 
-    if (in.is_open() == false)
+void CommandLineInterfaceHandler::OpenSource(Job& job)
+{
+    std::call_once(job.openFlag, [&job]()
     {
-        std::cout << "Can't open input file \'" << config.inputFiles.back() << "\'" << std::endl;
-        return false;
-    }
+        job.isOpened = job.source.Open(job.input);
+
+        if (job.isOpened)
+            job.source.Prefetch();
+    });
+}
 
-    if (out.is_open() == false)
+bool CommandLineInterfaceHandler::Assemble(Job& job, std::ostream& log)
+{
+    if (job.isOpened == false)
     {
-        std::cout << "Can't open output file \'" << config.outputFile << "\'" << std::endl;
+        log << "Can't open input file \'" << job.input.string() << "\'" << std::endl;
         return false;
     }
 
-    context = std::make_unique<AssemblyContext>(in, Arch::Arch8086::InstructionSet);
+    if (config.target == Target::linking_com || config.target == Target::linking_exe)
+        return LinkObject(job, log);
 
-    if (config.logOutput.empty() == false)
-    {
-        logOutput.open(config.logOutput);
+    job.context = std::make_unique<AssemblyContext>(std::move(job.source), Arch::Arch8086::InstructionSet);
+    AssemblyContext& context = *job.context;
 
-        if (logOutput.is_open() == false)
-        {
-            std::cout << "Can't open log output file \'" << config.logOutput << "\'" << std::endl;
-            return false;
-        }
+    context.SetLogOutput(log);
 
-        context->SetLogOutput(logOutput);
-    }
+    if (config.parallelParse)
+        context.SetChunkedMode(std::thread::hardware_concurrency());
+    else if (config.pipeline)
+        context.SetParallelMode();
 
-    Lexer lexer(*context);
-    Parser parser(*context);
-    Codegen::CodeGenerator codeGenerator(*context);
-    Linker linker(*context);
+    if (config.parallelCodegen)
+        context.SetParallelCodegen(std::thread::hardware_concurrency());
 
-    {
-        ASM::Token token;
-    
-        while (lexer.GetNextToken(token) || token.Is(ASM::TokKind::eof) == false)
-            parser.PushToken(std::move(token));
-    
-        parser.PushToken(std::move(token));
-    }
+    Lexer lexer(context);
+    Parser parser(context, lexer);
+    Codegen::CodeGenerator codeGenerator(context);
+    Linker linker(context);
 
     AbstractSyntaxTree ast = parser.Parse();
 
     if (config.debugInfo & static_cast<uint8_t>(DebugInfo::ast))
-        LogAST(ast);
+        LogAST(job, ast);
 
     codeGenerator.ProccessAST(ast);
     
@@ -423,30 +476,244 @@ bool CommandLineInterfaceHandler::Handle()
     case Target::exe:
         assembledObject = linker.Link(LinkingFormat::DosExecutable);
         break;
+    case Target::object:
+        assembledObject = std::make_unique<ObjectFile>(context);
+        break;
     default:
         break;
     }
     
-    if (context->HasErrors())
+    if (context.HasErrors())
     {
-        const std::string result = "Build failed: " + std::to_string(context->GetErrorsCount()) + " errors";
-        context->Info(result.c_str());
+        const std::string result = "Build failed: " + std::to_string(context.GetErrorsCount()) + " errors";
+        context.Info(result.c_str());
         return false;
     }
 
     if (config.debugInfo & static_cast<uint8_t>(DebugInfo::sections))
     {
-        for (auto& pair : context->GetTranslationUnit().GetSectionMap())
-            LogSection(pair.second);
+        for (auto& pair : context.GetTranslationUnit().GetSectionMap())
+            LogSection(job, pair.second);
     }
     if (config.debugInfo & static_cast<uint8_t>(DebugInfo::symbol_table))
-        LogSymbolTable(context->GetSymbolTable());
+        LogSymbolTable(job, context.GetSymbolTable());
+
+    std::ostringstream assembled;
 
-    if (assembledObject->Serialize(out) == false)
+    if (assembledObject->Serialize(assembled) == false)
     {
-        context->Error("Can't write assembled object to file, something went wrong...");
+        context.Error("Can't write assembled object to file, something went wrong...");
         return false;
     }
 
+    job.assembled = std::move(assembled).str();
+
     return true;
 }
+
+bool CommandLineInterfaceHandler::LinkObject(Job& job, std::ostream& log)
+{
+    //Object keeps the mapped input, the context has no source and only collects messages
+    job.context = std::make_unique<AssemblyContext>(std::string(), Arch::Arch8086::InstructionSet);
+    AssemblyContext& context = *job.context;
+
+    context.SetLogOutput(log);
+
+    ObjectFile object;
+
+    if (object.Load(std::move(job.source)) == false)
+    {
+        context.Error("Input is not a valid object file or was made by another version");
+        return false;
+    }
+
+    Linker linker(context);
+    std::unique_ptr<AssembledObject> assembledObject =
+        linker.Link(object, config.target == Target::linking_com ? LinkingFormat::RawBinary : LinkingFormat::DosExecutable);
+
+    if (context.HasErrors())
+    {
+        const std::string result = "Linking failed: " + std::to_string(context.GetErrorsCount()) + " errors";
+        context.Info(result.c_str());
+        return false;
+    }
+
+    std::ostringstream assembled;
+
+    if (assembledObject->Serialize(assembled) == false)
+    {
+        context.Error("Can't write assembled object to file, something went wrong...");
+        return false;
+    }
+
+    job.assembled = std::move(assembled).str();
+
+    return true;
+}
+
+bool CommandLineInterfaceHandler::AssembleCached(Job& job, BuildCache& cache)
+{
+    if (job.isOpened == false)
+        return Assemble(job, job.log);
+
+    const std::string key = BuildCache::MakeKey
+    (
+        job.source.GetText(),
+        static_cast<uint8_t>(config.target),
+        Arch::Arch8086::InstructionSet.GetVersion()
+    );
+
+    BuildCache::Entry entry;
+
+    if (cache.Load(key, entry))
+    {
+        job.assembled = std::move(entry.output);
+        job.log << entry.log;
+
+        return true;
+    }
+
+    if (Assemble(job, job.log) == false)
+        return false;
+
+    cache.Store(key, job.assembled, job.log.view());
+
+    return true;
+}
+
+bool CommandLineInterfaceHandler::Handle()
+{
+    if (config.inputFiles.size() == 0)
+    {
+        std::cout << "No input files, use \'-i\' argument to provie file path" << std::endl;
+        return false;
+    }
+
+    std::ofstream logOutput;
+    std::ostream* log = &std::cout;
+
+    if (config.logOutput.empty() == false)
+    {
+        logOutput.open(config.logOutput);
+
+        if (logOutput.is_open() == false)
+        {
+            std::cout << "Can't open log output file \'" << config.logOutput << "\'" << std::endl;
+            return false;
+        }
+
+        log = &logOutput;
+    }
+
+    //Jobs are referenced by workers, deque keeps them in place
+    std::deque<Job> jobs;
+
+    for (auto& input : config.inputFiles)
+    {
+        Job& job = jobs.emplace_back();
+
+        job.input = input;
+        job.output = GetOutputPath(input);
+    }
+
+    const size_t workersCount = std::clamp<size_t>(config.jobs, 1, jobs.size());
+
+    //Debug output needs the AST and symbols, it can't be restored
+    std::unique_ptr<BuildCache> cache;
+
+    if (config.cacheDirectory.empty() == false && config.debugInfo == static_cast<uint8_t>(DebugInfo::none))
+    {
+        cache = std::make_unique<BuildCache>(config.cacheDirectory, config.cacheSizeLimit);
+
+        if (cache->Open() == false)
+        {
+            *log << "Can't open cache directory '" << config.cacheDirectory.string() << "', building without cache" << std::endl;
+            cache.reset();
+        }
+    }
+
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    std::atomic<size_t> nextJob = 0;
+
+    auto work = [&]()
+    {
+        for (size_t i = nextJob.fetch_add(1, std::memory_order_relaxed); i < jobs.size(); i = nextJob.fetch_add(1, std::memory_order_relaxed))
+        {
+            //Input of the next job this worker is likely to take is read while this one is assembled
+            if (i + workersCount < jobs.size())
+                OpenSource(jobs[i + workersCount]);
+
+            OpenSource(jobs[i]);
+
+            //Single input is logged as it goes, unless its messages are cached
+            if (cache != nullptr)
+                jobs[i].isSucceeded = AssembleCached(jobs[i], *cache);
+            else
+                jobs[i].isSucceeded = Assemble(jobs[i], (jobs.size() == 1 ? *log : jobs[i].log));
+
+            {
+                std::lock_guard lock(doneMutex);
+                jobs[i].isDone = true;
+            }
+
+            doneCondition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (size_t i = 0; i < workersCount; ++i)
+        workers.emplace_back(work);
+
+    //Outputs are written and messages are printed in input order, while later inputs are assembled
+    bool result = true;
+
+    for (Job& job : jobs)
+    {
+        {
+            std::unique_lock lock(doneMutex);
+            doneCondition.wait(lock, [&job]() { return job.isDone; });
+        }
+
+        if (job.log.tellp() > 0)
+        {
+            if (jobs.size() > 1)
+                *log << job.input.string() << ':' << std::endl;
+
+            *log << job.log.view();
+        }
+
+        if (job.isSucceeded)
+        {
+            std::ofstream out(job.output, std::ios::binary);
+
+            if (out.is_open() == false || out.write(job.assembled.data(), job.assembled.size()).good() == false)
+            {
+                *log << "Can't open output file \'" << job.output.string() << "\'" << std::endl;
+                job.isSucceeded = false;
+            }
+        }
+
+        result &= job.isSucceeded;
+
+        //Everything but the status is dropped, thousands of inputs may be built at once
+        job.context.reset();
+        job.log = std::ostringstream();
+        job.assembled = std::string();
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    if (cache != nullptr)
+    {
+        if (cache->GetStores() > 0)
+            cache->Evict();
+
+        *log << "Build cache: " << cache->GetHits() << " hits, " << cache->GetMisses() << " misses, "
+            << cache->GetEvictions() << " evicted" << std::endl;
+    }
+
+    return result;
+}
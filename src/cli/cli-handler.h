@@ -3,11 +3,15 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <sstream>
 #include <unordered_map>
 #include <filesystem>
 
 #include "syntax/ast.h"
 #include "context/context.h"
+#include "build-cache.h"
 
 namespace ASM::CLI
 {
@@ -20,12 +24,18 @@ namespace ASM::CLI
             input,
             format,
             log_out,
+            jobs,
+            cache,
+            cache_size,
             show_ast,
             show_sections,
             show_linking,
             show_sym_table,
             show_all,
-            linking
+            linking,
+            pipeline,
+            parallel_parse,
+            parallel_codegen
         };
 
         static const std::unordered_map<std::string, Kind> StrToKind;
@@ -40,7 +50,7 @@ namespace ASM::CLI
         inline Kind GetKind() const { return kind; }
         inline const std::string& GetValue() const { return value; }
 
-        inline bool IsNeedValue() const { return kind >= Kind::output && kind <= Kind::log_out; }
+        inline bool IsNeedValue() const { return kind >= Kind::output && kind <= Kind::cache_size; }
     };
 
     using ArgKind = Argument::Kind;
@@ -72,27 +82,69 @@ namespace ASM::CLI
         {
             Target target = Target::com;
             uint8_t debugInfo = static_cast<uint8_t>(DebugInfo::none);
+            //Lex on a separate thread concurrently with parsing
+            bool pipeline = false;
+            //Split source into chunks parsed on all hardware threads
+            bool parallelParse = false;
+            //Encode blocks of statements on all hardware threads
+            bool parallelCodegen = false;
+            //Inputs assembled at once, each one on its own worker
+            size_t jobs = 1;
+
+            //Build cache is used if the directory is set
+            std::filesystem::path cacheDirectory;
+            uint64_t cacheSizeLimit = 256ull * 1024 * 1024;
 
             std::vector<std::filesystem::path> inputFiles;
             std::filesystem::path outputFile;
             std::filesystem::path logOutput;
         };
 
+        //One input file, everything it needs is owned here so inputs are assembled independently
+        struct Job
+        {
+            std::filesystem::path input;
+            std::filesystem::path output;
+
+            //Opened once, either ahead by a worker of an earlier input or by its own worker
+            SourceBuffer source;
+            bool isOpened = false;
+            std::once_flag openFlag;
+
+            std::unique_ptr<ASM::AssemblyContext> context;
+            //Messages are printed once all earlier inputs are printed
+            std::ostringstream log;
+            std::string assembled;
+
+            bool isSucceeded = false;
+            //Guarded by the done mutex of the build
+            bool isDone = false;
+
+            //Indentation of the printed expression tree
+            std::string debugIndent;
+        };
+
         static const std::unordered_map<std::string, Target> StrToTarget;
 
         Config config;
-        std::unique_ptr<ASM::AssemblyContext> context;
 
-        static std::string logDebugStringBuffer;
         static std::vector<Argument> ParseArguments(const char** argv, size_t argc);
 
-        void PrintExpression(const AST::Expression* expression, bool inDepth = false, bool isLast = true, std::string& startString = logDebugStringBuffer);
-        void PrintSymbolDecl(const AST::Declaration* declaration);
-
-        void LogAST(ASM::AbstractSyntaxTree& ast);
-        void LogSection(ASM::Section& section);
-        void LogLinkingTarget(ASM::LinkingTarget& linkingTaget);
-        void LogSymbolTable(ASM::SymbolTable& symbolTable);
+        std::filesystem::path GetOutputPath(const std::filesystem::path& input) const;
+        void OpenSource(Job& job);
+        bool Assemble(Job& job, std::ostream& log);
+        //Links an object file input in linking mode
+        bool LinkObject(Job& job, std::ostream& log);
+        //Output and messages are restored from the cache if the same source was built before
+        bool AssembleCached(Job& job, BuildCache& cache);
+
+        void PrintExpression(Job& job, const AST::Expression* expression, bool inDepth = false, bool isLast = true);
+        void PrintSymbolDecl(Job& job, const AST::Declaration* declaration);
+
+        void LogAST(Job& job, ASM::AbstractSyntaxTree& ast);
+        void LogSection(Job& job, ASM::Section& section);
+        void LogLinkingTarget(Job& job, ASM::LinkingTarget& linkingTaget);
+        void LogSymbolTable(Job& job, ASM::SymbolTable& symbolTable);
     public:
         CommandLineInterfaceHandler(int argc, const char** argv);
 
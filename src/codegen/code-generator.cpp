@@ -1,6 +1,10 @@
 #include "code-generator.h"
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
 
 using namespace ASM;
 using namespace ASM::AST;
@@ -92,16 +96,17 @@ uint8_t CodeGenerator::GetOpEncodingPriority(Arch::OperandEncoding opencode)
 uint8_t CodeGenerator::EvaluateDependentOperandSize(const AST::Expression* operand, int64_t& approximateValue) const 
 {
     constexpr uint8_t maxBitsSize = 16;
-    auto dependencies = operand->GetDependecies();
-    std::unordered_map<std::string, int64_t> symbolMap;
+    symbolValues.Clear();
 
-    for (auto depenency : dependencies)
+    for (auto depenency : operand->GetDependencies())
     {
-        if (context->GetSymbolTable().HasSymbol(*depenency) == false) {
+        const Symbol* symbolPtr = context->GetSymbolTable().FindSymbol(depenency);
+
+        if (symbolPtr == nullptr) {
             return maxBitsSize;
         }
 
-        auto& symbol = context->GetSymbolTable().GetSymbol(*depenency);
+        auto& symbol = *symbolPtr;
         
         if (symbol.GetDeclaration().GetScope() == SymbolDecl::Scope::Extern) [[unlikely]]
             return maxBitsSize;
@@ -109,22 +114,24 @@ uint8_t CodeGenerator::EvaluateDependentOperandSize(const AST::Expression* opera
         if (symbol.GetDeclaration().Is<LableDecl>()) {
             const LableDecl* lableDecl = symbol.GetDeclaration().GetAs<LableDecl>();
 
-            if (currentSection != &context->GetTranslationUnit().GetOrMakeSection(lableDecl->GetRelatedSection()->GetName()))
+            //Sections are keyed by name, the section map isn't touched while sections are generated in parallel
+            if (currentSection->GetName() != lableDecl->GetRelatedSection()->GetName())
                 return maxBitsSize;
 
-            symbolMap.insert({ *depenency, lableDecl->GetSectionStmtOffset() });
+            symbolValues.Insert(depenency, lableDecl->GetSectionStmtOffset());
         }
         else if (symbol.GetDeclaration().Is<ConstantDecl>()) {
-            const Expression* expression = &symbol.GetDeclaration().GetAs<ConstantDecl>()->GetExpression();
+            //Constants that depend on addresses aren't approximated
+            const int64_t* value = context->GetResolver().FindConstant(depenency);
 
-            if (ResolveExpressionDependencies(expression, std::string(), symbolMap) == false)
+            if (value == nullptr)
                 return maxBitsSize;
 
-            symbolMap.insert({ *depenency, expression->Resolve(symbolMap) });
+            symbolValues.Insert(depenency, *value);
         }
     }
 
-    approximateValue = operand->Resolve(symbolMap);
+    approximateValue = operand->Resolve(symbolValues);
     uint8_t result = EvaluateLiteralByteSize(approximateValue) * 8;
 
     return (result > maxBitsSize ? maxBitsSize : result);
@@ -171,7 +178,7 @@ SmallVector<Arch::OperandEvaluation, 4> CodeGenerator::EvaluateOperands(const In
             types.push_back(Arch::OpType::m);
             types.push_back(Arch::OpType::rm);
 
-            if (operand->GetAs<MemoryExpr>()->GetRmRegsCombination().empty())
+            if (operand->GetAs<MemoryExpr>()->HasRegisters() == false)
                 types.push_back(Arch::OpType::moffs);
 
             evaluation.minRequiredSize = operand->GetAs<MemoryExpr>()->GetSizeOverride() * 8;
@@ -179,7 +186,7 @@ SmallVector<Arch::OperandEvaluation, 4> CodeGenerator::EvaluateOperands(const In
         else
         {
             evaluation.kind = Arch::OperandEvaluation::Kind::Immediate;
-            auto value = ResolveExpression(operand.get());
+            auto value = ResolveExpression(operand);
 
             if (value.has_value())
             {
@@ -196,7 +203,7 @@ SmallVector<Arch::OperandEvaluation, 4> CodeGenerator::EvaluateOperands(const In
             }
             else
             {
-                evaluation.minRequiredSize = EvaluateDependentOperandSize(operand.get(), evaluation.approximateValue);
+                evaluation.minRequiredSize = EvaluateDependentOperandSize(operand, evaluation.approximateValue);
             }
 
             types.push_back(Arch::OpType::imm);
@@ -208,245 +215,304 @@ SmallVector<Arch::OperandEvaluation, 4> CodeGenerator::EvaluateOperands(const In
     return result;
 }
 
-void CodeGenerator::ChangeCurrentSection(const std::string& sectionName)
+void CodeGenerator::ChangeCurrentSection(const std::string& sectionName, size_t maxCodeSize)
 {
     currentSection = &context->GetTranslationUnit().GetOrMakeSection(sectionName);
     currentSectionCode = &currentSection->GetCode();
+
+    currentSectionCode->code.reserve(currentSectionCode->code.size() + maxCodeSize);
 }
 
-const Arch::Instruction* CodeGenerator::ChooseInstructionByOperands(const std::string& mnemonic, const InstructionStmt::Operands_t& operands, std::optional<size_t> stmtOffset) const
+SmallVector<InstructionSelector::OperandClass, 4> CodeGenerator::ClassifyOperands(const InstructionStmt::Operands_t& operands, std::optional<size_t> stmtOffset) const
 {
-    auto& instructions = context->GetInstructionSet().at(mnemonic);
-
-    const Arch::Instruction* mostAppropriateInstruction = nullptr;
-    int8_t priority = 0;
-
-    auto evaluatedOperands = EvaluateOperands(operands);
+    SmallVector<InstructionSelector::OperandClass, 4> result(operands.size());
 
-    for (auto& instruction : instructions)
+    for (size_t i = 0; i < operands.size(); ++i)
     {
-        if (evaluatedOperands.size() != instruction.operands.size())
-            continue;
+        auto& operand = operands[i];
 
-        int8_t currentPriority = evaluatedOperands.size() == 0 ? 1 : 0;
+        if (operand->Is<RegisterExpr>())
+        {
+            result[i] = InstructionSelector::ClassifyRegister(operand->GetAs<RegisterExpr>()->GetIdentifier());
+        }
+        else if (operand->Is<MemoryExpr>())
+        {
+            const MemoryExpr* memoryExpr = operand->GetAs<MemoryExpr>();
 
-        for (int i = 0; i < instruction.operands.size(); ++i)
+            result[i] = InstructionSelector::ClassifyMemory(memoryExpr->HasRegisters() == false, memoryExpr->GetSizeOverride());
+        }
+        else
         {
-            auto& operandPrototype = instruction.operands[i];
-            auto& evaluatedOperand = evaluatedOperands[i];
-
-            //Check if operand types suitable 
-            if (std::find
-                (
-                    evaluatedOperand.expectedTypes.begin(),
-                    evaluatedOperand.expectedTypes.end(),
-                    operandPrototype.type
-                ) == evaluatedOperand.expectedTypes.end())
-            { currentPriority = 0; break; }
-
-            if (operandPrototype.type == Arch::OpType::rel && stmtOffset.has_value() && evaluatedOperand.approximateValue != 0) [[unlikely]]
+            auto value = ResolveExpression(operand);
+            auto sign = Arch::OperandEvaluation::Sign::none;
+            int64_t approximateValue = 0;
+            uint8_t byteSize = 0;
+
+            if (value.has_value())
             {
-                int64_t offset = evaluatedOperand.approximateValue - static_cast<int64_t>(*stmtOffset);
-                
-                if (instructions.size() > 1 && (offset > 127 || offset < -128) &&
-                    operandPrototype.size < 16)
-                    { currentPriority = 0; break; }
+                approximateValue = *value;
+                byteSize = EvaluateLiteralByteSize(*value);
 
-                currentPriority += 2;
+                if (*value < 0)
+                    sign = Arch::OperandEvaluation::Sign::Signed;
+                else if (CheckSignSizeConflict(*value, byteSize))
+                    sign = Arch::OperandEvaluation::Sign::Unsigned;
             }
-            else 
+            else
             {
-                //Check if operands size matches
-                if (operandPrototype.size != 0 && (
-                        operandPrototype.size < evaluatedOperand.minRequiredSize ||
-                        (
-                            (
-                                evaluatedOperand.Is(Arch::OperandEvaluation::Kind::Register) ||
-                                (evaluatedOperand.Is(Arch::OperandEvaluation::Kind::Memory) && 
-                                evaluatedOperand.minRequiredSize != 0)
-                            )
-                            &&
-                            evaluatedOperand.minRequiredSize != operandPrototype.size
-                        )
-                    ))
-                { currentPriority = 0; break; }
-
-                if (instruction.feature == Arch::SpecialFeature::SignExtended) [[unlikely]]
-                {
-                    if (evaluatedOperand.sign == Arch::OperandEvaluation::Sign::Signed)
-                        ++currentPriority;
-                    else if (evaluatedOperand.sign == Arch::OperandEvaluation::Sign::Unsigned)
-                        currentPriority -= evaluatedOperand.minRequiredSize;
-                    else if (evaluatedOperand.kind == Arch::OperandEvaluation::Kind::Immediate &&
-                            operandPrototype.size == 1)
-                        { currentPriority = 0; break; }
-                }
-
-                if (operandPrototype.size != 0 &&
-                    operandPrototype.size == evaluatedOperand.minRequiredSize)
-                    ++currentPriority;
+                byteSize = EvaluateDependentOperandSize(operand, approximateValue) / 8;
             }
 
-            currentPriority += GetOperandTypePriority(operandPrototype.type);
+            result[i] = InstructionSelector::ClassifyImmediate
+            (
+                byteSize, sign,
+                InstructionSelector::GetDistance(approximateValue, stmtOffset),
+                value == 1
+            );
         }
+    }
 
-        if (currentPriority > 0)
-            currentPriority += GetOpEncodingPriority(instruction.opencode);
+    return result;
+}
 
-        if (currentPriority > priority)
-        {
-            mostAppropriateInstruction = &instruction;
-            priority = currentPriority;
-        }
-    }
+const Arch::Instruction* CodeGenerator::ChooseInstructionByOperands(Arch::Mnemonic mnemonic, const InstructionStmt::Operands_t& operands, std::optional<size_t> stmtOffset) const
+{
+    auto classes = ClassifyOperands(operands, stmtOffset);
 
-    return mostAppropriateInstruction;
+    return InstructionSelector::Select(mnemonic, std::span(classes.data(), classes.size()));
 }
 
-bool CodeGenerator::IsExpressionHasAddressSymbol(Expression* expression) const
+bool CodeGenerator::IsExpressionHasAddressSymbol(const Expression* expression) const
 {
     bool result = false;
 
-    if (expression->Is<BinaryExpr>())
+    for (SymbolId dependency : expression->GetDependencies())
     {
-        BinaryExpr* binaryExpr = expression->GetAs<BinaryExpr>();
+        const Symbol* symbol = context->GetSymbolTable().FindSymbol(dependency);
 
-        result = IsExpressionHasAddressSymbol(binaryExpr->lhs.get());
-        result |= IsExpressionHasAddressSymbol(binaryExpr->rhs.get());
-    }
-    else if (expression->Is<UnaryExpr>())
-    {
-        result = IsExpressionHasAddressSymbol(expression->GetAs<UnaryExpr>()->GetExpression());
-    }
-    else if (expression->Is<ParenExpr>())
-    {
-        result = IsExpressionHasAddressSymbol(expression->GetAs<ParenExpr>()->GetExpression());
-    }
-    else if (expression->Is<SymbolExpr>())
-    {
-        SymbolExpr* symbolExpr = expression->GetAs<SymbolExpr>();
-
-        if (context->GetSymbolTable().HasSymbol(symbolExpr->GetName()) == false)
-        {
-            context->Error((std::string("Undefined symbol: ") + expression->GetAs<SymbolExpr>()->GetName()).c_str());
-        }
+        if (symbol == nullptr)
+            context->Error((std::string("Undefined symbol: ") + context->GetInterner().Get(dependency)).c_str());
         else
-        {
-            auto& symbol = context->GetSymbolTable().GetSymbol(symbolExpr->GetName());
-            result = symbol.GetDeclaration().IsAddress();
-        }
+            result |= symbol->GetDeclaration().IsAddress();
     }
 
     return result;
 }
 
-void CodeGenerator::MakeAbsoluteLinkTarget(Expression* expression, uint8_t offset, uint8_t size)
+void CodeGenerator::MakeAbsoluteLinkTarget(Expression* expression, size_t offset, uint8_t size)
 {
     currentSection->GetLinkingTargets().push_back(LinkingTarget
     (
         expression,
         LinkingTarget::Kind::AbsoluteAddress,
-        currentSectionCode->code.size() + offset,
+        offset,
         size
     ));
 }
 
-void CodeGenerator::MakeRelativeLinkTarget(Expression* expression, uint8_t offset, uint8_t size, uint8_t relativeOrigin)
+void CodeGenerator::MakeRelativeLinkTarget(Expression* expression, size_t offset, uint8_t size, size_t relativeOrigin)
 {
     currentSection->GetLinkingTargets().push_back(LinkingTarget
     (
         expression,
-        currentSectionCode->code.size() + offset,
+        offset,
         size,
-        currentSectionCode->code.size() + relativeOrigin
+        relativeOrigin
     ));
 }
 
-void CodeGenerator::MakeValueLinkTarget(Expression* expression, uint8_t offset, uint8_t size, LinkingTarget::Type type)
+void CodeGenerator::MakeValueLinkTarget(Expression* expression, size_t offset, uint8_t size, LinkingTarget::Type type)
 {
     currentSection->GetLinkingTargets().push_back(LinkingTarget
     (
         expression,
         LinkingTarget::Kind::Value,
-        currentSectionCode->code.size() + offset,
+        offset,
         size
     ));
 }
 
-bool CodeGenerator::ResolveExpressionDependencies(
-    const AST::Expression* expression,
-    const std::string& symbolName,
-    std::unordered_map<std::string, int64_t>& symbolMap
-) const 
+std::optional<int64_t> CodeGenerator::ResolveExpression(const Expression* expression) const
 {
-    auto dependencies = expression->GetDependecies();
-
-    if (dependencies.empty() == false) {
-        for (auto dependency : dependencies) {
-            if (symbolMap.count(*dependency) > 0)
-                continue;
-
-            if (context->GetSymbolTable().HasSymbol(*dependency) == false)
-                return false;
+    return context->GetResolver().Resolve(*expression);
+}
 
-            const SymbolDecl& declaration = context->GetSymbolTable().GetSymbol(*dependency).GetDeclaration();
+void CodeGenerator::ProccessNode(Node& node)
+{
+    Visit(node, [this](auto& current)
+    {
+        using Node_t = std::remove_cvref_t<decltype(current)>;
 
-            if (declaration.Is<ConstantDecl>() == false)
-                return false;
+        if constexpr (std::is_base_of_v<Statement, Node_t>)
+        {
+            CodeEmitter emitter(*currentSectionCode);
 
-            if (ResolveExpressionDependencies(&declaration.GetAs<ConstantDecl>()->GetExpression(), declaration.GetName(), symbolMap) == false)
-                return false;
+            try {
+                //Concrete type is known, no virtual call
+                current.Node_t::CodeGen(*this, emitter);
+            }
+            catch (std::exception& e) {
+                emitter.Rollback();
+                context->Error(e.what(), current.GetLocation(), current.GetLength());
+            }
         }
-    }
-    if (symbolName.empty() == false && symbolMap.count(symbolName) == 0) {
-        symbolMap.insert({ symbolName, expression->Resolve(symbolMap) });
-    }
+        else if constexpr (std::is_same_v<Node_t, SectionDecl>)
+        {
+            ChangeCurrentSection(current.GetName(), current.GetMaxCodeSize());
+        }
+        else if constexpr (std::is_same_v<Node_t, LableDecl>)
+        {
+            if (lableSlots != nullptr)
+            {
+                lableSlots->emplace_back(&current, currentSectionCode->code.size());
+                return;
+            }
 
-    return true;
+            context->GetSymbolTable().EvaluateSymbol
+            (
+                current.GetId(),
+                SymbolValue(SymbolValue::Kind::Address, currentSectionCode->code.size())
+            );
+        }
+    });
 }
 
-std::optional<int64_t> CodeGenerator::ResolveExpression(const Expression* expression) const
+void CodeGenerator::ProccessBlocks(AbstractSyntaxTree& ast)
 {
-    std::optional<int64_t> result;
-    std::unordered_map<std::string, int64_t> symbolMap;
-    
-    if (ResolveExpressionDependencies(expression, std::string(), symbolMap) == false)
-        return result;
+    //Consecutive nodes of one section, encoded from offset zero into a private section of the same name
+    struct Block
+    {
+        Section* section = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
 
-    result = expression->Resolve(symbolMap);
+        Section encoded;
+        LableSlots lables;
+    };
 
-    return result;
-}
+    const size_t workersCount = context->GetCodegenWorkersCount();
+    const size_t blockNodes = std::max(minBlockNodes, ast.size() / (workersCount * blocksPerWorker));
 
-TranslationUnit& CodeGenerator::ProccessAST(AbstractSyntaxTree& ast)
-{
+    std::vector<Block> blocks;
+    std::unordered_map<Section*, size_t> maxCodeSizes;
+    size_t blockBegin = 0;
+
+    auto closeBlock = [&](size_t blockEnd)
+    {
+        if (blockBegin < blockEnd)
+            blocks.push_back({ currentSection, blockBegin, blockEnd, Section(currentSection->GetName()), LableSlots() });
+
+        blockBegin = blockEnd;
+    };
+
+    //Sections are made here in the same order as serially, workers only look them up by name
     ChangeCurrentSection(context->UnnamedSection.data());
 
-    for (auto& node : ast)
+    for (size_t i = 0; i < ast.size(); ++i)
     {
-        if (node->Is<Statement>())
+        Node& node = *ast[i];
+
+        if (node.Is<SectionDecl>())
         {
-            try {
-                currentSectionCode->operator<<(node->GetAs<Statement>()->CodeGen(*this));
-            }
-            catch (std::exception& e) {
-                context->Error(e.what(), node->GetLocation(), node->GetLength());
-            }
+            closeBlock(i);
+            ChangeCurrentSection(node.GetAs<SectionDecl>()->GetName());
+
+            maxCodeSizes[currentSection] += node.GetAs<SectionDecl>()->GetMaxCodeSize();
+            blockBegin = i + 1;
         }
-        else if (node->Is<SectionDecl>())
+        //Padding depends on the position in the section, it's added when the block is placed
+        else if (node.Is<AlignStmt>())
         {
-            ChangeCurrentSection(node->GetAs<SectionDecl>()->GetName());
+            closeBlock(i);
         }
-        else if (node->Is<SymbolDecl>())
+        //Origin and stack size are shared by all sections, they emit no code
+        else if (node.Is<OrgStmt>() || node.Is<StackStmt>())
         {
-            if (node->Is<LableDecl>())
-                context->GetSymbolTable().EvaluateSymbol
-                (
-                    node->GetAs<SymbolDecl>()->GetName(),
-                    SymbolValue(SymbolValue::Kind::Address, currentSectionCode->code.size())
-                );
+            ProccessNode(node);
         }
+
+        if (i + 1 - blockBegin >= blockNodes)
+            closeBlock(i + 1);
+    }
+
+    closeBlock(ast.size());
+
+    std::atomic<size_t> nextBlock = 0;
+
+    auto work = [&]()
+    {
+        CodeGenerator generator(*context);
+
+        for (size_t i = nextBlock.fetch_add(1, std::memory_order_relaxed); i < blocks.size(); i = nextBlock.fetch_add(1, std::memory_order_relaxed))
+        {
+            Block& block = blocks[i];
+
+            generator.currentSection = &block.encoded;
+            generator.currentSectionCode = &block.encoded.GetCode();
+            generator.lableSlots = &block.lables;
+
+            for (size_t j = block.begin; j < block.end; ++j)
+                if (ast[j]->Is<AlignStmt>() == false && ast[j]->Is<OrgStmt>() == false && ast[j]->Is<StackStmt>() == false)
+                    generator.ProccessNode(*ast[j]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (size_t i = 1; i < std::min(workersCount, blocks.size()); ++i)
+        workers.emplace_back(work);
+
+    work();
+
+    for (auto& worker : workers)
+        worker.join();
+
+    //Base of each block is the size of its section so far, code is copied once and offsets are moved by the base
+    for (Block& block : blocks)
+    {
+        currentSection = block.section;
+        currentSectionCode = &block.section->GetCode();
+
+        if (auto it = maxCodeSizes.find(currentSection); it != maxCodeSizes.end())
+        {
+            currentSectionCode->code.reserve(currentSectionCode->code.size() + it->second);
+            maxCodeSizes.erase(it);
+        }
+
+        if (ast[block.begin]->Is<AlignStmt>())
+            ProccessNode(*ast[block.begin]);
+
+        const size_t base = currentSectionCode->code.size();
+        const auto& code = block.encoded.GetCode().code;
+
+        currentSectionCode->code.insert(currentSectionCode->code.end(), code.begin(), code.end());
+
+        for (LinkingTarget& target : block.encoded.GetLinkingTargets())
+        {
+            target.Rebase(base);
+            currentSection->GetLinkingTargets().push_back(std::move(target));
+        }
+
+        //A redeclared lable keeps the address of its last declaration, as when it's evaluated in source order
+        for (auto [lable, offset] : block.lables)
+            if (&context->GetSymbolTable().GetSymbol(lable->GetId()).GetDeclaration() == lable)
+                context->GetSymbolTable().EvaluateSymbol(lable->GetId(), SymbolValue(SymbolValue::Kind::Address, base + offset));
+    }
+}
+
+TranslationUnit& CodeGenerator::ProccessAST(AbstractSyntaxTree& ast)
+{
+    if (context->GetCodegenWorkersCount() > 1)
+    {
+        ProccessBlocks(ast);
+    }
+    else
+    {
+        ChangeCurrentSection(context->UnnamedSection.data());
+
+        for (auto& node : ast)
+            ProccessNode(*node);
     }
 
     return context->GetTranslationUnit();
-}
\ No newline at end of file
+}
@@ -6,6 +6,7 @@
 #include "context/context.h"
 #include "syntax/ast.h"
 #include "context/translation-unit.h"
+#include "instruction-selector.h"
 
 #include "utils/small-vector.h"
 
@@ -19,13 +20,26 @@ namespace ASM::Codegen
         MachineCode* currentSectionCode = nullptr;
         Section* currentSection = nullptr;
 
-        void ChangeCurrentSection(const std::string& sectionName);
+        //Reserves code for maxCodeSize more bytes, so statements are emitted without reallocations
+        void ChangeCurrentSection(const std::string& sectionName, size_t maxCodeSize = 0);
 
-        bool ResolveExpressionDependencies(
-            const AST::Expression* expression,
-            const std::string& symbolName,
-            std::unordered_map<std::string, int64_t>& symbolMap
-        ) const;
+        //Lable addresses of one block, written to the symbol table once the block is placed in its section
+        using LableSlots = std::vector<std::pair<const AST::LableDecl*, size_t>>;
+        //Lables are evaluated in place if null
+        LableSlots* lableSlots = nullptr;
+
+        //Blocks are cut at least this long, if the AST is big enough
+        static constexpr size_t minBlockNodes = 1024;
+        //Keeps workers busy when blocks take different time
+        static constexpr size_t blocksPerWorker = 4;
+
+        void ProccessNode(AST::Node& node);
+        //Splits sections into blocks of statements, encodes each block on a worker thread,
+        //then places the blocks in their sections in source order
+        void ProccessBlocks(AbstractSyntaxTree& ast);
+
+        //Reused between operands, cleared before each evaluation
+        mutable SymbolValues symbolValues;
 
         static constexpr uint8_t highPriority = 2;
         static constexpr uint8_t lowPriority = 1;
@@ -41,16 +55,20 @@ namespace ASM::Codegen
         uint8_t EvaluateDependentOperandSize(const AST::Expression* operand, int64_t& approximateValue) const;
         SmallVector<Arch::OperandEvaluation, 4> EvaluateOperands(const AST::InstructionStmt::Operands_t& operands) const;
 
-        inline static uint8_t GetNopInstructionOpcode() { return Arch::Arch8086::InstructionSet.at("NOP").back().opcode.back(); }
+        inline static uint8_t GetNopInstructionOpcode() { return Arch::Arch8086::InstructionSet.at(Arch::Mnemonic::NOP).back().opcode.back(); }
 
         inline AssemblyContext& GetContext() const { return *context; }
 
-        const Arch::Instruction* ChooseInstructionByOperands(const std::string& mnemonic, const AST::InstructionStmt::Operands_t& operands, std::optional<size_t> stmtOffset) const;
-        bool IsExpressionHasAddressSymbol(AST::Expression* expression) const;
+        SmallVector<InstructionSelector::OperandClass, 4> ClassifyOperands(const AST::InstructionStmt::Operands_t& operands, std::optional<size_t> stmtOffset) const;
+
+        //Looks the form up by operand classes
+        const Arch::Instruction* ChooseInstructionByOperands(Arch::Mnemonic mnemonic, const AST::InstructionStmt::Operands_t& operands, std::optional<size_t> stmtOffset) const;
+        bool IsExpressionHasAddressSymbol(const AST::Expression* expression) const;
 
-        void MakeAbsoluteLinkTarget(AST::Expression* expression, uint8_t offset, uint8_t size);
-        void MakeRelativeLinkTarget(AST::Expression* expression, uint8_t offset, uint8_t size, uint8_t relativeOrigin);
-        void MakeValueLinkTarget(AST::Expression* expression, uint8_t offset, uint8_t size, LinkingTarget::Type type);
+        //Offsets are positions in the current section, see CodeEmitter::GetPosition
+        void MakeAbsoluteLinkTarget(AST::Expression* expression, size_t offset, uint8_t size);
+        void MakeRelativeLinkTarget(AST::Expression* expression, size_t offset, uint8_t size, size_t relativeOrigin);
+        void MakeValueLinkTarget(AST::Expression* expression, size_t offset, uint8_t size, LinkingTarget::Type type);
 
         std::optional<int64_t> ResolveExpression(const AST::Expression* expression) const;
 
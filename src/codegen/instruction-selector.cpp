@@ -0,0 +1,303 @@
+#include "instruction-selector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "code-generator.h"
+
+using namespace ASM;
+using namespace ASM::AST;
+using namespace ASM::Codegen;
+
+namespace
+{
+    //Chosen forms of one mnemonic, by signatures of up to maxTabledOperands operands
+    struct SelectionTable
+    {
+        //Entry values, otherwise index of the form plus formsBase
+        static constexpr uint8_t notSelected = 0;
+        static constexpr uint8_t noForm = 1;
+        static constexpr uint8_t formsBase = 2;
+
+        //Filled concurrently in chunked mode, every thread would store the same value
+        std::unique_ptr<std::atomic<uint8_t>[]> entries;
+        //Bit per operands count that some form has
+        uint32_t operandCounts = 0;
+    };
+
+    std::array<std::once_flag, Arch::MnemonicsCount> tableFlags;
+    std::array<SelectionTable, Arch::MnemonicsCount> tables;
+
+    constexpr size_t GetSignatureIndex(std::span<const InstructionSelector::OperandClass> operands)
+    {
+        //Signatures of each operands count are placed one after another
+        size_t base = 0;
+        size_t index = 0;
+        size_t countSize = 1;
+
+        for (size_t i = 0; i < operands.size(); ++i)
+        {
+            base += countSize;
+            countSize *= InstructionSelector::classesCount;
+            index = index * InstructionSelector::classesCount + operands[i];
+        }
+
+        return base + index;
+    }
+
+    void BuildTable(Arch::Mnemonic mnemonic)
+    {
+        SelectionTable& table = tables[static_cast<size_t>(mnemonic)];
+        const auto& forms = Arch::Arch8086::InstructionSet.at(mnemonic);
+        size_t maxOperands = 0;
+
+        assert(forms.size() < 0x100 - SelectionTable::formsBase);
+
+        for (auto& form : forms)
+        {
+            table.operandCounts |= (1u << form.operands.size());
+
+            if (form.operands.size() <= InstructionSelector::maxTabledOperands)
+                maxOperands = std::max(maxOperands, form.operands.size());
+        }
+
+        //Index past the last signature with maxOperands operands
+        std::array<InstructionSelector::OperandClass, InstructionSelector::maxTabledOperands> last;
+        last.fill(InstructionSelector::classesCount - 1);
+
+        table.entries = std::make_unique<std::atomic<uint8_t>[]>(
+            GetSignatureIndex(std::span(last.data(), maxOperands)) + 1
+        );
+    }
+}
+
+InstructionSelector::OperandClass InstructionSelector::ClassifyMemory(bool isDirect, uint8_t byteSize)
+{
+    assert(byteSize < sizeClassesCount);
+
+    return static_cast<OperandClass>(memoryClassesBase + (isDirect ? sizeClassesCount : 0) + byteSize);
+}
+
+InstructionSelector::OperandClass InstructionSelector::ClassifyImmediate(uint8_t byteSize, Arch::OperandEvaluation::Sign sign, Distance distance, bool isOne)
+{
+    assert(byteSize < sizeClassesCount);
+
+    if (isOne)
+        return static_cast<OperandClass>(oneClassesBase + static_cast<size_t>(distance));
+
+    return static_cast<OperandClass>(immediateClassesBase +
+        (byteSize * signsCount + static_cast<size_t>(sign)) * distancesCount + static_cast<size_t>(distance));
+}
+
+InstructionSelector::Distance InstructionSelector::GetDistance(int64_t approximateValue, std::optional<size_t> stmtOffset)
+{
+    if (stmtOffset.has_value() == false || approximateValue == 0)
+        return Distance::None;
+
+    int64_t offset = approximateValue - static_cast<int64_t>(*stmtOffset);
+
+    return (offset > 127 || offset < -128 ? Distance::Far : Distance::Near);
+}
+
+void InstructionSelector::MakeEvaluation(OperandClass operandClass, Arch::OperandEvaluation& evaluation)
+{
+    auto& types = evaluation.expectedTypes;
+
+    if (operandClass < memoryClassesBase)
+    {
+        RegisterExpr registerExpr(static_cast<Arch::RegisterIdentifier>(operandClass));
+
+        evaluation.kind = Arch::OperandEvaluation::Kind::Register;
+        evaluation.minRequiredSize = registerExpr.GetSize();
+
+        switch (registerExpr.GetGroup())
+        {
+        case Arch::RegisterGroup::Segment:
+            types.push_back(Arch::OpType::sreg);
+            break;
+        case Arch::RegisterGroup::Control:
+            types.push_back(Arch::OpType::creg);
+            break;
+        default:
+            types.push_back(Arch::OpType::r);
+            types.push_back(Arch::OpType::rm);
+            break;
+        }
+
+        Arch::OpType directRegisterOpType = CodeGenerator::GetDirectEncodingOfRegisterOpType(&registerExpr);
+
+        if (directRegisterOpType != Arch::OpType::none)
+            types.push_back(directRegisterOpType);
+    }
+    else if (operandClass < immediateClassesBase)
+    {
+        const size_t memoryClass = operandClass - memoryClassesBase;
+
+        evaluation.kind = Arch::OperandEvaluation::Kind::Memory;
+        evaluation.minRequiredSize = (memoryClass % sizeClassesCount) * 8;
+
+        types.push_back(Arch::OpType::m);
+        types.push_back(Arch::OpType::rm);
+
+        if (memoryClass >= sizeClassesCount)
+            types.push_back(Arch::OpType::moffs);
+    }
+    else
+    {
+        Distance distance;
+
+        evaluation.kind = Arch::OperandEvaluation::Kind::Immediate;
+
+        if (operandClass >= oneClassesBase)
+        {
+            distance = static_cast<Distance>(operandClass - oneClassesBase);
+            evaluation.minRequiredSize = 8;
+
+            types.push_back(Arch::OpType::ONE);
+        }
+        else
+        {
+            const size_t immediateClass = operandClass - immediateClassesBase;
+
+            distance = static_cast<Distance>(immediateClass % distancesCount);
+            evaluation.sign = static_cast<Arch::OperandEvaluation::Sign>(immediateClass / distancesCount % signsCount);
+            evaluation.minRequiredSize = immediateClass / (distancesCount * signsCount) * 8;
+        }
+
+        //Offsets from a statement at zero
+        if (distance == Distance::Near)
+            evaluation.approximateValue = 1;
+        else if (distance == Distance::Far)
+            evaluation.approximateValue = 0x100;
+
+        types.push_back(Arch::OpType::imm);
+        types.push_back(Arch::OpType::rel);
+        types.push_back(Arch::OpType::ptr);
+    }
+}
+
+const Arch::Instruction* InstructionSelector::SelectByScoring(const Arch::InstructionTable::Forms_t& forms, std::span<const Arch::OperandEvaluation> operands, std::optional<size_t> stmtOffset)
+{
+    const Arch::Instruction* mostAppropriateInstruction = nullptr;
+    int8_t priority = 0;
+
+    for (auto& instruction : forms)
+    {
+        if (operands.size() != instruction.operands.size())
+            continue;
+
+        int8_t currentPriority = operands.size() == 0 ? 1 : 0;
+
+        for (size_t i = 0; i < instruction.operands.size(); ++i)
+        {
+            auto& operandPrototype = instruction.operands[i];
+            auto& evaluatedOperand = operands[i];
+
+            //Check if operand types suitable
+            if (std::find
+                (
+                    evaluatedOperand.expectedTypes.begin(),
+                    evaluatedOperand.expectedTypes.end(),
+                    operandPrototype.type
+                ) == evaluatedOperand.expectedTypes.end())
+            { currentPriority = 0; break; }
+
+            if (operandPrototype.type == Arch::OpType::rel && stmtOffset.has_value() && evaluatedOperand.approximateValue != 0) [[unlikely]]
+            {
+                int64_t offset = evaluatedOperand.approximateValue - static_cast<int64_t>(*stmtOffset);
+
+                if (forms.size() > 1 && (offset > 127 || offset < -128) &&
+                    operandPrototype.size < 16)
+                    { currentPriority = 0; break; }
+
+                currentPriority += 2;
+            }
+            else
+            {
+                //Check if operands size matches
+                if (operandPrototype.size != 0 && (
+                        operandPrototype.size < evaluatedOperand.minRequiredSize ||
+                        (
+                            (
+                                evaluatedOperand.Is(Arch::OperandEvaluation::Kind::Register) ||
+                                (evaluatedOperand.Is(Arch::OperandEvaluation::Kind::Memory) &&
+                                evaluatedOperand.minRequiredSize != 0)
+                            )
+                            &&
+                            evaluatedOperand.minRequiredSize != operandPrototype.size
+                        )
+                    ))
+                { currentPriority = 0; break; }
+
+                if (instruction.feature == Arch::SpecialFeature::SignExtended) [[unlikely]]
+                {
+                    if (evaluatedOperand.sign == Arch::OperandEvaluation::Sign::Signed)
+                        ++currentPriority;
+                    else if (evaluatedOperand.sign == Arch::OperandEvaluation::Sign::Unsigned)
+                        currentPriority -= evaluatedOperand.minRequiredSize;
+                    else if (evaluatedOperand.kind == Arch::OperandEvaluation::Kind::Immediate &&
+                            operandPrototype.size == 1)
+                        { currentPriority = 0; break; }
+                }
+
+                if (operandPrototype.size != 0 &&
+                    operandPrototype.size == evaluatedOperand.minRequiredSize)
+                    ++currentPriority;
+            }
+
+            currentPriority += CodeGenerator::GetOperandTypePriority(operandPrototype.type);
+        }
+
+        if (currentPriority > 0)
+            currentPriority += CodeGenerator::GetOpEncodingPriority(instruction.opencode);
+
+        if (currentPriority > priority)
+        {
+            mostAppropriateInstruction = &instruction;
+            priority = currentPriority;
+        }
+    }
+
+    return mostAppropriateInstruction;
+}
+
+const Arch::Instruction* InstructionSelector::Select(Arch::Mnemonic mnemonic, std::span<const OperandClass> operands)
+{
+    const auto& forms = Arch::Arch8086::InstructionSet.at(mnemonic);
+    SelectionTable& table = tables[static_cast<size_t>(mnemonic)];
+
+    std::call_once(tableFlags[static_cast<size_t>(mnemonic)], BuildTable, mnemonic);
+
+    if ((table.operandCounts & (1u << operands.size())) == 0)
+        return nullptr;
+
+    auto score = [&]()
+    {
+        SmallVector<Arch::OperandEvaluation, 4> evaluations(operands.size());
+
+        for (size_t i = 0; i < operands.size(); ++i)
+            MakeEvaluation(operands[i], evaluations[i]);
+
+        return SelectByScoring(forms, std::span(evaluations.data(), evaluations.size()), 0);
+    };
+
+    if (operands.size() > maxTabledOperands) [[unlikely]]
+        return score();
+
+    std::atomic<uint8_t>& entry = table.entries[GetSignatureIndex(operands)];
+    uint8_t value = entry.load(std::memory_order_relaxed);
+
+    if (value == SelectionTable::notSelected) [[unlikely]]
+    {
+        const Arch::Instruction* instruction = score();
+
+        value = (instruction == nullptr ? SelectionTable::noForm :
+            static_cast<uint8_t>(instruction - forms.data() + SelectionTable::formsBase));
+
+        entry.store(value, std::memory_order_relaxed);
+    }
+
+    return (value == SelectionTable::noForm ? nullptr : &forms[value - SelectionTable::formsBase]);
+}
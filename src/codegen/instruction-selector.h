@@ -0,0 +1,69 @@
+#ifndef __ASM_INSTRUCTION_SELECTOR_H
+#define __ASM_INSTRUCTION_SELECTOR_H
+
+#include <optional>
+#include <span>
+
+#include "arch/8086/arch-8086.h"
+
+namespace ASM::Codegen
+{
+    //Chooses instruction forms by operand classes.
+    //Form selection depends only on a few properties of each operand: the register itself, the size of
+    //a memory operand and whether it has registers, the size and sign of an immediate and how far it is
+    //from the statement. These are packed into a class, and the form chosen for a signature is kept
+    //in a per-mnemonic table, so each signature is scored against the forms only once per process.
+    class InstructionSelector
+    {
+    public:
+        using OperandClass = uint8_t;
+
+        //Offset of an immediate from the statement, checked against forms with relative operands
+        enum class Distance : uint8_t
+        {
+            //No check, the value is unknown or zero
+            None,
+            Near,
+            Far
+        };
+
+        //Memory operands and immediates take at most 8 bytes
+        static constexpr size_t sizeClassesCount = 9;
+        static constexpr size_t signsCount = 3;
+        static constexpr size_t distancesCount = 3;
+
+        static constexpr size_t registerClassesCount = static_cast<size_t>(Arch::RegisterIdentifier::CR7) + 1;
+        static constexpr size_t memoryClassesBase = registerClassesCount;
+        static constexpr size_t immediateClassesBase = memoryClassesBase + 2 * sizeClassesCount;
+        //Immediate equal to 1 also matches forms with implicit one
+        static constexpr size_t oneClassesBase = immediateClassesBase + sizeClassesCount * signsCount * distancesCount;
+        static constexpr size_t classesCount = oneClassesBase + distancesCount;
+
+        //Signatures with more operands are scored every time, only three-operand IMUL has them
+        static constexpr size_t maxTabledOperands = 2;
+
+        static_assert(classesCount <= 256, "Operand class must fit a byte");
+
+        static inline OperandClass ClassifyRegister(Arch::RegisterIdentifier reg) { return static_cast<OperandClass>(reg); }
+        static OperandClass ClassifyMemory(bool isDirect, uint8_t byteSize);
+        //Value 1 always takes a byte and has no sign
+        static OperandClass ClassifyImmediate(uint8_t byteSize, Arch::OperandEvaluation::Sign sign, Distance distance, bool isOne = false);
+        static Distance GetDistance(int64_t approximateValue, std::optional<size_t> stmtOffset);
+
+        //Fills a default evaluation with the same expected types, size and sign as any operand of the class
+        static void MakeEvaluation(OperandClass operandClass, Arch::OperandEvaluation& evaluation);
+
+        //Scores every form against evaluated operands, tables are filled with its results
+        static const Arch::Instruction* SelectByScoring
+        (
+            const Arch::InstructionTable::Forms_t& forms,
+            std::span<const Arch::OperandEvaluation> operands,
+            std::optional<size_t> stmtOffset
+        );
+
+        //Null if no form accepts the operands
+        static const Arch::Instruction* Select(Arch::Mnemonic mnemonic, std::span<const OperandClass> operands);
+    };
+}
+
+#endif
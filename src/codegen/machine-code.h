@@ -41,6 +41,35 @@ namespace ASM::Codegen
             return &code;
         }
     };
+
+    //Appends code of a statement straight to the section code, positions are section offsets.
+    //Section code is reserved from the parser estimate, so statements don't allocate.
+    class CodeEmitter
+    {
+    private:
+        std::vector<uint8_t>* code = nullptr;
+        size_t begin = 0;
+    public:
+        CodeEmitter(MachineCode& sectionCode) : code(&sectionCode.code), begin(sectionCode.code.size()) {}
+
+        inline size_t GetPosition() const { return code->size(); }
+        inline size_t GetStmtSize() const { return code->size() - begin; }
+
+        inline uint8_t& Back() { return code->back(); }
+
+        inline CodeEmitter& operator<<(uint8_t byte)
+        {
+            code->push_back(byte);
+
+            return *this;
+        }
+
+        inline void Push(const uint8_t* data, size_t size) { code->insert(code->end(), data, data + size); }
+        inline void Fill(size_t count, uint8_t byte) { code->resize(code->size() + count, byte); }
+
+        //Drops the code of a failed statement
+        inline void Rollback() { code->resize(begin); }
+    };
 }
 
 #endif
\ No newline at end of file
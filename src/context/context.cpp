@@ -6,15 +6,10 @@
 
 using namespace ASM;
 
-AssemblyContext::AssemblyContext(std::istream& sourceStream, const InstructionSet_t& instructionSet) : instructionSet(&instructionSet)
-{
-    currentSource.resize(sourceStream.rdbuf()->in_avail());
-
-    sourceStream.read(currentSource.begin().base(), currentSource.size());
-}
-
 Message* AssemblyContext::GetLastError()
 {
+    std::lock_guard<std::mutex> lock(messageMutex);
+
     Message* error = lastError;
 
     lastError = nullptr;
@@ -24,6 +19,8 @@ Message* AssemblyContext::GetLastError()
 
 std::unique_ptr<Message> AssemblyContext::GetMessage()
 {
+    std::lock_guard<std::mutex> lock(messageMutex);
+
     if (messageQueue.empty())
         return nullptr;
 
@@ -34,20 +31,22 @@ std::unique_ptr<Message> AssemblyContext::GetMessage()
     return std::move(message);
 }
 
-Message* AssemblyContext::MakeMessage(Message::Kind kind, const char* message, SourceLocation location, size_t length)
+Message* AssemblyContext::MakeMessage(Message::Kind kind, const char* message, SourceLocation location, size_t length) const
 {
     Message* result;
 
-    if (location.sourcePointer == nullptr)
+    if (location.sourcePointer == nullptr || lineIndex.Contains(location.sourcePointer) == false)
         result = new Message(kind, message);
     else
-        result = new PointedMessage(kind, location, length, message);
+        result = new PointedMessage(kind, location, length, lineIndex, message);
 
     return result;
 }
 
 void AssemblyContext::Info(const char* message, SourceLocation location, size_t length)
 {
+    std::lock_guard<std::mutex> lock(messageMutex);
+
     messageQueue.push(nullptr);
     messageQueue.back().reset(MakeMessage(Message::Kind::Info, message, location, length));
 
@@ -56,6 +55,8 @@ void AssemblyContext::Info(const char* message, SourceLocation location, size_t
 
 void AssemblyContext::Warn(const char* message, SourceLocation location, size_t length)
 {
+    std::lock_guard<std::mutex> lock(messageMutex);
+
     messageQueue.push(nullptr);
     messageQueue.back().reset(MakeMessage(Message::Kind::Warning, message, location, length));
 
@@ -64,6 +65,8 @@ void AssemblyContext::Warn(const char* message, SourceLocation location, size_t
 
 void AssemblyContext::Error(const char* message, SourceLocation location, size_t length)
 {
+    std::lock_guard<std::mutex> lock(messageMutex);
+
     messageQueue.push(nullptr);
     messageQueue.back().reset(MakeMessage(Message::Kind::Error, message, location, length));
 
@@ -6,10 +6,14 @@
 #include <iostream>
 #include <queue>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "message.h"
+#include "source-buffer.h"
 #include "symbol-table.h"
+#include "symbol-resolver.h"
+#include "string-interner.h"
 #include "syntax/declarations.h"
 #include "translation-unit.h"
 #include "arch/arch.h"
@@ -21,55 +25,85 @@ namespace ASM
     enum class AssemblyMode : uint8_t
     {
         Direct,
-        Parallel
+        Parallel,
+        Chunked
     };
 
     class AssemblyContext
     {
     public:
-        using InstructionSet_t = std::unordered_map<std::string, std::vector<Arch::Instruction>>;
+        using InstructionSet_t = Arch::InstructionTable;
     private:
-        std::string currentSource;
+        SourceBuffer currentSource;
+        LineIndex lineIndex{ currentSource.GetText() };
 
         const InstructionSet_t* instructionSet = nullptr; 
 
+        //Identifiers are interned by the lexer, symbols are keyed by their ids
+        StringInterner interner;
+
         TranslationUnit translationUnit;
         SymbolTable symbolTable;
+        //Constant values shared by codegen and linker
+        SymbolResolver resolver{ *this };
 
         std::ostream* logStream = &std::cout;
         std::queue<std::unique_ptr<Message>> messageQueue;
+        //Lexer and parser may report concurrently in parallel mode
+        std::mutex messageMutex;
 
         size_t errorsCount = 0;
 
         Message* lastError = nullptr;
 
         AssemblyMode mode = AssemblyMode::Direct;
+        size_t workersCount = 1;
+        //Independent of the parse mode
+        size_t codegenWorkersCount = 1;
 
-        static Message* MakeMessage(Message::Kind kind, const char* message, SourceLocation location, size_t length);
+        Message* MakeMessage(Message::Kind kind, const char* message, SourceLocation location, size_t length) const;
     public:
+        AssemblyContext(SourceBuffer&& source, const InstructionSet_t& instructionSet) :
+            currentSource(std::move(source)), instructionSet(&instructionSet) {}
+
         AssemblyContext(std::string&& source, const InstructionSet_t& instructionSet) :
-            currentSource(source), instructionSet(&instructionSet) {}
+            currentSource(std::move(source)), instructionSet(&instructionSet) {}
 
         AssemblyContext(const std::string& source, const InstructionSet_t& instructionSet) :
             currentSource(source), instructionSet(&instructionSet) {}
 
-        AssemblyContext(std::istream& sourceStream, const InstructionSet_t& instructionSet);
+        AssemblyContext(std::istream& sourceStream, const InstructionSet_t& instructionSet) :
+            currentSource(sourceStream), instructionSet(&instructionSet) {}
 
         static constexpr std::string_view UnnamedSection = "$unnamed";
 
         inline void SetDirectMode() { mode = AssemblyMode::Direct; };
-        inline void SetParallelMode(Lexer& lexer) { mode = AssemblyMode::Parallel; }
+        //Lexer runs on its own thread and feeds the parser through a token ring
+        inline void SetParallelMode() { mode = AssemblyMode::Parallel; }
+        //Source is split at line boundaries and the chunks are parsed on separate threads
+        inline void SetChunkedMode(size_t workers) { mode = AssemblyMode::Chunked; workersCount = (workers > 0 ? workers : 1); }
+        //Statements are encoded in blocks on separate threads, see CodeGenerator::ProccessBlocks
+        inline void SetParallelCodegen(size_t workers) { codegenWorkersCount = (workers > 0 ? workers : 1); }
+
+        inline StringInterner& GetInterner() { return interner; }
+        inline const StringInterner& GetInterner() const { return interner; }
 
         inline SymbolTable& GetSymbolTable() { return symbolTable; }
         inline const SymbolTable& GetSymbolTable() const { return symbolTable; }
 
+        inline SymbolResolver& GetResolver() { return resolver; }
+
         inline void SetLogOutput(std::ostream& stream) { logStream = &stream; }
         inline void SetInstructionSet(const InstructionSet_t& set) { instructionSet = &set; }
 
         inline bool IsCurrentMode(AssemblyMode intendentMode) const { return (mode == intendentMode); }
+        inline size_t GetWorkersCount() const { return workersCount; }
+        inline size_t GetCodegenWorkersCount() const { return codegenWorkersCount; }
 
         inline std::ostream& GetLogOutput() const { return *logStream; }
-        inline const std::string& GetSource() const { return currentSource; }
+        //Source text is null terminated
+        inline std::string_view GetSource() const { return currentSource.GetText(); }
+        inline const LineIndex& GetLineIndex() const { return lineIndex; }
         inline bool HasMessages() const { return (messageQueue.empty() == false); }
 
         Message* GetLastError();
@@ -0,0 +1,51 @@
+#include "line-index.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "syntax/scanner.h"
+
+using namespace ASM;
+
+void LineIndex::Build() const
+{
+    //Source is null terminated, newlines are found by the block scanner
+    const char* const begin = source.data();
+    const char* pos = begin;
+
+    lineStarts.reserve(source.size() / 32 + 1);
+    lineStarts.push_back(0);
+
+    while (*(pos = Scanner::SkipToLineEnd(pos)) == '\n')
+        lineStarts.push_back(++pos - begin);
+}
+
+size_t LineIndex::FindLine(size_t offset) const
+{
+    std::call_once(buildFlag, &LineIndex::Build, this);
+
+    return (std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin()) - 1;
+}
+
+LineIndex::Position LineIndex::GetPosition(const char* pointer) const
+{
+    assert(Contains(pointer));
+
+    const size_t offset = pointer - source.data();
+    const size_t line = FindLine(offset);
+
+    return { static_cast<unsigned int>(line), static_cast<unsigned int>(offset - lineStarts[line]) };
+}
+
+const char* LineIndex::GetLineEnd(const char* pointer) const
+{
+    assert(Contains(pointer));
+
+    const size_t line = FindLine(pointer - source.data());
+
+    //Next line starts right after the '\n'
+    if (line + 1 < lineStarts.size())
+        return source.data() + lineStarts[line + 1] - 1;
+
+    return source.data() + source.size();
+}
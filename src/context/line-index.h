@@ -0,0 +1,43 @@
+#ifndef __LINE_INDEX_H
+#define __LINE_INDEX_H
+
+#include <string_view>
+#include <vector>
+#include <mutex>
+
+namespace ASM
+{
+    //Offsets of line beginnings in a source, built on the first query.
+    //Locations are resolved to line and column only when a message is printed.
+    class LineIndex
+    {
+    public:
+        //Zero based
+        struct Position
+        {
+            unsigned int line = 0;
+            unsigned int column = 0;
+        };
+    private:
+        std::string_view source;
+
+        mutable std::vector<size_t> lineStarts;
+        mutable std::once_flag buildFlag;
+
+        void Build() const;
+
+        size_t FindLine(size_t offset) const;
+    public:
+        LineIndex(std::string_view source) : source(source) {}
+
+        inline bool Contains(const char* pointer) const
+        { return (pointer >= source.data() && pointer <= source.data() + source.size()); }
+
+        Position GetPosition(const char* pointer) const;
+
+        //Returns position of the '\n' or '\0' that ends the line containing the pointer
+        const char* GetLineEnd(const char* pointer) const;
+    };
+}
+
+#endif
@@ -28,17 +28,16 @@ std::string Message::What() const
 
 std::string PointedMessage::What() const
 {
-    std::string result = GetKindString() + " \033[1mline:" + std::to_string(location.line + 1) + ":\033[0m " +
-        content + " \"\033[1;35m";
+    const LineIndex::Position position = lineIndex->GetPosition(location.sourcePointer);
+
+    std::string result = GetKindString() + " \033[1mline:" + std::to_string(position.line + 1) + ":" +
+        std::to_string(position.column + 1) + ":\033[0m " + content + " \"\033[1;35m";
 
     const char* endPos;
 
     if (length == 0)
     {
-        endPos = location.sourcePointer;
-
-        while(*endPos != '\n' && *endPos != '\0')
-            ++endPos;
+        endPos = lineIndex->GetLineEnd(location.sourcePointer);
     }
     else
     {
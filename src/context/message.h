@@ -4,6 +4,7 @@
 #include <string>
 
 #include "source-location.h"
+#include "line-index.h"
 
 namespace ASM
 {
@@ -39,15 +40,17 @@ namespace ASM
     private:
         SourceLocation location;
         size_t length;
+
+        const LineIndex* lineIndex;
     public:
-        PointedMessage(Kind kind, SourceLocation location, size_t length, const std::string& content) : 
-            Message(kind, content), location(location), length(length) {}
+        PointedMessage(Kind kind, SourceLocation location, size_t length, const LineIndex& lineIndex, const std::string& content) :
+            Message(kind, content), location(location), length(length), lineIndex(&lineIndex) {}
 
-        PointedMessage(Kind kind, SourceLocation location, size_t length, std::string&& content) :
-            Message(kind, content), location(location), length(length) {}
+        PointedMessage(Kind kind, SourceLocation location, size_t length, const LineIndex& lineIndex, std::string&& content) :
+            Message(kind, content), location(location), length(length), lineIndex(&lineIndex) {}
 
-        PointedMessage(Kind kind, SourceLocation location, size_t length, const char* content) :
-            Message(kind, content), location(location), length(length) {}
+        PointedMessage(Kind kind, SourceLocation location, size_t length, const LineIndex& lineIndex, const char* content) :
+            Message(kind, content), location(location), length(length), lineIndex(&lineIndex) {}
 
         std::string What() const override;
     };
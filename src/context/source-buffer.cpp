@@ -0,0 +1,167 @@
+#include "source-buffer.h"
+
+#include <iterator>
+
+#ifdef _WIN32
+    #define ASM_SOURCE_BUFFER_NO_MMAP
+    #include <fstream>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+using namespace ASM;
+
+SourceBuffer::SourceBuffer(std::istream& sourceStream)
+{
+    text.assign(std::istreambuf_iterator<char>(sourceStream), std::istreambuf_iterator<char>());
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : text(std::move(other.text)), mapping(other.mapping), mappingSize(other.mappingSize), mappedTextSize(other.mappedTextSize)
+{
+    other.mapping = nullptr;
+    other.mappingSize = 0;
+    other.mappedTextSize = 0;
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    Unmap();
+
+    text = std::move(other.text);
+    mapping = other.mapping;
+    mappingSize = other.mappingSize;
+    mappedTextSize = other.mappedTextSize;
+
+    other.mapping = nullptr;
+    other.mappingSize = 0;
+    other.mappedTextSize = 0;
+
+    return *this;
+}
+
+#ifdef ASM_SOURCE_BUFFER_NO_MMAP
+
+void SourceBuffer::Unmap() {}
+
+void SourceBuffer::Prefetch() const {}
+
+bool SourceBuffer::Open(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+
+    if (in.is_open() == false)
+        return false;
+
+    Unmap();
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    return (in.bad() == false);
+}
+
+#else
+
+void SourceBuffer::Unmap()
+{
+    if (mapping == nullptr)
+        return;
+
+    munmap(const_cast<char*>(mapping), mappingSize);
+
+    mapping = nullptr;
+    mappingSize = 0;
+    mappedTextSize = 0;
+}
+
+void SourceBuffer::Prefetch() const
+{
+    if (mapping != nullptr)
+        madvise(const_cast<char*>(mapping), mappedTextSize, MADV_WILLNEED);
+}
+
+bool SourceBuffer::Map(int fd, size_t fileSize)
+{
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    const size_t fileMappingSize = (fileSize + pageSize - 1) / pageSize * pageSize;
+
+    //Reserve one more zeroed page behind the file, so the text is null terminated
+    //even if its size is a multiple of the page size. Tail of the last file page is zeroed by the kernel.
+    void* region = mmap(nullptr, fileMappingSize + pageSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (region == MAP_FAILED)
+        return false;
+
+    if (mmap(region, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(region, fileMappingSize + pageSize);
+        return false;
+    }
+
+    madvise(region, fileSize, MADV_SEQUENTIAL);
+
+    mapping = static_cast<const char*>(region);
+    mappingSize = fileMappingSize + pageSize;
+    mappedTextSize = fileSize;
+
+    return true;
+}
+
+bool SourceBuffer::ReadAll(int fd)
+{
+    constexpr size_t chunkSize = 64 * 1024;
+
+    size_t size = 0;
+
+    text.clear();
+
+    while (true)
+    {
+        text.resize(size + chunkSize);
+
+        const ssize_t bytesRead = read(fd, text.data() + size, chunkSize);
+
+        if (bytesRead < 0)
+            return false;
+
+        if (bytesRead == 0)
+            break;
+
+        size += bytesRead;
+    }
+
+    text.resize(size);
+
+    return true;
+}
+
+bool SourceBuffer::Open(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    Unmap();
+
+    struct stat fileStat;
+    bool success = false;
+
+    //Pipes, character devices and empty files are read, regular files are mapped
+    if (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0)
+        success = Map(fd, fileStat.st_size);
+
+    if (success == false)
+        success = ReadAll(fd);
+
+    close(fd);
+
+    return success;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __SOURCE_BUFFER_H
+#define __SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <istream>
+
+namespace ASM
+{
+    //Read-only source text, always followed by '\0'.
+    //Regular files are memory mapped and scanned in place, pipes and streams are read once into memory.
+    //The text stays in place once the buffer is owned by a context, so source locations are valid for the whole build.
+    class SourceBuffer
+    {
+    private:
+        std::string text;
+
+        const char* mapping = nullptr;
+        size_t mappingSize = 0;
+        size_t mappedTextSize = 0;
+
+        void Unmap();
+
+        bool Map(int fd, size_t fileSize);
+        bool ReadAll(int fd);
+    public:
+        SourceBuffer() = default;
+        SourceBuffer(std::string&& source) : text(std::move(source)) {}
+        SourceBuffer(const std::string& source) : text(source) {}
+        SourceBuffer(std::istream& sourceStream);
+
+        SourceBuffer(SourceBuffer&& other) noexcept;
+        SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+        SourceBuffer(const SourceBuffer&) = delete;
+        SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+        ~SourceBuffer() { Unmap(); }
+
+        //Returns false if the file can't be opened or read
+        bool Open(const std::string& path);
+
+        //Asks the kernel to read mapped pages in the background, before they are scanned
+        void Prefetch() const;
+
+        inline bool IsMapped() const { return (mapping != nullptr); }
+
+        inline const char* GetData() const { return (IsMapped() ? mapping : text.c_str()); }
+        inline size_t GetSize() const { return (IsMapped() ? mappedTextSize : text.size()); }
+        inline std::string_view GetText() const { return std::string_view(GetData(), GetSize()); }
+    };
+}
+
+#endif
@@ -8,8 +8,8 @@ namespace ASM
         SourceLocation() = default;
         SourceLocation(const char* sourcePtr) : sourcePointer(sourcePtr) {}
 
+        //Line and column are looked up in the context line index when needed
         const char* sourcePointer = nullptr;
-        unsigned int line = 0;
 
         inline const char* operator--() { return (--sourcePointer); }
         inline const char* operator--(int) { return (sourcePointer--); }
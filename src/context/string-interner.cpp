@@ -0,0 +1,57 @@
+#include "string-interner.h"
+
+#include <cassert>
+
+using namespace ASM;
+
+const std::string StringInterner::EmptyString;
+
+StringInterner::~StringInterner()
+{
+    for (auto& segment : segments)
+        delete[] segment.load(std::memory_order_relaxed);
+}
+
+std::string& StringInterner::MakeSlot(SymbolId id)
+{
+    const size_t segment = GetSegmentIndex(id);
+
+    assert(segment < maxSegments);
+
+    std::string* storage = segments[segment].load(std::memory_order_acquire);
+
+    if (storage == nullptr) [[unlikely]]
+    {
+        //Threads of different shards may need the same segment at once, only one allocation is kept
+        std::string* newStorage = new std::string[firstSegmentSize << segment];
+
+        if (segments[segment].compare_exchange_strong(storage, newStorage, std::memory_order_acq_rel))
+            storage = newStorage;
+        else
+            delete[] newStorage;
+    }
+
+    return storage[id - GetSegmentBegin(segment)];
+}
+
+SymbolId StringInterner::Intern(std::string_view string)
+{
+    Shard& shard = shards[std::hash<std::string_view>()(string) % shardsCount];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto iterator = shard.ids.find(string);
+
+    if (iterator != shard.ids.end())
+        return iterator->second;
+
+    const SymbolId id = count.fetch_add(1, std::memory_order_acq_rel);
+    std::string& slot = MakeSlot(id);
+
+    slot.assign(string);
+
+    //Key points to the stored string, it never moves
+    shard.ids.emplace(std::string_view(slot), id);
+
+    return id;
+}
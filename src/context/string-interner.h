@@ -0,0 +1,72 @@
+#ifndef __STRING_INTERNER_H
+#define __STRING_INTERNER_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ASM
+{
+    //Dense index of an interned string, symbols are keyed by it everywhere after parsing
+    using SymbolId = uint32_t;
+
+    static constexpr SymbolId InvalidSymbolId = UINT32_MAX;
+
+    //Maps strings to dense ids and back. Interning may be done from several threads at once,
+    //lookups are split between shards by hash so lexers of different chunks rarely wait for each other.
+    //Strings never move once interned, references returned by Get stay valid for the interner lifetime.
+    class StringInterner
+    {
+    private:
+        static constexpr size_t shardsCount = 16;
+        static constexpr size_t cacheLineSize = 64;
+
+        //Segment n holds firstSegmentSize << n strings, so ids stay dense without moving storage
+        static constexpr size_t firstSegmentSize = 1024;
+        static constexpr size_t maxSegments = 32;
+
+        struct alignas(cacheLineSize) Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string_view, SymbolId> ids;
+        };
+
+        std::array<Shard, shardsCount> shards;
+        std::array<std::atomic<std::string*>, maxSegments> segments{};
+
+        std::atomic<SymbolId> count = 0;
+
+        static inline size_t GetSegmentIndex(SymbolId id) { return std::bit_width(id / firstSegmentSize + 1) - 1; }
+        static inline size_t GetSegmentBegin(size_t segment) { return firstSegmentSize * ((size_t(1) << segment) - 1); }
+
+        std::string& MakeSlot(SymbolId id);
+    public:
+        StringInterner() = default;
+        StringInterner(const StringInterner&) = delete;
+        StringInterner& operator=(const StringInterner&) = delete;
+
+        ~StringInterner();
+
+        //Name of declarations that didn't get one yet
+        static const std::string EmptyString;
+
+        SymbolId Intern(std::string_view string);
+
+        //Id must be returned by Intern of this interner
+        inline const std::string& Get(SymbolId id) const
+        {
+            const size_t segment = GetSegmentIndex(id);
+
+            return segments[segment].load(std::memory_order_acquire)[id - GetSegmentBegin(segment)];
+        }
+
+        inline size_t GetSize() const { return count.load(std::memory_order_acquire); }
+    };
+}
+
+#endif
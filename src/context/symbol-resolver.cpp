@@ -0,0 +1,144 @@
+#include "symbol-resolver.h"
+
+#include "context.h"
+
+using namespace ASM;
+using namespace ASM::AST;
+
+void SymbolResolver::Build()
+{
+    struct Frame
+    {
+        SymbolId id;
+        const ConstantDecl* declaration;
+        uint32_t nextDependency = 0;
+        State state = State::Constant;
+        bool inCycle = false;
+    };
+
+    const SymbolTable& symbolTable = context->GetSymbolTable();
+    std::vector<Frame> stack;
+
+    for (SymbolId root : symbolTable.GetSymbolIds())
+    {
+        const SymbolDecl& rootDeclaration = symbolTable.GetSymbol(root).GetDeclaration();
+
+        if (rootDeclaration.Is<ConstantDecl>() == false || states.Contains(root))
+            continue;
+
+        stack.push_back({ root, rootDeclaration.GetAs<ConstantDecl>() });
+        states.Set(root, State::Visiting);
+
+        while (stack.empty() == false)
+        {
+            Frame& frame = stack.back();
+            auto dependencies = frame.declaration->GetExpression().GetDependencies();
+
+            if (frame.nextDependency < dependencies.size())
+            {
+                const SymbolId dependency = dependencies[frame.nextDependency++];
+                const State* dependencyState = states.Find(dependency);
+
+                if (dependencyState != nullptr && *dependencyState == State::Visiting)
+                {
+                    //Every constant on the stack down to the dependency is a part of the cycle
+                    for (size_t i = stack.size(); i-- > 0;)
+                    {
+                        stack[i].inCycle = true;
+
+                        if (stack[i].id == dependency)
+                            break;
+                    }
+                }
+                else if (dependencyState != nullptr)
+                {
+                    frame.state = Merge(frame.state, *dependencyState);
+                }
+                else
+                {
+                    const Symbol* symbol = symbolTable.FindSymbol(dependency);
+
+                    if (symbol != nullptr && symbol->GetDeclaration().Is<ConstantDecl>())
+                    {
+                        stack.push_back({ dependency, symbol->GetDeclaration().GetAs<ConstantDecl>() });
+                        states.Set(dependency, State::Visiting);
+                    }
+                    else
+                    {
+                        frame.state = Merge(frame.state, State::Address);
+                    }
+                }
+
+                continue;
+            }
+
+            //All dependencies are done
+            Frame done = frame;
+            stack.pop_back();
+
+            if (done.inCycle)
+            {
+                done.state = State::Cyclic;
+
+                context->Error(
+                    "Unable to evaluate constant, it depends on itself",
+                    done.declaration->GetLocation(),
+                    done.declaration->GetLength()
+                );
+            }
+
+            states.Set(done.id, done.state);
+
+            if (done.state == State::Constant)
+                constants.Insert(done.id, done.declaration->GetExpression().Resolve(constants));
+            if (done.state != State::Cyclic)
+                evaluationOrder.push_back(done.id);
+
+            if (stack.empty() == false)
+                stack.back().state = Merge(stack.back().state, done.state);
+        }
+    }
+}
+
+const int64_t* SymbolResolver::FindConstant(SymbolId id)
+{
+    EnsureBuilt();
+
+    return constants.Find(id);
+}
+
+std::optional<int64_t> SymbolResolver::Resolve(const Expression& expression)
+{
+    EnsureBuilt();
+
+    for (SymbolId dependency : expression.GetDependencies())
+        if (constants.Contains(dependency) == false)
+            return std::nullopt;
+
+    return expression.Resolve(constants);
+}
+
+void SymbolResolver::EvaluateAll(SymbolValues& values)
+{
+    EnsureBuilt();
+
+    const SymbolTable& symbolTable = context->GetSymbolTable();
+
+    for (SymbolId id : evaluationOrder)
+    {
+        if (const int64_t* value = constants.Find(id))
+        {
+            values.Insert(id, *value);
+            continue;
+        }
+
+        const Expression& expression = symbolTable.GetSymbol(id).GetDeclaration().GetAs<ConstantDecl>()->GetExpression();
+        bool isDefined = true;
+
+        for (SymbolId dependency : expression.GetDependencies())
+            isDefined &= values.Contains(dependency);
+
+        if (isDefined)
+            values.Insert(id, expression.Resolve(values));
+    }
+}
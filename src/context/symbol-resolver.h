@@ -0,0 +1,64 @@
+#ifndef __ASM_SYMBOL_RESOLVER_H
+#define __ASM_SYMBOL_RESOLVER_H
+
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "string-interner.h"
+#include "syntax/expressions.h"
+#include "utils/id-map.h"
+
+namespace ASM
+{
+    class AssemblyContext;
+
+    //Evaluates EQU constants once for the whole translation unit.
+    //The constant dependency graph is built on first use, after parsing, and walked iteratively
+    //in topological order, so long chains cost linear time and don't grow the call stack.
+    class SymbolResolver
+    {
+    private:
+        enum class State : uint8_t
+        {
+            //Value is known without any address
+            Constant,
+            //Depends on lables, extern or undeclared symbols, known only at linking
+            Address,
+            //Part of a cycle, or depends on one
+            Cyclic,
+            //On the walk stack while building
+            Visiting
+        };
+
+        static inline State Merge(State lhs, State rhs) { return (lhs > rhs ? lhs : rhs); }
+
+        AssemblyContext* context = nullptr;
+
+        std::once_flag buildFlag;
+
+        IdMap<State> states;
+        //Only constants in the Constant state
+        SymbolValues constants;
+        //Dependencies come before dependents, cyclic constants are left out
+        std::vector<SymbolId> evaluationOrder;
+
+        void Build();
+        inline void EnsureBuilt() { std::call_once(buildFlag, &SymbolResolver::Build, this); }
+    public:
+        SymbolResolver(AssemblyContext& context) : context(&context) {}
+
+        //Null if the symbol isn't a constant or depends on an address
+        const int64_t* FindConstant(SymbolId id);
+        //Value of an expression that refers only to constants
+        std::optional<int64_t> Resolve(const AST::Expression& expression);
+
+        //Constants with known values are kept in the map, the rest are evaluated with the given values.
+        //Constants with undefined dependencies are not inserted.
+        void EvaluateAll(SymbolValues& values);
+
+        inline const std::vector<SymbolId>& GetEvaluationOrder() { EnsureBuilt(); return evaluationOrder; }
+    };
+}
+
+#endif
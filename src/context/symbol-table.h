@@ -1,41 +1,44 @@
 #ifndef __ASM_SYMBOL_TABLE_H
 #define __ASM_SYMBOL_TABLE_H
 
-#include <unordered_map>
+#include <vector>
 
 #include "symbol.h"
+#include "string-interner.h"
+#include "utils/id-map.h"
 
 namespace ASM
 {
     class SymbolTable
     {
     private:
-        std::unordered_map<std::string, Symbol> symbolsMap;
+        //Indexed by interned symbol name
+        IdMap<Symbol> symbols;
 
         size_t origin = 0;
     public:
-        inline void AddSymbol(Symbol&& symbol) { symbolsMap[symbol.GetDeclaration().GetName()] = symbol; }
-        inline void EvaluateSymbol(const std::string& symbolName, SymbolValue& value)
+        inline void AddSymbol(Symbol&& symbol) { symbols.Set(symbol.GetDeclaration().GetId(), symbol); }
+        inline void EvaluateSymbol(SymbolId id, SymbolValue& value)
         {
-            symbolsMap.at(symbolName).Evaluate(value);
+            symbols.At(id).Evaluate(value);
         }
 
-        inline void EvaluateSymbol(const std::string& symbolName, SymbolValue&& value)
+        inline void EvaluateSymbol(SymbolId id, SymbolValue&& value)
         {
-            symbolsMap.at(symbolName).Evaluate(value);
+            symbols.At(id).Evaluate(value);
         }
 
-        inline const std::unordered_map<std::string, Symbol>& GetSymbolsMap() const {
-            return symbolsMap;
-        }
+        //Declaration order
+        inline const std::vector<SymbolId>& GetSymbolIds() const { return symbols.GetKeys(); }
 
-        inline const Symbol& GetSymbol(const std::string& symbolName) const { return symbolsMap.at(symbolName); }
+        inline const Symbol& GetSymbol(SymbolId id) const { return symbols.At(id); }
+        inline const Symbol* FindSymbol(SymbolId id) const { return symbols.Find(id); }
 
-        inline bool HasSymbol(const std::string& symbolName) const { return symbolsMap.count(symbolName) > 0; }
+        inline bool HasSymbol(SymbolId id) const { return symbols.Contains(id); }
 
         inline size_t GetOrigin() const { return origin; }
         inline void SetOrigin(size_t value) { origin = value; }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
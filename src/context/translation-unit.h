@@ -3,9 +3,11 @@
 
 #include <unordered_map>
 #include <map>
+#include <deque>
 #include <string>
 
 #include "section.h"
+#include "utils/arena.h"
 
 namespace ASM
 {
@@ -13,11 +15,17 @@ namespace ASM
     {
     private:
         std::unordered_map<std::string, Section> sections;
+        //Owns all AST nodes, they are freed at once with the translation unit
+        Arena nodeArena;
+        //Used by parser workers in chunked mode, one per chunk
+        std::deque<Arena> chunkArenas;
 
         size_t addressSymbolsOrigin = 0;
         size_t requiredStackSize = 0;
     public:
         inline std::unordered_map<std::string, Section>& GetSectionMap() { return sections; }
+        inline Arena& GetNodeArena() { return nodeArena; }
+        inline Arena& MakeNodeArena() { return chunkArenas.emplace_back(); }
 
         inline Section& GetOrMakeSection(const std::string_view& name)
         { 
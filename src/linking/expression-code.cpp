@@ -0,0 +1,221 @@
+#include "expression-code.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace ASM;
+using namespace ASM::AST;
+
+ExpressionCode::Op ExpressionCode::GetBinaryOp(char operation)
+{
+    switch (operation)
+    {
+    case '+': return Op::Add;
+    case '-': return Op::Sub;
+    case '*': return Op::Mul;
+    case '/': return Op::Div;
+    case '>': return Op::Shr;
+    case '<': return Op::Shl;
+    case '^': return Op::Xor;
+    case '|': return Op::Or;
+    case '&': return Op::And;
+    default:
+        assert(false);
+        return Op::Add;
+    }
+}
+
+ExpressionCode::Op ExpressionCode::GetUnaryOp(char operation)
+{
+    switch (operation)
+    {
+    case '-': return Op::Negate;
+    case '~': return Op::Not;
+    default:
+        assert(false);
+        return Op::Negate;
+    }
+}
+
+void ExpressionCode::Compile(const Expression* expression)
+{
+    //Filled once the code doesn't fit the inline buffers
+    std::unique_ptr<Spill> builder;
+
+    auto spillInline = [&]()
+    {
+        builder = std::make_unique<Spill>();
+        builder->ops.assign(inlineOps.begin(), inlineOps.begin() + opsCount);
+        builder->symbols.assign(inlineSymbols.begin(), inlineSymbols.begin() + symbolsCount);
+        builder->values.assign(inlineValues.begin(), inlineValues.begin() + valuesCount);
+    };
+
+    auto opAt = [&](size_t index) -> Op& { return builder ? builder->ops[index] : inlineOps[index]; };
+    auto valueAt = [&](size_t index) -> int64_t& { return builder ? builder->values[index] : inlineValues[index]; };
+
+    uint32_t stackDepth = 0;
+
+    auto emitOp = [&](Op op)
+    {
+        if (builder == nullptr && opsCount == inlineOpsCount)
+            spillInline();
+
+        if (builder)
+            builder->ops.push_back(op);
+        else
+            inlineOps[opsCount] = op;
+
+        ++opsCount;
+    };
+
+    auto emitValue = [&](int64_t value)
+    {
+        if (builder == nullptr && valuesCount == inlineValuesCount)
+            spillInline();
+
+        if (builder)
+            builder->values.push_back(value);
+        else
+            inlineValues[valuesCount] = value;
+
+        ++valuesCount;
+        emitOp(Op::PushValue);
+
+        maxStackDepth = std::max(maxStackDepth, ++stackDepth);
+    };
+
+    auto emitSymbol = [&](SymbolId id)
+    {
+        if (builder == nullptr && symbolsCount == inlineSymbolsCount)
+            spillInline();
+
+        if (builder)
+            builder->symbols.push_back(id);
+        else
+            inlineSymbols[symbolsCount] = id;
+
+        ++symbolsCount;
+        emitOp(Op::PushSymbol);
+
+        maxStackDepth = std::max(maxStackDepth, ++stackDepth);
+    };
+
+    auto emitUnary = [&](Op op)
+    {
+        if (opAt(opsCount - 1) == Op::PushValue)
+        {
+            int64_t& value = valueAt(valuesCount - 1);
+            value = (op == Op::Negate ? -value : ~value);
+            return;
+        }
+
+        emitOp(op);
+    };
+
+    auto emitBinary = [&](Op op)
+    {
+        --stackDepth;
+
+        //Both operands are immediates, like in `lable + 2 * 4`
+        if (opsCount >= 2 && opAt(opsCount - 1) == Op::PushValue && opAt(opsCount - 2) == Op::PushValue &&
+            (op != Op::Div || valueAt(valuesCount - 1) != 0))
+        {
+            valueAt(valuesCount - 2) = Apply(op, valueAt(valuesCount - 2), valueAt(valuesCount - 1));
+
+            if (builder)
+            {
+                builder->ops.pop_back();
+                builder->values.pop_back();
+            }
+
+            --opsCount;
+            --valuesCount;
+            return;
+        }
+
+        emitOp(op);
+    };
+
+    //Post-order walk, the second pass over a node emits its operation.
+    //Scratch is kept per thread, targets are made for every relocation during codegen.
+    thread_local std::vector<std::pair<const Expression*, bool>> pending;
+
+    pending.clear();
+    pending.emplace_back(expression, false);
+
+    while (pending.empty() == false)
+    {
+        auto [node, expanded] = pending.back();
+        pending.pop_back();
+
+        switch (node->GetKind())
+        {
+        case NodeKind::NumberExpr:
+            emitValue(node->GetAs<NumberExpr>()->value);
+            break;
+        case NodeKind::RegisterExpr:
+            emitValue(0);
+            break;
+        case NodeKind::LiteralExpr:
+            emitValue(node->GetAs<LiteralExpr>()->Resolve());
+            break;
+        case NodeKind::SymbolExpr:
+            emitSymbol(node->GetAs<SymbolExpr>()->GetId());
+            break;
+        case NodeKind::DuplicateExpr:
+            pending.emplace_back(node->GetAs<DuplicateExpr>()->GetValueExpression(), false);
+            break;
+        case NodeKind::ParenExpr:
+        case NodeKind::MemoryExpr:
+            pending.emplace_back(node->GetAs<ParenExpr>()->GetExpression(), false);
+            break;
+        case NodeKind::UnaryExpr:
+        {
+            const UnaryExpr* unaryExpr = node->GetAs<UnaryExpr>();
+
+            if (expanded)
+            {
+                if (unaryExpr->GetOperation() != '+')
+                    emitUnary(GetUnaryOp(unaryExpr->GetOperation()));
+            }
+            else
+            {
+                pending.emplace_back(node, true);
+                pending.emplace_back(unaryExpr->GetExpression(), false);
+            }
+            break;
+        }
+        case NodeKind::BinaryExpr:
+        {
+            const BinaryExpr* binaryExpr = node->GetAs<BinaryExpr>();
+
+            if (expanded)
+            {
+                emitBinary(GetBinaryOp(binaryExpr->operation));
+            }
+            else
+            {
+                pending.emplace_back(node, true);
+                pending.emplace_back(binaryExpr->rhs, false);
+                pending.emplace_back(binaryExpr->lhs, false);
+            }
+            break;
+        }
+        default:
+            assert(false);
+            break;
+        }
+    }
+
+    if (builder)
+        spill = std::move(builder);
+}
+
+int64_t ExpressionCode::Evaluate(const SymbolValues& symbolValues) const
+{
+    return Run(GetOps(), GetSymbols().data(), GetValues().data(), maxStackDepth, [&](SymbolId id)
+    {
+        const int64_t* value = symbolValues.Find(id);
+        return (value != nullptr ? *value : 0);
+    });
+}
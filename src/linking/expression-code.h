@@ -0,0 +1,152 @@
+#ifndef __ASM_EXPRESSION_CODE_H
+#define __ASM_EXPRESSION_CODE_H
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "syntax/expressions.h"
+
+namespace ASM
+{
+    //Expression flattened to postfix code over symbol ids and immediates.
+    //Made once when a linking target is created, so the linker doesn't walk the tree for every relocation.
+    //Typical relocations (`lable`, `table + 4`, `a - b`) fit the inline buffers, bigger ones are spilled to the heap.
+    class ExpressionCode
+    {
+    public:
+        enum class Op : uint8_t
+        {
+            PushValue,
+            PushSymbol,
+            Negate,
+            Not,
+            Add,
+            Sub,
+            Mul,
+            Div,
+            Shr,
+            Shl,
+            Xor,
+            Or,
+            And
+        };
+    private:
+        static constexpr size_t inlineOpsCount = 16;
+        static constexpr size_t inlineSymbolsCount = 4;
+        static constexpr size_t inlineValuesCount = 2;
+        static constexpr size_t inlineStackSize = 16;
+
+        struct Spill
+        {
+            std::vector<Op> ops;
+            std::vector<SymbolId> symbols;
+            std::vector<int64_t> values;
+        };
+
+        std::array<Op, inlineOpsCount> inlineOps{};
+        std::array<SymbolId, inlineSymbolsCount> inlineSymbols{};
+        std::array<int64_t, inlineValuesCount> inlineValues{};
+
+        //Set only if the code didn't fit, shared between copies of the target
+        std::shared_ptr<const Spill> spill;
+
+        uint32_t opsCount = 0;
+        uint32_t symbolsCount = 0;
+        uint32_t valuesCount = 0;
+        uint32_t maxStackDepth = 0;
+
+        static Op GetBinaryOp(char operation);
+        static Op GetUnaryOp(char operation);
+
+        static inline int64_t Apply(Op op, int64_t lhs, int64_t rhs)
+        {
+            switch (op)
+            {
+            case Op::Add: return lhs + rhs;
+            case Op::Sub: return lhs - rhs;
+            case Op::Mul: return lhs * rhs;
+            case Op::Div: return lhs / rhs;
+            case Op::Shr: return lhs >> rhs;
+            case Op::Shl: return lhs << rhs;
+            case Op::Xor: return lhs ^ rhs;
+            case Op::Or:  return lhs | rhs;
+            case Op::And: return lhs & rhs;
+            default:
+                assert(false);
+                return 0;
+            }
+        }
+
+        void Compile(const AST::Expression* expression);
+    public:
+        static constexpr uint8_t OpsCount = static_cast<uint8_t>(Op::And) + 1;
+
+        ExpressionCode() = default;
+        ExpressionCode(const AST::Expression* expression) { Compile(expression); }
+
+        inline std::span<const Op> GetOps() const { return { spill ? spill->ops.data() : inlineOps.data(), opsCount }; }
+        inline std::span<const int64_t> GetValues() const { return { spill ? spill->values.data() : inlineValues.data(), valuesCount }; }
+
+        //Symbols are not deduplicated, they come in order of appearance
+        inline std::span<const SymbolId> GetSymbols() const
+        {
+            return { spill ? spill->symbols.data() : inlineSymbols.data(), symbolsCount };
+        }
+
+        inline size_t GetSize() const { return opsCount; }
+        inline uint32_t GetMaxStackDepth() const { return maxStackDepth; }
+        inline bool IsInline() const { return spill == nullptr; }
+
+        //Missing symbols are evaluated as 0, like SymbolExpr::Resolve
+        int64_t Evaluate(const SymbolValues& symbolValues) const;
+
+        //Runs code stored outside of an ExpressionCode, like the code of a mapped object file.
+        //Values of symbols come from `getValue(symbol)`, symbols and values are taken in order of their push ops.
+        template<typename SymbolT, typename GetValueT>
+        static int64_t Run(std::span<const Op> ops, const SymbolT* symbols, const int64_t* values, uint32_t maxStackDepth, GetValueT&& getValue)
+        {
+            int64_t inlineStack[inlineStackSize];
+            std::unique_ptr<int64_t[]> heapStack;
+            int64_t* stack = inlineStack;
+
+            if (maxStackDepth > inlineStackSize) [[unlikely]]
+            {
+                heapStack = std::make_unique<int64_t[]>(maxStackDepth);
+                stack = heapStack.get();
+            }
+
+            size_t top = 0;
+
+            for (const Op op : ops)
+            {
+                switch (op)
+                {
+                case Op::PushValue:
+                    stack[top++] = *values++;
+                    break;
+                case Op::PushSymbol:
+                    stack[top++] = getValue(*symbols++);
+                    break;
+                case Op::Negate:
+                    stack[top - 1] = -stack[top - 1];
+                    break;
+                case Op::Not:
+                    stack[top - 1] = ~stack[top - 1];
+                    break;
+                default:
+                    --top;
+                    stack[top - 1] = Apply(op, stack[top - 1], stack[top]);
+                    break;
+                }
+            }
+
+            return (top > 0 ? stack[0] : 0);
+        }
+    };
+}
+
+#endif
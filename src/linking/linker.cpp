@@ -1,7 +1,9 @@
 #include "linker.h"
 
-#include <cmath>
+#include <array>
+#include <cstring>
 #include <limits>
+#include <algorithm>
 
 #include "raw-binary.h"
 
@@ -23,50 +25,47 @@ const std::unordered_map<std::string, unsigned int> Linker::segmentsPriorityMap
     {"STACK", 0}
 };
 
-size_t Linker::GetOrderedSectionOffset(const std::string& sectionName) {
-    return symbolMap.at('@' + sectionName) * 16;
+unsigned int Linker::GetSectionPriority(const std::string& name)
+{
+    auto priority = segmentsPriorityMap.find(name);
+
+    return (priority != segmentsPriorityMap.end() ? priority->second : 0);
 }
 
-void Linker::EvaluateSymbol(const Symbol& symbol, bool absoluteValue, unsigned int depth) {
-    if (symbol.GetDeclaration().Is<ConstantDecl>()) {
-        const ConstantDecl* constantDecl = symbol.GetDeclaration().GetAs<ConstantDecl>();
-        auto dependencies = constantDecl->GetExpression().GetDependecies();
+size_t Linker::GetOrderedSectionOffset(SymbolId sectionName) const {
+    const size_t* paragraph = sectionParagraphs.Find(sectionName);
 
-        for (auto depencency : dependencies)
-            if (symbolMap.count(*depencency) < 1) {
-                if (depth < maxEvalDepth) {
-                    EvaluateSymbol(context->GetSymbolTable().GetSymbol(*depencency), absoluteValue, depth + 1);
-                }
-                else {
-                    context->Error(
-                        "Unable to evaluate all symbols, two symbols points to each other or recursive evaluating take too much passes",
-                        symbol.GetDeclaration().GetLocation(),
-                        symbol.GetDeclaration().GetLength()
-                    );
-                    return;
-                }
-            }
+    return (paragraph != nullptr ? *paragraph * 16 : 0);
+}
+
+void Linker::EvaluateLable(const Symbol& symbol, bool absoluteValue) {
+    if (symbol.IsEvaluated() == false) [[unlikely]] {
+        std::string msg("Unevaluated address symbol at linking stage: \'");
+        msg += symbol.GetDeclaration().GetName() + '\''; 
 
-        int64_t value = constantDecl->GetExpression().Resolve(symbolMap);
-        symbolMap.insert({ constantDecl->GetName(), value });
+        context->Error(msg.c_str());
+        return;
     }
-    else if (symbol.GetDeclaration().Is<LableDecl>()) {
-        if (symbol.IsEvaluated() == false) [[unlikely]] {
-            std::string msg("Unevaluated address symbol at linking stage: \'");
-            msg += symbol.GetDeclaration().GetName() + '\''; 
 
-            context->Error(msg.c_str());
-            return;
-        }
+    const LableDecl* lableDecl = symbol.GetDeclaration().GetAs<LableDecl>();
+    int64_t value = symbol.GetValue().GetAsInt();
 
-        const LableDecl* lableDecl = symbol.GetDeclaration().GetAs<LableDecl>();
-        int64_t value = symbol.GetValue().GetAsInt();
+    if (absoluteValue)
+        value += context->GetSymbolTable().GetOrigin() + GetOrderedSectionOffset(lableDecl->GetRelatedSection()->GetId());
 
-        if (absoluteValue)
-            value += context->GetSymbolTable().GetOrigin() + GetOrderedSectionOffset(lableDecl->GetRelatedSection()->GetName());
+    symbolMap.Insert(lableDecl->GetId(), value);
+}
 
-        symbolMap.insert({ lableDecl->GetName(), value });
+void Linker::EvaluateSymbols(bool absoluteValue) {
+    for (SymbolId id : context->GetSymbolTable().GetSymbolIds()) {
+        const Symbol& symbol = context->GetSymbolTable().GetSymbol(id);
+
+        if (symbol.GetDeclaration().Is<LableDecl>())
+            EvaluateLable(symbol, absoluteValue);
     }
+
+    //Constants go after lables, in dependency order
+    context->GetResolver().EvaluateAll(symbolMap);
 }
 
 void Linker::OrderSections()
@@ -85,15 +84,7 @@ void Linker::OrderSections()
 
     std::sort(sectionOrder.begin(), sectionOrder.end(), [](const Section* a, const Section* b)
     {
-        unsigned int aPriority = 0;
-        unsigned int bPriority = 0;
-
-        if (segmentsPriorityMap.count(a->GetName()) > 0)
-            aPriority = segmentsPriorityMap.at(a->GetName());
-        if (segmentsPriorityMap.count(b->GetName()) > 0)
-            bPriority = segmentsPriorityMap.at(b->GetName());
-
-        return aPriority > bPriority; 
+        return GetSectionPriority(a->GetName()) > GetSectionPriority(b->GetName());
     });
 
     size_t value = 0;
@@ -107,15 +98,16 @@ void Linker::OrderSections()
             section->GetCode()->resize(section->GetCode()->size() + align, 0);
         }
 
-        symbolMap.insert({ '@' + section->GetName(), value });
+        sectionParagraphs.Insert(context->GetInterner().Intern(section->GetName()), value);
+        symbolMap.Insert(context->GetInterner().Intern('@' + section->GetName()), value);
         value += section->GetCode()->size() / 16;
     }
 }
 
-bool Linker::IsValidDependencies(const Expression* expression, std::vector<const std::string*>& dependencies)
+bool Linker::IsValidDependencies(const Expression* expression, std::span<const SymbolId> dependencies)
 {
     for (auto depencency : dependencies) {
-        if (symbolMap.count(*depencency) == 0) [[unlikely]] {
+        if (symbolMap.Contains(depencency) == false) [[unlikely]] {
             context->Error("Undefined symbol", expression->GetLocation(), expression->GetLength());
             return false;
         }
@@ -124,25 +116,66 @@ bool Linker::IsValidDependencies(const Expression* expression, std::vector<const
     return true;
 }
 
-bool Linker::IsValueCompatibleWithSize(int64_t value, const LinkingTarget& linkingTarget)
+Linker::ValueFit Linker::FitValue(int64_t value, uint8_t size)
 {
-    uint64_t maxValueForCurrentSize = std::pow(std::numeric_limits<uint8_t>::max(), linkingTarget.GetSize());
+    //Powers of 255 by target size, were computed with std::pow for every target
+    static constexpr auto maxValuesBySize = []()
+    {
+        std::array<uint64_t, sizeof(int64_t) + 1> result{};
+        result[0] = 1;
+
+        for (size_t i = 1; i < result.size(); ++i)
+            result[i] = result[i - 1] * std::numeric_limits<uint8_t>::max();
+
+        return result;
+    }();
+
+    assert(size < maxValuesBySize.size());
+
+    const uint64_t maxValueForCurrentSize = maxValuesBySize[size];
             
-    if ((value < 0 ? -value : value) > maxValueForCurrentSize) [[unlikely]] {
+    if ((value < 0 ? -value : value) > maxValueForCurrentSize) [[unlikely]]
+        return ValueFit::Overflow;
+
+    const int64_t min = - static_cast<int64_t>(maxValueForCurrentSize / 2);
+    const int64_t max = (maxValueForCurrentSize / 2) - 1;
+
+    return (value < min || value > max ? ValueFit::SignedOverflow : ValueFit::Fits);
+}
+
+bool Linker::IsValueCompatibleWithSize(int64_t value, const LinkingTarget& linkingTarget)
+{
+    const ValueFit fit = FitValue(value, linkingTarget.GetSize());
+
+    if (fit == ValueFit::Overflow) [[unlikely]] {
         context->Error("Value overflow while linking", linkingTarget.GetExpression()->GetLocation(), linkingTarget.GetExpression()->GetLength());
         return false;
     }
-    else {
-        const int64_t min = - static_cast<int64_t>(maxValueForCurrentSize / 2);
-        const int64_t max = (maxValueForCurrentSize / 2) - 1;
 
-        if (value < min || value > max)
-            context->Warn("Signed value may be corrupted", linkingTarget.GetExpression()->GetLocation(), linkingTarget.GetExpression()->GetLength());
-    }
+    if (fit == ValueFit::SignedOverflow)
+        context->Warn("Signed value may be corrupted", linkingTarget.GetExpression()->GetLocation(), linkingTarget.GetExpression()->GetLength());
 
     return true;
 }
 
+void Linker::SetExeStack(ExeObject& result, size_t stackSize)
+{
+    Codegen::MachineCode& code = result.code;
+
+    if (stackSize == 0) {
+        context->Warn("Stack missing");
+    }
+    else {
+        result.mzHeader.initialRelativeSS = code->size();
+        
+        if (code->size() % result.paragraphByteSize > 0)
+            result.mzHeader.initialRelativeSS += (result.paragraphByteSize - (code->size() % result.paragraphByteSize));
+
+        result.mzHeader.initialRelativeSS /= 16;
+        result.mzHeader.initialSp = stackSize;
+    }
+}
+
 void Linker::LinkRawBinary(RawBinary& result)
 {
     Codegen::MachineCode& code = result.GetCode();
@@ -152,8 +185,7 @@ void Linker::LinkRawBinary(RawBinary& result)
 
     OrderSections();
 
-    for (auto& pair : context->GetSymbolTable().GetSymbolsMap())
-        EvaluateSymbol(pair.second, true);
+    EvaluateSymbols(true);
 
     for (auto segment : sectionOrder)
     {
@@ -162,11 +194,11 @@ void Linker::LinkRawBinary(RawBinary& result)
 
         for (auto& linkingTarget : segment->GetLinkingTargets())
         {
-            auto dependencies = linkingTarget.GetExpression()->GetDependecies();
+            auto dependencies = linkingTarget.GetCode().GetSymbols();
             if (IsValidDependencies(linkingTarget.GetExpression(), dependencies) == false) [[unlikely]]
                 continue;
 
-            int64_t value = linkingTarget.GetExpression()->Resolve(symbolMap);
+            int64_t value = linkingTarget.GetCode().Evaluate(symbolMap);
 
             if (linkingTarget.GetKind() == LinkingTarget::Kind::RelativeAddress)
                 value -= (context->GetSymbolTable().GetOrigin() + linkingTarget.GetRelativeOrigin() + sectionBeginCodeIndex); 
@@ -190,8 +222,7 @@ void Linker::LinkExe(ExeObject& result)
     if (context->GetSymbolTable().GetOrigin() != 0)
         context->Warn("Origin offset not allowed with .EXE format - ignored");
 
-    for (auto& pair : context->GetSymbolTable().GetSymbolsMap())
-        EvaluateSymbol(pair.second, false);
+    EvaluateSymbols(false);
 
     for (auto segment : sectionOrder)
     {
@@ -200,19 +231,21 @@ void Linker::LinkExe(ExeObject& result)
 
         for (auto& linkingTarget : segment->GetLinkingTargets())
         {
-            auto dependencies = linkingTarget.GetExpression()->GetDependecies();
+            auto dependencies = linkingTarget.GetCode().GetSymbols();
             if (IsValidDependencies(linkingTarget.GetExpression(), dependencies) == false) [[unlikely]]
                 continue;
 
             for (auto depencency : dependencies)
             {
-                if (depencency->at(0) == '@' && context->GetTranslationUnit().GetSectionMap().count(depencency->c_str() + 1) > 0) {
+                const std::string& name = context->GetInterner().Get(depencency);
+
+                if (name[0] == '@' && context->GetTranslationUnit().GetSectionMap().count(name.c_str() + 1) > 0) {
                     result.relocationTable.push_back({ static_cast<uint16_t>(linkingTarget.GetSectionOffset() + sectionBeginCodeIndex), 0 });
                     break;
                 }
             }
 
-            int64_t value = linkingTarget.GetExpression()->Resolve(symbolMap);
+            int64_t value = linkingTarget.GetCode().Evaluate(symbolMap);
 
             if (linkingTarget.GetKind() == LinkingTarget::Kind::RelativeAddress)
                 value -= (linkingTarget.GetRelativeOrigin() + sectionBeginCodeIndex); 
@@ -226,17 +259,177 @@ void Linker::LinkExe(ExeObject& result)
         }
     }
 
-    if (context->GetTranslationUnit().GetRequiredStackSize() == 0) {
-        context->Warn("Stack missing");
+    SetExeStack(result, context->GetTranslationUnit().GetRequiredStackSize());
+}
+
+void Linker::OrderObjectSections(const ObjectFile& object)
+{
+    const auto sections = object.GetSections();
+
+    std::vector<unsigned int> priorities(sections.size());
+
+    objectSectionOrder.clear();
+    objectSectionSizes.assign(sections.size(), 0);
+    objectSectionParagraphs.assign(sections.size(), 0);
+
+    //Sections are written in the order of the section map, so they are sorted like in OrderSections
+    for (uint32_t i = 0; i < sections.size(); ++i) {
+        if (sections[i].codeSize == 0)
+            continue;
+
+        priorities[i] = GetSectionPriority(std::string(object.GetString(sections[i].name)));
+        objectSectionOrder.push_back(i);
     }
-    else {
-        result.mzHeader.initialRelativeSS = code->size();
-        
-        if (code->size() % result.paragraphByteSize > 0)
-            result.mzHeader.initialRelativeSS += (result.paragraphByteSize - (code->size() % result.paragraphByteSize));
 
-        result.mzHeader.initialRelativeSS /= 16;
-        result.mzHeader.initialSp = context->GetTranslationUnit().GetRequiredStackSize();
+    std::sort(objectSectionOrder.begin(), objectSectionOrder.end(), [&priorities](uint32_t a, uint32_t b)
+    {
+        return priorities[a] > priorities[b];
+    });
+
+    size_t value = 0;
+
+    for (uint32_t index : objectSectionOrder) {
+        uint64_t size = sections[index].codeSize;
+
+        //Code of the object is read only, padding is added when the code is placed
+        if (index != objectSectionOrder.back() && size % 16 != 0)
+            size += 16 - size % 16;
+
+        objectSectionSizes[index] = size;
+        objectSectionParagraphs[index] = value;
+        value += size / 16;
+    }
+}
+
+void Linker::EvaluateObjectSymbols(const ObjectFile& object, bool absoluteValue)
+{
+    using Kind = ObjectFormat::Symbol::Kind;
+
+    const auto symbols = object.GetSymbols();
+    const auto sections = object.GetSections();
+    const uint64_t origin = (absoluteValue ? object.GetHeader().origin : 0);
+
+    objectValues.assign(symbols.size(), 0);
+    objectDefined.assign(symbols.size(), 0);
+
+    auto define = [this](size_t index, int64_t value)
+    {
+        objectValues[index] = value;
+        objectDefined[index] = 1;
+    };
+
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        const ObjectFormat::Symbol& symbol = symbols[i];
+        const bool hasSection = (symbol.section != ObjectFormat::NoSection);
+
+        if (symbol.kind == Kind::Lable) {
+            if ((symbol.flags & ObjectFormat::Symbol::Evaluated) == 0) [[unlikely]] {
+                std::string msg("Unevaluated address symbol at linking stage: \'");
+                msg += std::string(object.GetString(symbol.name)) + '\'';
+
+                context->Error(msg.c_str());
+                continue;
+            }
+
+            int64_t value = symbol.value;
+
+            if (absoluteValue)
+                value += origin + (hasSection ? objectSectionParagraphs[symbol.section] * 16 : 0);
+
+            define(i, value);
+        }
+        else if (symbol.kind == Kind::Section && hasSection && sections[symbol.section].codeSize != 0) {
+            define(i, objectSectionParagraphs[symbol.section]);
+        }
+    }
+
+    //Constants go after lables and sections, in dependency order
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        const ObjectFormat::Symbol& symbol = symbols[i];
+
+        if (symbol.kind != Kind::Constant)
+            continue;
+
+        if (symbol.flags & ObjectFormat::Symbol::Evaluated) {
+            define(i, symbol.value);
+            continue;
+        }
+
+        bool isDefined = true;
+
+        for (uint32_t dependency : object.GetOperandSymbols(symbol.expression))
+            isDefined &= (objectDefined[dependency] != 0);
+
+        if (isDefined)
+            define(i, object.Evaluate(symbol.expression, objectValues.data()));
+    }
+}
+
+void Linker::LinkObjectSections(const ObjectFile& object, Codegen::MachineCode& code, bool absoluteValue,
+    std::vector<ExeObject::RelocationTarget>* relocationTable)
+{
+    const auto sections = object.GetSections();
+    const auto symbols = object.GetSymbols();
+    const uint64_t origin = (absoluteValue ? object.GetHeader().origin : 0);
+
+    //There is no source to point at, messages name the place in the section
+    auto report = [&](bool isError, const std::string& message, const ObjectFormat::Section& section, const ObjectFormat::Relocation& relocation)
+    {
+        std::string msg = message + " at \'" + std::string(object.GetString(section.name)) + "\' + " + std::to_string(relocation.sectionOffset);
+
+        if (isError)
+            context->Error(msg.c_str());
+        else
+            context->Warn(msg.c_str());
+    };
+
+    for (uint32_t index : objectSectionOrder)
+    {
+        const ObjectFormat::Section& section = sections[index];
+        const std::span<const uint8_t> sectionCode = object.GetCode(section);
+        const size_t sectionBeginCodeIndex = code->size();
+
+        code.Push(sectionCode.data(), sectionCode.size());
+        code->resize(sectionBeginCodeIndex + objectSectionSizes[index], 0);
+
+        for (const ObjectFormat::Relocation& relocation : object.GetRelocations(section))
+        {
+            bool isDefined = true;
+            bool isSegment = false;
+
+            for (uint32_t dependency : object.GetOperandSymbols(relocation.expression)) {
+                if (objectDefined[dependency] == 0) [[unlikely]] {
+                    report(true, "Undefined symbol \'" + std::string(object.GetString(symbols[dependency].name)) + '\'', section, relocation);
+                    isDefined = false;
+                    break;
+                }
+
+                isSegment |= (symbols[dependency].kind == ObjectFormat::Symbol::Kind::Section);
+            }
+
+            if (isDefined == false) [[unlikely]]
+                continue;
+
+            if (relocationTable != nullptr && isSegment)
+                relocationTable->push_back({ static_cast<uint16_t>(relocation.sectionOffset + sectionBeginCodeIndex), 0 });
+
+            int64_t value = object.Evaluate(relocation.expression, objectValues.data());
+
+            if (relocation.kind == static_cast<uint8_t>(LinkingTarget::Kind::RelativeAddress))
+                value -= (origin + relocation.relativeOrigin + sectionBeginCodeIndex);
+
+            const ValueFit fit = FitValue(value, relocation.size);
+
+            if (fit == ValueFit::Overflow) [[unlikely]] {
+                report(true, "Value overflow while linking", section, relocation);
+                continue;
+            }
+
+            if (fit == ValueFit::SignedOverflow)
+                report(false, "Signed value may be corrupted", section, relocation);
+
+            std::memcpy(&code[sectionBeginCodeIndex + relocation.sectionOffset], &value, relocation.size);
+        }
     }
 }
 
@@ -264,4 +457,43 @@ std::unique_ptr<AssembledObject> Linker::Link(LinkingFormat format)
     }
 
     return std::move(result);
+}
+
+std::unique_ptr<AssembledObject> Linker::Link(const ObjectFile& object, LinkingFormat format)
+{
+    const ObjectFormat::Header& header = object.GetHeader();
+
+    switch (format)
+    {
+    case LinkingFormat::RawBinary:
+    {
+        auto result = std::make_unique<RawBinary>();
+
+        if (header.stackSize != 0)
+            context->Warn("\'STACK\' statement is not supported with .COM format - ignored");
+
+        OrderObjectSections(object);
+        EvaluateObjectSymbols(object, true);
+        LinkObjectSections(object, result->GetCode(), true, nullptr);
+
+        return result;
+    }
+    case LinkingFormat::DosExecutable:
+    {
+        auto result = std::make_unique<ExeObject>();
+
+        OrderObjectSections(object);
+
+        if (header.origin != 0)
+            context->Warn("Origin offset not allowed with .EXE format - ignored");
+
+        EvaluateObjectSymbols(object, false);
+        LinkObjectSections(object, result->code, false, &result->relocationTable);
+        SetExeStack(*result, header.stackSize);
+
+        return result;
+    }
+    default:
+        throw std::runtime_error("Not implemented");
+    }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "context/context.h"
 #include "raw-binary.h"
 #include "exe-object.h"
+#include "object-file.h"
 
 namespace ASM
 {
@@ -19,26 +20,54 @@ namespace ASM
     class Linker
     {
     private:
+        enum class ValueFit : uint8_t
+        {
+            Fits,
+            SignedOverflow,
+            Overflow
+        };
+
         AssemblyContext* context = nullptr;
-        std::unordered_map<std::string, int64_t> symbolMap;
+        SymbolValues symbolMap;
         std::vector<Section*> sectionOrder;
+        //Paragraph of each ordered section, keyed by interned section name
+        IdMap<size_t> sectionParagraphs;
+
+        //Linking of a loaded object, indexed by object symbol and by object section
+        std::vector<int64_t> objectValues;
+        std::vector<uint8_t> objectDefined;
+        std::vector<uint32_t> objectSectionOrder;
+        std::vector<uint64_t> objectSectionSizes;
+        std::vector<size_t> objectSectionParagraphs;
 
-        size_t GetOrderedSectionOffset(const std::string& sectionName);
+        size_t GetOrderedSectionOffset(SymbolId sectionName) const;
 
-        bool IsValidDependencies(const AST::Expression* expression, std::vector<const std::string*>& dependencies);
+        static unsigned int GetSectionPriority(const std::string& name);
+        static ValueFit FitValue(int64_t value, uint8_t size);
+
+        bool IsValidDependencies(const AST::Expression* expression, std::span<const SymbolId> dependencies);
         bool IsValueCompatibleWithSize(int64_t value, const LinkingTarget& linkingTarget);
         
-        void EvaluateSymbol(const Symbol& symbol, bool absoluteValue, unsigned int depth = 0);
+        void EvaluateLable(const Symbol& symbol, bool absoluteValue);
+        void EvaluateSymbols(bool absoluteValue);
         void OrderSections();
+        void SetExeStack(ExeObject& result, size_t stackSize);
         void LinkRawBinary(RawBinary& result);
         void LinkExe(ExeObject& result);
 
-        static constexpr const size_t maxEvalDepth = 1000;
+        void OrderObjectSections(const ObjectFile& object);
+        void EvaluateObjectSymbols(const ObjectFile& object, bool absoluteValue);
+        //Relocations of the sections are read from the object in place, EXE relocations are collected if a table is given
+        void LinkObjectSections(const ObjectFile& object, Codegen::MachineCode& code, bool absoluteValue,
+            std::vector<ExeObject::RelocationTarget>* relocationTable);
+
         static const std::unordered_map<std::string, unsigned int> segmentsPriorityMap;
     public:
         Linker(AssemblyContext& context) : context(&context) {}
 
         std::unique_ptr<AssembledObject> Link(LinkingFormat format);
+        //Context is used only for messages
+        std::unique_ptr<AssembledObject> Link(const ObjectFile& object, LinkingFormat format);
     };
 }
 
@@ -5,6 +5,7 @@
 
 #include "codegen/machine-code.h"
 #include "syntax/expressions.h"
+#include "expression-code.h"
 
 namespace ASM
 {
@@ -33,16 +34,18 @@ namespace ASM
         uint64_t replacmentSectionOffset = 0;
 
         AST::Expression* expression = nullptr;
+        //Compiled once here, the tree is kept for messages and logging
+        ExpressionCode code;
     public:
         LinkingTarget(AST::Expression* expression, uint64_t offset, uint8_t size, uint64_t relativeOrigin)
             : replacmentSectionOffset(offset),
             expression(expression),
             dependency(Kind::RelativeAddress), size(size),
             replacmentRelativeOrigin(relativeOrigin),
-            type(Type::Integer) {}
+            type(Type::Integer), code(expression) {}
 
         LinkingTarget(AST::Expression* expression, Kind dependency, uint64_t offset, uint8_t size, Type type = Type::Integer) 
-            : replacmentSectionOffset(offset), expression(expression), dependency(dependency), size(size), type(type)
+            : replacmentSectionOffset(offset), expression(expression), dependency(dependency), size(size), type(type), code(expression)
         {
             assert(dependency == Kind::Value || type == Type::Integer);
         }
@@ -54,6 +57,16 @@ namespace ASM
         inline uint64_t GetRelativeOrigin() const { return replacmentRelativeOrigin; }
         inline AST::Expression* GetExpression() { return expression; }
         inline const AST::Expression* GetExpression() const { return expression; }
+        inline const ExpressionCode& GetCode() const { return code; }
+
+        //Moves the target with the code it was generated in
+        inline void Rebase(uint64_t base)
+        {
+            replacmentSectionOffset += base;
+
+            if (dependency == Kind::RelativeAddress)
+                replacmentRelativeOrigin += base;
+        }
     };
 }
 
@@ -1,68 +1,448 @@
 #include "object-file.h"
 
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
 using namespace ASM;
+using namespace ASM::AST;
+
+namespace Format = ASM::ObjectFormat;
+
+static inline uint64_t AlignUp(uint64_t value) { return (value + Format::Alignment - 1) / Format::Alignment * Format::Alignment; }
+
+bool ObjectFile::IsObject(std::string_view bytes)
+{
+    uint32_t magic = 0;
+
+    if (bytes.size() < sizeof(Format::Header))
+        return false;
+
+    std::memcpy(&magic, bytes.data(), sizeof(magic));
+
+    return (magic == Format::Magic);
+}
+
+bool ObjectFile::Open(const std::string& path)
+{
+    SourceBuffer source;
+
+    return (source.Open(path) && Load(std::move(source)));
+}
+
+bool ObjectFile::Load(SourceBuffer&& source)
+{
+    file = std::move(source);
+
+    return Load(file.GetText());
+}
+
+bool ObjectFile::Load(std::string_view bytes)
+{
+    //Heap blocks of strings are aligned to more than the records need
+    if (reinterpret_cast<uintptr_t>(bytes.data()) % Format::Alignment != 0)
+    {
+        copy.assign(bytes);
+        bytes = copy;
+    }
+
+    data = reinterpret_cast<const uint8_t*>(bytes.data());
+    size = bytes.size();
+
+    if (Validate() == false)
+    {
+        data = nullptr;
+        size = 0;
+
+        return false;
+    }
+
+    size = GetHeader().fileSize;
+
+    return true;
+}
 
 bool ObjectFile::Deserialize(std::istream& stream)
 {
-    return false;
+    std::ostringstream bytes;
+    bytes << stream.rdbuf();
+
+    copy = std::move(bytes).str();
+
+    return Load(std::string_view(copy));
+}
+
+bool ObjectFile::IsValidTable(const Format::Table& table, size_t recordSize) const
+{
+    const uint64_t fileSize = GetHeader().fileSize;
+
+    return table.offset % Format::Alignment == 0 && table.offset >= sizeof(Format::Header) && table.offset <= fileSize &&
+        table.count <= (fileSize - table.offset) / recordSize;
+}
+
+bool ObjectFile::IsValidString(const Format::String& string) const
+{
+    return static_cast<uint64_t>(string.offset) + string.length <= GetHeader().strings.count;
+}
+
+bool ObjectFile::IsValidExpression(const Format::Expression& expression) const
+{
+    using Op = ExpressionCode::Op;
+
+    const Format::Header& header = GetHeader();
+
+    //Every push is an op, a deeper stack would only allocate more
+    if (static_cast<uint64_t>(expression.firstOp) + expression.opsCount > header.ops.count ||
+        static_cast<uint64_t>(expression.firstSymbol) + expression.symbolsCount > header.operandSymbols.count ||
+        expression.maxStackDepth > expression.opsCount)
+        return false;
+
+    //Ops are run without checks, so the stack and the operands they take are checked here
+    uint64_t depth = 0;
+    uint64_t symbolsCount = 0;
+    uint64_t valuesCount = 0;
+
+    for (const Op op : GetTable<Op>(header.ops).subspan(expression.firstOp, expression.opsCount))
+    {
+        if (static_cast<uint8_t>(op) >= ExpressionCode::OpsCount)
+            return false;
+
+        switch (op)
+        {
+        case Op::PushValue:
+            ++valuesCount;
+            ++depth;
+            break;
+        case Op::PushSymbol:
+            ++symbolsCount;
+            ++depth;
+            break;
+        case Op::Negate:
+        case Op::Not:
+            if (depth < 1)
+                return false;
+            break;
+        default:
+            if (depth < 2)
+                return false;
+            --depth;
+            break;
+        }
+
+        if (depth > expression.maxStackDepth)
+            return false;
+    }
+
+    if (symbolsCount != expression.symbolsCount || expression.firstValue + valuesCount > header.values.count)
+        return false;
+
+    for (uint32_t symbol : GetOperandSymbols(expression))
+        if (symbol >= header.symbols.count)
+            return false;
+
+    return true;
+}
+
+bool ObjectFile::Validate() const
+{
+    if (size < sizeof(Format::Header) || reinterpret_cast<uintptr_t>(data) % Format::Alignment != 0)
+        return false;
+
+    const Format::Header& header = GetHeader();
+
+    if (header.magic != Format::Magic || header.version != Format::Version ||
+        header.headerSize != sizeof(Format::Header) || header.fileSize > size)
+        return false;
+
+    if (IsValidTable(header.strings, sizeof(char)) == false ||
+        IsValidTable(header.sections, sizeof(Format::Section)) == false ||
+        IsValidTable(header.symbols, sizeof(Format::Symbol)) == false ||
+        IsValidTable(header.relocations, sizeof(Format::Relocation)) == false ||
+        IsValidTable(header.ops, sizeof(ExpressionCode::Op)) == false ||
+        IsValidTable(header.operandSymbols, sizeof(uint32_t)) == false ||
+        IsValidTable(header.values, sizeof(int64_t)) == false)
+        return false;
+
+    const size_t sectionsCount = header.sections.count;
+
+    for (const Format::Section& section : GetSections())
+    {
+        if (IsValidString(section.name) == false || section.codeOffset > header.fileSize ||
+            section.codeSize > header.fileSize - section.codeOffset ||
+            static_cast<uint64_t>(section.firstRelocation) + section.relocationsCount > header.relocations.count)
+            return false;
+
+        for (const Format::Relocation& relocation : GetRelocations(section))
+        {
+            if (relocation.kind > static_cast<uint8_t>(LinkingTarget::Kind::RelativeAddress) ||
+                relocation.type > static_cast<uint8_t>(LinkingTarget::Type::Float) ||
+                relocation.size > sizeof(int64_t) || relocation.sectionOffset > section.codeSize ||
+                relocation.size > section.codeSize - relocation.sectionOffset ||
+                IsValidExpression(relocation.expression) == false)
+                return false;
+        }
+    }
+
+    for (const Format::Symbol& symbol : GetSymbols())
+    {
+        if (IsValidString(symbol.name) == false || symbol.kind > Format::Symbol::Kind::Undefined)
+            return false;
+
+        if ((symbol.kind == Format::Symbol::Kind::Lable || symbol.kind == Format::Symbol::Kind::Section) &&
+            symbol.section != Format::NoSection && symbol.section >= sectionsCount)
+            return false;
+
+        if (symbol.kind == Format::Symbol::Kind::Constant && (symbol.flags & Format::Symbol::Evaluated) == 0 &&
+            IsValidExpression(symbol.expression) == false)
+            return false;
+    }
+
+    return true;
 }
 
 bool ObjectFile::Serialize(std::ostream& stream) const
 {
-    //Sections
-    auto& sectionMap = context->GetTranslationUnit().GetSectionMap();
-    size_t sectionsCount = sectionMap.size();
-
-    stream.write(reinterpret_cast<char*>(&sectionsCount), sizeof(sectionsCount));
-    
-    for (auto& section : sectionMap)
-    {
-        //Section name
-        size_t size = section.first.size();
-        stream.write(reinterpret_cast<char*>(&size), sizeof(size));
-        stream.write(section.first.c_str(), size);
-        
-        //Code
-        size = section.second.GetCode()->size();
-        stream.write(reinterpret_cast<char*>(&size), sizeof(size));
-        stream.write(reinterpret_cast<char*>(section.second.GetCode()->data()), size);
-
-        //Linking targets
-        size = section.second.GetLinkingTargets().size();
-        stream.write(reinterpret_cast<char*>(&size), sizeof(size));
-        
-        for (auto& target : section.second.GetLinkingTargets())
+    if (IsLoaded())
+    {
+        stream.write(reinterpret_cast<const char*>(data), size);
+        return stream.good();
+    }
+
+    return Write(stream);
+}
+
+bool ObjectFile::Write(std::ostream& stream) const
+{
+    using SymbolKind = Format::Symbol::Kind;
+
+    TranslationUnit& unit = context->GetTranslationUnit();
+    const SymbolTable& symbolTable = context->GetSymbolTable();
+    StringInterner& interner = context->GetInterner();
+
+    Format::Header header;
+    std::string strings;
+    std::vector<Format::Section> sections;
+    std::vector<Format::Symbol> symbols;
+    std::vector<Format::Relocation> relocations;
+    std::vector<ExpressionCode::Op> ops;
+    std::vector<uint32_t> operandSymbols;
+    std::vector<int64_t> values;
+
+    //Sections by interned name and by name, for lables and `@section` symbols
+    IdMap<uint32_t> sectionIndices;
+    std::unordered_map<std::string_view, uint32_t> sectionsByName;
+    std::vector<Section*> sectionOrder;
+    //Object symbol of each referenced symbol
+    IdMap<uint32_t> symbolIndices;
+
+    auto addString = [&](std::string_view string)
+    {
+        const Format::String result = { static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(string.size()) };
+        strings += string;
+
+        return result;
+    };
+
+    auto addSymbol = [&](SymbolId id, SymbolKind kind)
+    {
+        const uint32_t index = symbols.size();
+
+        symbols.emplace_back().name = addString(interner.Get(id));
+        symbols.back().kind = kind;
+        symbolIndices.Insert(id, index);
+
+        return index;
+    };
+
+    //Symbols not declared in the table come after the declared ones
+    auto getSymbolIndex = [&](SymbolId id)
+    {
+        if (const uint32_t* index = symbolIndices.Find(id))
+            return *index;
+
+        const std::string& name = interner.Get(id);
+        auto section = (name.empty() == false && name[0] == '@' ? sectionsByName.find(std::string_view(name).substr(1)) : sectionsByName.end());
+
+        if (section == sectionsByName.end())
+            return addSymbol(id, SymbolKind::Undefined);
+
+        const uint32_t index = addSymbol(id, SymbolKind::Section);
+        symbols[index].section = section->second;
+
+        return index;
+    };
+
+    auto addExpression = [&](const ExpressionCode& code)
+    {
+        Format::Expression result;
+
+        result.firstOp = ops.size();
+        result.opsCount = code.GetSize();
+        result.firstSymbol = operandSymbols.size();
+        result.symbolsCount = code.GetSymbols().size();
+        result.firstValue = values.size();
+        result.maxStackDepth = code.GetMaxStackDepth();
+
+        ops.insert(ops.end(), code.GetOps().begin(), code.GetOps().end());
+        values.insert(values.end(), code.GetValues().begin(), code.GetValues().end());
+
+        for (SymbolId symbol : code.GetSymbols())
+            operandSymbols.push_back(getSymbolIndex(symbol));
+
+        return result;
+    };
+
+    //Relocations are most of the file, their tables are allocated once
+    size_t relocationsCount = 0;
+    size_t opsCount = 0;
+    size_t symbolsCount = 0;
+    size_t valuesCount = 0;
+
+    for (auto& [name, section] : unit.GetSectionMap())
+    {
+        relocationsCount += section.GetLinkingTargets().size();
+
+        for (const LinkingTarget& target : section.GetLinkingTargets())
+        {
+            opsCount += target.GetCode().GetSize();
+            symbolsCount += target.GetCode().GetSymbols().size();
+            valuesCount += target.GetCode().GetValues().size();
+        }
+    }
+
+    relocations.reserve(relocationsCount);
+    ops.reserve(opsCount);
+    operandSymbols.reserve(symbolsCount);
+    values.reserve(valuesCount);
+
+    for (auto& [name, section] : unit.GetSectionMap())
+    {
+        const uint32_t index = sections.size();
+
+        sectionIndices.Insert(interner.Intern(name), index);
+        sectionsByName.emplace(name, index);
+        sectionOrder.push_back(&section);
+
+        sections.emplace_back().name = addString(name);
+        sections.back().codeSize = section.GetCode()->size();
+    }
+
+    for (SymbolId id : symbolTable.GetSymbolIds())
+    {
+        const Symbol& symbol = symbolTable.GetSymbol(id);
+
+        if (symbol.GetDeclaration().Is<LableDecl>() == false)
+            continue;
+
+        Format::Symbol& record = symbols[addSymbol(id, SymbolKind::Lable)];
+        const SectionDecl* section = symbol.GetDeclaration().GetAs<LableDecl>()->GetRelatedSection();
+
+        if (const uint32_t* sectionIndex = (section != nullptr ? sectionIndices.Find(section->GetId()) : nullptr))
+            record.section = *sectionIndex;
+
+        if (symbol.IsEvaluated())
         {
-            auto kind = target.GetKind();
-            stream.write(reinterpret_cast<char*>(&kind), sizeof(kind));
-            auto type = target.GetType();
-            stream.write(reinterpret_cast<char*>(&type), sizeof(type));
-            auto size = target.GetSize();
-            stream.write(reinterpret_cast<char*>(&size), sizeof(size));
-            auto relativeOrigin = target.GetRelativeOrigin();
-            stream.write(reinterpret_cast<char*>(&relativeOrigin), sizeof(relativeOrigin));
-            auto sectionOffset = target.GetSectionOffset();
-            stream.write(reinterpret_cast<char*>(&sectionOffset), sizeof(sectionOffset));
+            record.flags |= Format::Symbol::Evaluated;
+            record.value = symbol.GetValue().GetAsInt();
         }
     }
 
-    //Symbol table
-    auto& symbolMap = context->GetSymbolTable().GetSymbolsMap();
-    for (auto& symbol : symbolMap)
+    //Indices of all constants are known before their expressions refer to each other
+    const std::vector<SymbolId>& constants = context->GetResolver().GetEvaluationOrder();
+    const uint32_t firstConstant = symbols.size();
+
+    for (SymbolId id : constants)
+    {
+        Format::Symbol& record = symbols[addSymbol(id, SymbolKind::Constant)];
+
+        if (const int64_t* value = context->GetResolver().FindConstant(id))
+        {
+            record.flags |= Format::Symbol::Evaluated;
+            record.value = *value;
+        }
+    }
+
+    for (size_t i = 0; i < constants.size(); ++i)
+    {
+        if (symbols[firstConstant + i].flags & Format::Symbol::Evaluated)
+            continue;
+
+        const ConstantDecl* declaration = symbolTable.GetSymbol(constants[i]).GetDeclaration().GetAs<ConstantDecl>();
+        const Format::Expression expression = addExpression(ExpressionCode(&declaration->GetExpression()));
+
+        symbols[firstConstant + i].expression = expression;
+    }
+
+    for (size_t i = 0; i < sections.size(); ++i)
     {
-        //TODO: Put declaration
-        //---------------------
+        auto& linkingTargets = sectionOrder[i]->GetLinkingTargets();
+
+        sections[i].firstRelocation = relocations.size();
+        sections[i].relocationsCount = linkingTargets.size();
 
-        auto isEvaluated = symbol.second.IsEvaluated();
-        stream.write(reinterpret_cast<char*>(&isEvaluated), sizeof(isEvaluated));
+        for (const LinkingTarget& target : linkingTargets)
+        {
+            Format::Relocation relocation;
 
-        if (isEvaluated) {
-            auto kind = symbol.second.GetValue().GetKind();
-            stream.write(reinterpret_cast<char*>(&kind), sizeof(kind));
-            auto value = symbol.second.GetValue().GetAsInt();
-            stream.write(reinterpret_cast<char*>(&value), sizeof(value));
+            relocation.sectionOffset = target.GetSectionOffset();
+            relocation.relativeOrigin = target.GetRelativeOrigin();
+            relocation.expression = addExpression(target.GetCode());
+            relocation.kind = static_cast<uint8_t>(target.GetKind());
+            relocation.type = static_cast<uint8_t>(target.GetType());
+            relocation.size = target.GetSize();
+
+            relocations.push_back(relocation);
         }
     }
 
-    return true;
-}
\ No newline at end of file
+    //Tables go one after another, section code follows them
+    uint64_t offset = sizeof(Format::Header);
+
+    auto place = [&offset](Format::Table& table, size_t count, size_t recordSize)
+    {
+        table.offset = offset;
+        table.count = count;
+        offset = AlignUp(offset + count * recordSize);
+    };
+
+    place(header.sections, sections.size(), sizeof(Format::Section));
+    place(header.symbols, symbols.size(), sizeof(Format::Symbol));
+    place(header.relocations, relocations.size(), sizeof(Format::Relocation));
+    place(header.values, values.size(), sizeof(int64_t));
+    place(header.operandSymbols, operandSymbols.size(), sizeof(uint32_t));
+    place(header.ops, ops.size(), sizeof(ExpressionCode::Op));
+    place(header.strings, strings.size(), sizeof(char));
+
+    for (Format::Section& section : sections)
+    {
+        section.codeOffset = offset;
+        offset = AlignUp(offset + section.codeSize);
+    }
+
+    header.fileSize = offset;
+    header.origin = symbolTable.GetOrigin();
+    header.stackSize = unit.GetRequiredStackSize();
+
+    static constexpr char padding[Format::Alignment] = {};
+
+    auto write = [&stream](const void* bytes, size_t count)
+    {
+        stream.write(static_cast<const char*>(bytes), count);
+        stream.write(padding, AlignUp(count) - count);
+    };
+
+    write(&header, sizeof(header));
+    write(sections.data(), sections.size() * sizeof(Format::Section));
+    write(symbols.data(), symbols.size() * sizeof(Format::Symbol));
+    write(relocations.data(), relocations.size() * sizeof(Format::Relocation));
+    write(values.data(), values.size() * sizeof(int64_t));
+    write(operandSymbols.data(), operandSymbols.size() * sizeof(uint32_t));
+    write(ops.data(), ops.size() * sizeof(ExpressionCode::Op));
+    write(strings.data(), strings.size());
+
+    for (Section* section : sectionOrder)
+        write(section->GetCode()->data(), section->GetCode()->size());
+
+    return stream.good();
+}
@@ -1,21 +1,106 @@
 #ifndef __ASM_OBJECT_FILE_H
 #define __ASM_OBJECT_FILE_H
 
+#include <span>
+#include <string>
+#include <string_view>
+
 #include "assembled-object.h"
+#include "object-format.h"
 #include "context/context.h"
+#include "context/source-buffer.h"
 
 namespace ASM
 {
+    //Object file of a translation unit, see ObjectFormat for the layout.
+    //Made from a context it writes sections, symbols and linking targets of the unit with compiled expressions.
+    //Loaded from bytes it's a view over them: the tables are checked once, then sections, relocations and
+    //expressions are read in place. Files are memory mapped, so nothing is parsed or copied.
     class ObjectFile : public AssembledObject
     {
     private:
         AssemblyContext* context = nullptr;
+
+        //Owners of loaded bytes, a mapped or read file and a copy of bytes that weren't aligned
+        SourceBuffer file;
+        std::string copy;
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+        bool IsValidTable(const ObjectFormat::Table& table, size_t recordSize) const;
+        bool IsValidString(const ObjectFormat::String& string) const;
+        bool IsValidExpression(const ObjectFormat::Expression& expression) const;
+        bool Validate() const;
+
+        bool Write(std::ostream& stream) const;
     public:
+        ObjectFile() = default;
         ObjectFile(AssemblyContext& context) : context(&context) {}
 
+        ObjectFile(const ObjectFile&) = delete;
+        ObjectFile& operator=(const ObjectFile&) = delete;
+
+        //Only checks the magic, so other inputs are told apart from objects
+        static bool IsObject(std::string_view bytes);
+
+        //Returns false if the file can't be read or isn't a valid object
+        bool Open(const std::string& path);
+        bool Load(SourceBuffer&& source);
+        //Bytes must outlive the object, they are copied only if not aligned
+        bool Load(std::string_view bytes);
+
         bool Deserialize(std::istream& stream) override;
         bool Serialize(std::ostream& stream) const override;
+
+        inline bool IsLoaded() const { return data != nullptr; }
+
+        inline const ObjectFormat::Header& GetHeader() const { return *reinterpret_cast<const ObjectFormat::Header*>(data); }
+
+        template<typename T>
+        inline std::span<const T> GetTable(const ObjectFormat::Table& table) const
+        {
+            return { reinterpret_cast<const T*>(data + table.offset), static_cast<size_t>(table.count) };
+        }
+
+        inline std::span<const ObjectFormat::Section> GetSections() const { return GetTable<ObjectFormat::Section>(GetHeader().sections); }
+        inline std::span<const ObjectFormat::Symbol> GetSymbols() const { return GetTable<ObjectFormat::Symbol>(GetHeader().symbols); }
+
+        inline std::span<const ObjectFormat::Relocation> GetRelocations(const ObjectFormat::Section& section) const
+        {
+            return GetTable<ObjectFormat::Relocation>(GetHeader().relocations).subspan(section.firstRelocation, section.relocationsCount);
+        }
+
+        inline std::span<const uint8_t> GetCode(const ObjectFormat::Section& section) const
+        {
+            return { data + section.codeOffset, static_cast<size_t>(section.codeSize) };
+        }
+
+        inline std::string_view GetString(const ObjectFormat::String& string) const
+        {
+            return { reinterpret_cast<const char*>(data + GetHeader().strings.offset + string.offset), string.length };
+        }
+
+        inline std::span<const uint32_t> GetOperandSymbols(const ObjectFormat::Expression& expression) const
+        {
+            return GetTable<uint32_t>(GetHeader().operandSymbols).subspan(expression.firstSymbol, expression.symbolsCount);
+        }
+
+        //Values of symbols are indexed by symbol
+        inline int64_t Evaluate(const ObjectFormat::Expression& expression, const int64_t* symbolValues) const
+        {
+            const ObjectFormat::Header& header = GetHeader();
+
+            return ExpressionCode::Run
+            (
+                GetTable<ExpressionCode::Op>(header.ops).subspan(expression.firstOp, expression.opsCount),
+                GetTable<uint32_t>(header.operandSymbols).data() + expression.firstSymbol,
+                GetTable<int64_t>(header.values).data() + expression.firstValue,
+                expression.maxStackDepth,
+                [symbolValues](uint32_t symbol) { return symbolValues[symbol]; }
+            );
+        }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
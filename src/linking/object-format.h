@@ -0,0 +1,130 @@
+#ifndef __ASM_OBJECT_FORMAT_H
+#define __ASM_OBJECT_FORMAT_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "expression-code.h"
+
+//Layout of object files, see ObjectFile.
+//A file is a header followed by tables of fixed size records, every table starts at a multiple of
+//Alignment from the beginning of the file. Records refer to each other by index and to the file by offset,
+//so a file mapped at any aligned address is used in place. Fields are little-endian.
+namespace ASM::ObjectFormat
+{
+    static constexpr uint32_t Magic = 0x424F4857; //"WHOB"
+    //Bumped on any change of the records below
+    static constexpr uint16_t Version = 1;
+    static constexpr uint64_t Alignment = 8;
+
+    static constexpr uint32_t NoSection = UINT32_MAX;
+
+    //Records of a table, offset is from the beginning of the file
+    struct Table
+    {
+        uint64_t offset = 0;
+        uint64_t count = 0;
+    };
+
+    //Bytes of the string table, strings are not null terminated
+    struct String
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    //Compiled ExpressionCode, slices of the ops, operand symbols and values tables.
+    //Operand symbols are indices in the symbol table.
+    struct Expression
+    {
+        uint32_t firstOp = 0;
+        uint32_t opsCount = 0;
+        uint32_t firstSymbol = 0;
+        uint32_t symbolsCount = 0;
+        uint32_t firstValue = 0;
+        uint32_t maxStackDepth = 0;
+    };
+
+    struct Header
+    {
+        uint32_t magic = Magic;
+        uint16_t version = Version;
+        uint16_t headerSize = sizeof(Header);
+        uint64_t fileSize = 0;
+
+        uint64_t origin = 0;
+        uint64_t stackSize = 0;
+
+        Table strings;
+        Table sections;
+        Table symbols;
+        Table relocations;
+        //Expression::Op bytes
+        Table ops;
+        //uint32_t symbol indices
+        Table operandSymbols;
+        //int64_t immediates
+        Table values;
+    };
+
+    struct Section
+    {
+        String name;
+        //Code bytes are placed after the tables
+        uint64_t codeOffset = 0;
+        uint64_t codeSize = 0;
+        uint32_t firstRelocation = 0;
+        uint32_t relocationsCount = 0;
+    };
+
+    //Lables come first, constants follow in evaluation order, so symbols are evaluated in one pass.
+    //The rest are the section and undefined symbols referenced by expressions.
+    struct Symbol
+    {
+        enum class Kind : uint8_t
+        {
+            //Value is an offset in the section
+            Lable,
+            //Value is known if evaluated, otherwise it's computed from the expression at linking
+            Constant,
+            //Paragraph of the section, `@section` in sources
+            Section,
+            //Referenced, but not declared
+            Undefined
+        };
+
+        enum Flags : uint8_t
+        {
+            Evaluated = 0b0001
+        };
+
+        String name;
+        Kind kind = Kind::Undefined;
+        uint8_t flags = 0;
+        uint16_t reserved = 0;
+        uint32_t section = NoSection;
+        int64_t value = 0;
+        Expression expression;
+    };
+
+    struct Relocation
+    {
+        uint64_t sectionOffset = 0;
+        uint64_t relativeOrigin = 0;
+        Expression expression;
+        //LinkingTarget::Kind
+        uint8_t kind = 0;
+        //LinkingTarget::Type
+        uint8_t type = 0;
+        uint8_t size = 0;
+        uint8_t reserved[5] = {};
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 144);
+    static_assert(std::is_trivially_copyable_v<Section> && sizeof(Section) == 32);
+    static_assert(std::is_trivially_copyable_v<Symbol> && sizeof(Symbol) == 48);
+    static_assert(std::is_trivially_copyable_v<Relocation> && sizeof(Relocation) == 48);
+    static_assert(sizeof(ExpressionCode::Op) == 1);
+}
+
+#endif
@@ -7,7 +7,45 @@
 
 namespace ASM
 {
-    using AbstractSyntaxTree = std::vector<std::unique_ptr<ASM::AST::Node>>;
+    //Nodes are owned by the translation unit arena
+    using AbstractSyntaxTree = std::vector<ASM::AST::Node*>;
 }
 
-#endif
\ No newline at end of file
+namespace ASM::AST
+{
+    //Calls visitor with the node cast to its concrete type, dispatched by a switch over node kinds.
+    //Visitor must return the same type for every node type.
+    template<typename Visitor>
+    decltype(auto) Visit(Node& node, Visitor&& visitor)
+    {
+        switch (node.GetKind())
+        {
+        #define NODE_KIND_TO_VISIT(name) case NodeKind::name: return visitor(*static_cast<name*>(&node));
+            ASM_AST_NODE_KINDS(NODE_KIND_TO_VISIT)
+        #undef NODE_KIND_TO_VISIT
+        default:
+            break;
+        }
+
+        assert(false);
+        __builtin_unreachable();
+    }
+
+    template<typename Visitor>
+    decltype(auto) Visit(const Node& node, Visitor&& visitor)
+    {
+        switch (node.GetKind())
+        {
+        #define NODE_KIND_TO_VISIT(name) case NodeKind::name: return visitor(*static_cast<const name*>(&node));
+            ASM_AST_NODE_KINDS(NODE_KIND_TO_VISIT)
+        #undef NODE_KIND_TO_VISIT
+        default:
+            break;
+        }
+
+        assert(false);
+        __builtin_unreachable();
+    }
+}
+
+#endif
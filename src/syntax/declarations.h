@@ -5,6 +5,7 @@
 
 #include "token.h"
 #include "expressions.h"
+#include "context/string-interner.h"
 #include "node.h"
 
 namespace ASM
@@ -14,18 +15,29 @@ namespace ASM
 
 namespace ASM::AST
 {
-    struct Declaration : public Node {};
+    struct Declaration : public Node
+    {
+    protected:
+        Declaration(NodeKind kind) : Node(kind) {}
+    public:
+        AST_NODE_KIND_RANGE(SectionDecl, LableDecl)
+    };
 
     struct NamedDecl : public Declaration
     {
     protected:
-        std::string name;
+        //Interned name, string is owned by the context interner
+        SymbolId id = InvalidSymbolId;
+        const std::string* name = &StringInterner::EmptyString;
+
+        NamedDecl(NodeKind kind) : Declaration(kind) {};
 
         friend class ASM::Parser;
     public:
-        NamedDecl(const std::string& name) : name(name) {};
+        AST_NODE_KIND_RANGE(SectionDecl, LableDecl)
 
-        inline const std::string& GetName() const { return name; };
+        inline SymbolId GetId() const { return id; }
+        inline const std::string& GetName() const { return *name; };
     };
 
     struct SymbolDecl : public NamedDecl
@@ -40,9 +52,13 @@ namespace ASM::AST
     protected:
         Scope scope = Scope::Local;
 
+        SymbolDecl(NodeKind kind, Scope scope) : NamedDecl(kind), scope(scope) {}
+
         friend class ASM::Parser;
     public:
-        SymbolDecl(const std::string& name, Scope scope = Scope::Local) : NamedDecl(name), scope(scope) {}
+        AST_NODE_KIND_RANGE(SymbolDecl, LableDecl)
+
+        SymbolDecl(Scope scope = Scope::Local) : SymbolDecl(NodeKind::SymbolDecl, scope) {}
 
         inline Scope GetScope() const { return scope; }
 
@@ -52,14 +68,17 @@ namespace ASM::AST
     struct ConstantDecl : public SymbolDecl
     {
     private:
-        std::unique_ptr<Expression> expression;
+        Expression* expression = nullptr;
 
         friend class ASM::Parser;
     public:
-        ConstantDecl(const std::string& name, Expression* expression) : SymbolDecl(name, Scope::Local) {this->expression.reset(expression); }
+        AST_NODE_KIND(ConstantDecl)
+
+        ConstantDecl(Expression* expression) :
+            SymbolDecl(NodeKind::ConstantDecl, Scope::Local), expression(expression) {}
 
-        inline Expression& GetExpression() { return *expression.get(); }
-        inline const Expression& GetExpression() const { return *expression.get(); }
+        inline Expression& GetExpression() { return *expression; }
+        inline const Expression& GetExpression() const { return *expression; }
 
         bool IsAddress() const override { return false; }
     };
@@ -76,8 +95,10 @@ namespace ASM::AST
 
         friend class ASM::Parser;
     public:
-        LableDecl(const std::string& name, const SectionDecl* relatedSection, size_t stmtOffset = 0)
-            : SymbolDecl(name, Scope::Local), relatedSection(relatedSection), sectionStmtOffset(stmtOffset) {}
+        AST_NODE_KIND(LableDecl)
+
+        LableDecl(const SectionDecl* relatedSection, size_t stmtOffset = 0)
+            : SymbolDecl(NodeKind::LableDecl, Scope::Local), relatedSection(relatedSection), sectionStmtOffset(stmtOffset) {}
 
         inline const SectionDecl* GetRelatedSection() const { return relatedSection; }
         inline size_t GetSectionStmtOffset() const { return sectionStmtOffset; }
@@ -89,9 +110,16 @@ namespace ASM::AST
     struct SectionDecl : public NamedDecl
     {
     private:
+        //Sum of max sizes of statements up to the next section declaration
+        size_t maxCodeSize = 0;
+
         friend class ASM::Parser;
     public:
-        SectionDecl(const std::string& name) : NamedDecl(name) {}
+        AST_NODE_KIND(SectionDecl)
+
+        SectionDecl() : NamedDecl(NodeKind::SectionDecl) {}
+
+        inline size_t GetMaxCodeSize() const { return maxCodeSize; }
     };
 }
 
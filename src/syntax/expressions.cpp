@@ -1,14 +1,18 @@
 #include "expressions.h"
 
+#include <algorithm>
+
+#include "arch/8086/arch-8086.h"
+
 using namespace ASM;
 using namespace ASM::AST;
 
-int64_t NumberExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const { return value; }
+int64_t NumberExpr::Resolve(const SymbolValues& symbolValues) const { return value; }
 
 bool NumberExpr::IsDependent() const { return false; }
-bool NumberExpr::Simplify()          { return false; }
+bool NumberExpr::Simplify(Arena&)       { return false; }
 
-RegisterExpr::RegisterExpr(Arch::RegisterIdentifier reg) : identifier(reg)
+RegisterExpr::RegisterExpr(Arch::RegisterIdentifier reg) : Expression(NodeKind::RegisterExpr), identifier(reg)
 {
     if (reg >= Arch::RegisterIdentifier::AL && reg <= Arch::RegisterIdentifier::RDI)
         group = Arch::RegisterGroup::GeneralPerpose;
@@ -61,12 +65,12 @@ Arch::Register RegisterExpr::GetEncoding() const
     return Arch::Register::Invalid;
 }
 
-int64_t RegisterExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const { return 0; }
+int64_t RegisterExpr::Resolve(const SymbolValues& symbolValues) const { return 0; }
 
 bool RegisterExpr::IsDependent() const { return false; }
-bool RegisterExpr::Simplify()          { return false; }
+bool RegisterExpr::Simplify(Arena&)       { return false; }
 
-int64_t LiteralExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const
+int64_t LiteralExpr::Resolve(const SymbolValues& symbolValues) const
 {
     if (value.size() == 1)
         return value.back();
@@ -79,14 +83,14 @@ bool LiteralExpr::IsDependent() const
     return value.size() != 1;
 }
 
-bool LiteralExpr::Simplify()
+bool LiteralExpr::Simplify(Arena&)
 {
     return value.size() == 1;
 }
 
-int64_t UnaryExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const
+int64_t UnaryExpr::Resolve(const SymbolValues& symbolValues) const
 {
-    int64_t value = expression->Resolve(symbolsMap);
+    int64_t value = expression->Resolve(symbolValues);
 
     switch (operation)
     {
@@ -111,32 +115,28 @@ bool UnaryExpr::IsDependent() const
     return expression->IsDependent();
 }
 
-bool UnaryExpr::Simplify()
+bool UnaryExpr::Simplify(Arena& arena)
 {
     if (IsDependent() == false)
     {
-        if (dynamic_cast<NumberExpr*>(expression.get()) && operation == NullOperation)
+        if (expression->Is<NumberExpr>() && operation == NullOperation)
             return false;
 
-        expression.reset(new NumberExpr(Resolve()));
+        expression = arena.Make<NumberExpr>(Resolve());
         operation = NullOperation;
 
         return true;
     }
     else
     {
-        return expression->Simplify();
+        return expression->Simplify(arena);
     }
 }
 
-std::vector<const std::string*> UnaryExpr::GetDependecies() const {
-    return expression->GetDependecies();
-}
-
-int64_t BinaryExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const
+int64_t BinaryExpr::Resolve(const SymbolValues& symbolValues) const
 {
-    int64_t lhsVal = lhs->Resolve(symbolsMap);
-    int64_t rhsVal = rhs->Resolve(symbolsMap);
+    int64_t lhsVal = lhs->Resolve(symbolValues);
+    int64_t rhsVal = rhs->Resolve(symbolValues);
 
     switch (operation)
     {
@@ -180,37 +180,37 @@ bool BinaryExpr::IsDependent() const
     return (lhs->IsDependent() || rhs->IsDependent());
 }
 
-bool BinaryExpr::Simplify()
+bool BinaryExpr::Simplify(Arena& arena)
 {
     bool result = false;
 
-    if (dynamic_cast<NumberExpr*>(lhs.get()) == nullptr && lhs->IsDependent() == false)
+    if (lhs->Is<NumberExpr>() == false && lhs->IsDependent() == false)
     {
-        lhs.reset(new NumberExpr(lhs->Resolve()));
+        lhs = arena.Make<NumberExpr>(lhs->Resolve());
 
         result = true;
     }
     else
     {
-        result = lhs->Simplify();
+        result = lhs->Simplify(arena);
     }
 
-    if (dynamic_cast<NumberExpr*>(rhs.get()) == nullptr && rhs->IsDependent() == false)
+    if (rhs->Is<NumberExpr>() == false && rhs->IsDependent() == false)
     {
-        rhs.reset(new NumberExpr(rhs->Resolve()));
+        rhs = arena.Make<NumberExpr>(rhs->Resolve());
 
         result = true;
     }
     else
     {
-        result |= rhs->Simplify();
+        result |= rhs->Simplify(arena);
     }
 
-    NumberExpr* lhsNum = dynamic_cast<NumberExpr*>(lhs.get());
-    NumberExpr* rhsNum = dynamic_cast<NumberExpr*>(rhs.get());
-
-    if (lhsNum && rhsNum)
+    if (lhs->Is<NumberExpr>() && rhs->Is<NumberExpr>())
     {
+        NumberExpr* lhsNum = lhs->GetAs<NumberExpr>();
+        NumberExpr* rhsNum = rhs->GetAs<NumberExpr>();
+
         lhsNum->value = Resolve();
         rhsNum->value = 0;
 
@@ -222,80 +222,83 @@ bool BinaryExpr::Simplify()
     return result;
 }
 
-std::vector<const std::string*> BinaryExpr::GetDependecies() const {
-    auto result = lhs->GetDependecies();
-    auto rhsDependencies = rhs->GetDependecies();
-
-    result.insert(result.end(), rhsDependencies.begin(), rhsDependencies.end());
+int64_t ParenExpr::Resolve(const SymbolValues& symbolValues) const { return expression->Resolve(symbolValues); }
 
-    return result;
-}
+bool ParenExpr::IsDependent() const { return expression->IsDependent(); }
+bool ParenExpr::Simplify(Arena& arena) { return expression->Simplify(arena); }
 
-ParenExpr::ParenExpr(Expression* child)
+void MemoryExpr::EvaluateAddressing()
 {
-    expression.reset(child);
-}
+    //Registers under anything but '+' can't be encoded, the flag is passed down to them
+    thread_local std::vector<std::pair<const Expression*, bool>> pending;
 
-int64_t ParenExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const { return expression->Resolve(symbolsMap); }
-
-bool ParenExpr::IsDependent() const { return expression->IsDependent(); }
-bool ParenExpr::Simplify()          { return expression->Simplify(); }
+    pending.clear();
+    pending.emplace_back(expression, false);
 
-std::vector<const std::string*> ParenExpr::GetDependecies() const {
-    return expression->GetDependecies();
-}
+    rmRegsMask = 0;
+    hasRegisters = false;
+    isValidAddressing = true;
 
-void MemoryExpr::MakeRmRegsCombination(std::vector<Arch::RegisterIdentifier>& combination, Expression* expression)
-{
-    if (expression->Is<BinaryExpr>())
+    while (pending.empty() == false)
     {
-        BinaryExpr* binaryExpr = expression->GetAs<BinaryExpr>();
-
-        MakeRmRegsCombination(combination, binaryExpr->lhs.get());
-        MakeRmRegsCombination(combination, binaryExpr->rhs.get());
+        auto [node, registersForbidden] = pending.back();
+        pending.pop_back();
+
+        switch (node->GetKind())
+        {
+        case NodeKind::BinaryExpr:
+        {
+            const BinaryExpr* binaryExpr = node->GetAs<BinaryExpr>();
+            const bool isAdditive = (binaryExpr->operation == '+' || binaryExpr->operation == '-');
+
+            pending.emplace_back(binaryExpr->rhs, registersForbidden || binaryExpr->operation != '+');
+            pending.emplace_back(binaryExpr->lhs, registersForbidden || isAdditive == false);
+            break;
+        }
+        case NodeKind::UnaryExpr:
+        {
+            const UnaryExpr* unaryExpr = node->GetAs<UnaryExpr>();
+
+            pending.emplace_back(unaryExpr->GetExpression(), registersForbidden || unaryExpr->GetOperation() != '+');
+            break;
+        }
+        case NodeKind::ParenExpr: case NodeKind::MemoryExpr:
+            pending.emplace_back(node->GetAs<ParenExpr>()->GetExpression(), registersForbidden);
+            break;
+        case NodeKind::RegisterExpr:
+        {
+            const uint8_t bit = Arch::GetRmRegBit(node->GetAs<RegisterExpr>()->GetIdentifier());
+
+            if (registersForbidden || bit == 0 || (rmRegsMask & bit) != 0)
+                isValidAddressing = false;
+
+            rmRegsMask |= bit;
+            hasRegisters = true;
+            break;
+        }
+        default:
+            break;
+        }
     }
-    else if (expression->Is<UnaryExpr>())
-    {
-        MakeRmRegsCombination(combination, expression->GetAs<UnaryExpr>()->GetExpression());
-    }
-    else if (expression->Is<ParenExpr>())
-    {
-        MakeRmRegsCombination(combination, expression->GetAs<ParenExpr>()->GetExpression());
-    }
-    else if (expression->Is<RegisterExpr>())
-    {
-        combination.push_back(expression->GetAs<RegisterExpr>()->GetIdentifier());
-    }
-}
-
-std::vector<Arch::RegisterIdentifier> MemoryExpr::GetRmRegsCombination() const
-{
-    std::vector<Arch::RegisterIdentifier> result;
 
-    MakeRmRegsCombination(result, expression.get());
+    rm = Arch::Arch8086::RmByRegsMask[rmRegsMask];
 
-    std::sort(result.begin(), result.end());
-
-    return std::move(result);
+    if (rm == Arch::Arch8086::InvalidRm)
+        isValidAddressing = false;
 }
 
-int64_t SymbolExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const {
-    if (symbolsMap.count(name) == 0) [[unlikely]]
-        return 0;
+int64_t SymbolExpr::Resolve(const SymbolValues& symbolValues) const {
+    const int64_t* value = symbolValues.Find(id);
 
-    return symbolsMap.at(name);
+    return (value != nullptr ? *value : 0);
 }
 
 bool SymbolExpr::IsDependent() const { return true; }
-bool SymbolExpr::Simplify()          { return false; }
-
-std::vector<const std::string*> SymbolExpr::GetDependecies() const {
-    return { &name };
-}
+bool SymbolExpr::Simplify(Arena&)       { return false; }
 
-int64_t DuplicateExpr::Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap) const
+int64_t DuplicateExpr::Resolve(const SymbolValues& symbolValues) const
 {
-    return valueExpression->Resolve(symbolsMap);
+    return valueExpression->Resolve(symbolValues);
 }
 
 bool DuplicateExpr::IsDependent() const 
@@ -303,17 +306,7 @@ bool DuplicateExpr::IsDependent() const
     return valueExpression->IsDependent() || countExpression->IsDependent();
 }
 
-bool DuplicateExpr::Simplify()
-{
-    return valueExpression->Simplify() || countExpression->Simplify();
-}
-
-std::vector<const std::string*> DuplicateExpr::GetDependecies() const
+bool DuplicateExpr::Simplify(Arena& arena)
 {
-    auto valueDependencies = valueExpression->GetDependecies();
-    auto countDependencies = countExpression->GetDependecies();
-
-    valueDependencies.insert(valueDependencies.end(), countDependencies.begin(), countDependencies.end());
-
-    return valueDependencies;
+    return valueExpression->Simplify(arena) || countExpression->Simplify(arena);
 }
\ No newline at end of file
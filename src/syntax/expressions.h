@@ -6,15 +6,22 @@
 #include <optional>
 #include <cassert>
 #include <vector>
+#include <span>
 #include <unordered_map>
 
 #include "node.h"
+#include "utils/arena.h"
+#include "utils/id-map.h"
+#include "context/string-interner.h"
 #include "arch/8086/regs.h"
 #include "arch/8086/encoding.h"
 
 namespace ASM
 {
     class Parser;
+
+    //Values of already evaluated symbols
+    using SymbolValues = IdMap<int64_t>;
 }
 
 namespace ASM::AST
@@ -24,14 +31,45 @@ namespace ASM::AST
     struct Expression : public Node
     {
     private:
+        enum Flags : uint8_t
+        {
+            Cached    = 1 << 0,
+            Dependent = 1 << 1
+        };
+
+        //Filled by the parser for whole expressions and for subexpressions used on their own
+        //(memory displacement, dup count and value), inner nodes have nothing cached
+        const SymbolId* dependencies = nullptr;
+        uint32_t dependenciesCount = 0;
+        uint8_t flags = 0;
+
         friend class ASM::Parser;
+    protected:
+        Expression(NodeKind kind) : Node(kind) {}
     public:
-        virtual int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const = 0;
+        AST_NODE_KIND_RANGE(NumberExpr, DuplicateExpr)
+
+        virtual int64_t Resolve(const SymbolValues& symbolValues = {}) const = 0;
         virtual bool IsDependent() const = 0;
-        virtual bool Simplify() = 0;
+        //New nodes are placed in the arena
+        virtual bool Simplify(Arena& arena) = 0;
+
+        inline bool IsCached() const { return (flags & Cached) != 0; }
+
+        //Symbols referenced anywhere in the tree, sorted by id without repeats
+        inline std::span<const SymbolId> GetDependencies() const
+        {
+            assert(IsCached());
+            return { dependencies, dependenciesCount };
+        }
+
+        inline bool HasDependencies() const { return GetDependencies().empty() == false; }
 
-        virtual std::vector<const std::string*> GetDependecies() const {
-            return std::vector<const std::string*>();
+        //Same as IsDependent() == false, but without walking the tree
+        inline bool IsConstant() const
+        {
+            assert(IsCached());
+            return (flags & Dependent) == 0;
         }
     };
 
@@ -40,15 +78,17 @@ namespace ASM::AST
     private:
         friend class ASM::Parser;
     public:
-        NumberExpr() = default;
-        NumberExpr(int64_t val) : value(val) {}
+        AST_NODE_KIND(NumberExpr)
+
+        NumberExpr() : Expression(NodeKind::NumberExpr) {}
+        NumberExpr(int64_t val) : Expression(NodeKind::NumberExpr), value(val) {}
 
         int64_t value;
 
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
         bool IsDependent() const override;
-        bool Simplify() override;
+        bool Simplify(Arena& arena) override;
     };
 
     struct RegisterExpr : public Expression
@@ -59,6 +99,8 @@ namespace ASM::AST
 
         friend class ASM::Parser;
     public:
+        AST_NODE_KIND(RegisterExpr)
+
         RegisterExpr(Arch::RegisterIdentifier reg);
 
         inline Arch::RegisterIdentifier GetIdentifier() const { return identifier; }
@@ -67,10 +109,10 @@ namespace ASM::AST
         uint8_t GetSize() const;
         Arch::Register GetEncoding() const;
         
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
         bool IsDependent() const override;
-        bool Simplify() override;
+        bool Simplify(Arena& arena) override;
     };
 
     struct LiteralExpr : public Expression
@@ -78,14 +120,16 @@ namespace ASM::AST
     private:
         friend class ASM::Parser;
     public:
-        LiteralExpr(const std::string& string) : value(string) {}
+        AST_NODE_KIND(LiteralExpr)
+
+        LiteralExpr(const std::string& string) : Expression(NodeKind::LiteralExpr), value(string) {}
 
         std::string value;
 
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
         bool IsDependent() const override;
-        bool Simplify() override;
+        bool Simplify(Arena& arena) override;
     };
 
     struct UnaryExpr : public Expression
@@ -93,21 +137,23 @@ namespace ASM::AST
     private:
         static constexpr char NullOperation = '+';
 
-        std::unique_ptr<Expression> expression;
+        Expression* expression = nullptr;
 
         char operation = NullOperation;
 
         friend class ASM::Parser;
     public:
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        AST_NODE_KIND(UnaryExpr)
 
-        bool IsDependent() const override;
-        bool Simplify() override;
+        UnaryExpr() : Expression(NodeKind::UnaryExpr) {}
 
-        std::vector<const std::string*> GetDependecies() const override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
+
+        bool IsDependent() const override;
+        bool Simplify(Arena& arena) override;
 
         char GetOperation() const { return operation; }
-        Expression* GetExpression() const { return expression.get(); }
+        Expression* GetExpression() const { return expression; }
     };
 
     struct BinaryExpr : public Expression
@@ -115,73 +161,95 @@ namespace ASM::AST
     private:
         friend class ASM::Parser;
     public:
-        std::unique_ptr<Expression> lhs, rhs;
+        AST_NODE_KIND(BinaryExpr)
+
+        BinaryExpr() : Expression(NodeKind::BinaryExpr) {}
+
+        Expression* lhs = nullptr;
+        Expression* rhs = nullptr;
 
         char operation;
 
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
         bool IsDependent() const override;
-        bool Simplify() override;
-
-        std::vector<const std::string*> GetDependecies() const override;
+        bool Simplify(Arena& arena) override;
     };
 
     struct ParenExpr : public Expression
     {
     protected:
-        std::unique_ptr<Expression> expression;
+        Expression* expression = nullptr;
+
+        ParenExpr(NodeKind kind, Expression* child) : Expression(kind), expression(child) {}
 
         friend class ASM::Parser;
     public:
-        ParenExpr(Expression* child);
+        AST_NODE_KIND_RANGE(ParenExpr, MemoryExpr)
 
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        ParenExpr(Expression* child) : ParenExpr(NodeKind::ParenExpr, child) {}
 
-        bool IsDependent() const override;
-        bool Simplify() override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
-        std::vector<const std::string*> GetDependecies() const override;
+        bool IsDependent() const override;
+        bool Simplify(Arena& arena) override;
 
-        inline Expression* GetExpression() const { return expression.get(); }
+        inline Expression* GetExpression() const { return expression; }
     };
 
     struct MemoryExpr : public ParenExpr
     {
     private:
-        static void MakeRmRegsCombination(std::vector<Arch::RegisterIdentifier>& combination, Expression* Expression);
-
-        std::unique_ptr<RegisterExpr> segOverride;
+        RegisterExpr* segOverride = nullptr;
         //in bytes
         uint8_t sizeOverride = 0;
 
+        //Filled by the parser once the content is parsed, see Arch::GetRmRegBit
+        uint8_t rmRegsMask = 0;
+        uint8_t rm = static_cast<uint8_t>(Arch::RM::DISP_16);
+        bool hasRegisters = false;
+        bool isValidAddressing = true;
+
+        void EvaluateAddressing();
+
         friend class ASM::Parser;
     public:
-        MemoryExpr(Expression* child) : ParenExpr(child) {}
+        AST_NODE_KIND(MemoryExpr)
 
-        std::vector<Arch::RegisterIdentifier> GetRmRegsCombination() const;
+        MemoryExpr(Expression* child) : ParenExpr(NodeKind::MemoryExpr, child) {}
 
-        inline RegisterExpr* GetSegOverride() const { return segOverride.get(); }
+        //Any register, even one that can't be used for addressing
+        inline bool HasRegisters() const { return hasRegisters; }
+        inline uint8_t GetRmRegsMask() const { return rmRegsMask; }
+
+        //Registers are only added, each at most once, and form a valid 16-bit base and index pair
+        inline bool IsValidAddressing() const { return isValidAddressing; }
+        inline Arch::RM GetRm() const { assert(isValidAddressing); return static_cast<Arch::RM>(rm); }
+
+        inline RegisterExpr* GetSegOverride() const { return segOverride; }
         inline uint8_t GetSizeOverride() const { return sizeOverride; }
     };
 
     struct SymbolExpr : public Expression
     {
     private:
-        std::string name;
+        //Interned name, string is owned by the context interner
+        SymbolId id = InvalidSymbolId;
+        const std::string* name = &StringInterner::EmptyString;
 
         friend class ASM::Parser;
     public:
-        SymbolExpr(const std::string& symbolName) : name(symbolName) {}
+        AST_NODE_KIND(SymbolExpr)
 
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        SymbolExpr() : Expression(NodeKind::SymbolExpr) {}
 
-        bool IsDependent() const override;
-        bool Simplify() override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
-        std::vector<const std::string*> GetDependecies() const override;
+        bool IsDependent() const override;
+        bool Simplify(Arena& arena) override;
 
-        inline const std::string& GetName() const { return name; }
+        inline SymbolId GetId() const { return id; }
+        inline const std::string& GetName() const { return *name; }
     };
 
     struct DuplicateExpr : public Expression
@@ -189,24 +257,23 @@ namespace ASM::AST
     private:
         friend class ASM::Parser;
 
-        std::unique_ptr<Expression> countExpression;
-        std::unique_ptr<Expression> valueExpression;        
+        Expression* countExpression = nullptr;
+        Expression* valueExpression = nullptr;
     public:
-        DuplicateExpr(Expression* countExpr, Expression* valueExpr)
-        {
-            countExpression.reset(countExpr);
-            valueExpression.reset(valueExpr);
-        }
+        AST_NODE_KIND(DuplicateExpr)
 
-        int64_t Resolve(const std::unordered_map<std::string, int64_t>& symbolsMap = {}) const override;
+        DuplicateExpr(Expression* countExpr, Expression* valueExpr) :
+            Expression(NodeKind::DuplicateExpr), countExpression(countExpr), valueExpression(valueExpr) {}
 
-        bool IsDependent() const override;
-        bool Simplify() override;
+        int64_t Resolve(const SymbolValues& symbolValues = {}) const override;
 
-        std::vector<const std::string*> GetDependecies() const override;
+        bool IsDependent() const override;
+        bool Simplify(Arena& arena) override;
 
-        inline Expression* GetCountExpression() { return countExpression.get(); }
-        inline Expression* GetValueExpression() { return valueExpression.get(); }
+        inline Expression* GetCountExpression() { return countExpression; }
+        inline const Expression* GetCountExpression() const { return countExpression; }
+        inline Expression* GetValueExpression() { return valueExpression; }
+        inline const Expression* GetValueExpression() const { return valueExpression; }
     };
 }
 
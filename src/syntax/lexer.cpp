@@ -1,138 +1,72 @@
 #include "lexer.h"
 
+#include <cctype>
+#include <charconv>
+
 using namespace ASM;
 
-#define SS_TO_KIND(x, y) { x,  TokKind::y }
-#define KW_TO_KIND(x, y) { x,  TokKind::kw_ ## y }
-#define ID_TO_REG(x)     { #x, Arch::RegisterIdentifier::x }
+#define SS_TO_KIND(x, y) table[static_cast<uint8_t>(x)] = TokKind::y
 
-const std::unordered_map<char, TokKind> Lexer::SpecialSymbolsToKind = 
-{
-    SS_TO_KIND(',', comma),
-    SS_TO_KIND(':', colon),
-    SS_TO_KIND('[', l_square),
-    SS_TO_KIND(']', r_square),
-    SS_TO_KIND('(', l_paren),
-    SS_TO_KIND(')', r_paren),
-    SS_TO_KIND('-', minus),
-    SS_TO_KIND('~', tilda),
-    SS_TO_KIND('+', plus),
-    SS_TO_KIND('*', star),
-    SS_TO_KIND('/', slash),
-    SS_TO_KIND('?', question),
-    SS_TO_KIND('|', pipe),
-    SS_TO_KIND('&', amp),
-    SS_TO_KIND('^', caret),
-    SS_TO_KIND('@', at),
-    SS_TO_KIND('$', dolar),
-    SS_TO_KIND('<', lessless),
-    SS_TO_KIND('>', greatgreat),
-};
-
-const std::unordered_map<std::string, TokKind> Lexer::KeywordsToKind =
+static constexpr std::array<TokKind, 256> MakeSpecialSymbolsTable()
 {
-    KW_TO_KIND("SECTION", section),
-    KW_TO_KIND("SEGMENT", segment),
-    KW_TO_KIND("STACK",   stack),
-    KW_TO_KIND("OFFSET",  offset),
-    KW_TO_KIND("ORG",     org),
-    KW_TO_KIND("GLOBAL",  global),
-    KW_TO_KIND("EXTERN",  extern),
-    KW_TO_KIND("ALIGN",   align),
-    KW_TO_KIND("DUP",     dup),
-    KW_TO_KIND("EQU",     equ),
-    KW_TO_KIND("PTR",     ptr),
-    KW_TO_KIND("BYTE",    byte),
-    KW_TO_KIND("WORD",    word),
-    KW_TO_KIND("DWORD",   dword),
-    KW_TO_KIND("QWORD",   qword)
-};
-
-const std::unordered_map<std::string, Arch::RegisterIdentifier> Lexer::IdentifierToRegId = 
+    std::array<TokKind, 256> table{};
+    table.fill(TokKind::unknown);
+
+    SS_TO_KIND(',', comma);
+    SS_TO_KIND(':', colon);
+    SS_TO_KIND('[', l_square);
+    SS_TO_KIND(']', r_square);
+    SS_TO_KIND('(', l_paren);
+    SS_TO_KIND(')', r_paren);
+    SS_TO_KIND('-', minus);
+    SS_TO_KIND('~', tilda);
+    SS_TO_KIND('+', plus);
+    SS_TO_KIND('*', star);
+    SS_TO_KIND('/', slash);
+    SS_TO_KIND('?', question);
+    SS_TO_KIND('|', pipe);
+    SS_TO_KIND('&', amp);
+    SS_TO_KIND('^', caret);
+    SS_TO_KIND('@', at);
+    SS_TO_KIND('$', dolar);
+    SS_TO_KIND('<', lessless);
+    SS_TO_KIND('>', greatgreat);
+
+    return table;
+}
+
+const std::array<TokKind, 256> Lexer::SpecialSymbolsToKind = MakeSpecialSymbolsTable();
+
+static constexpr std::array<uint8_t, 256> MakeDigitValuesTable()
 {
-    ID_TO_REG(AL),
-    ID_TO_REG(AH),
-    ID_TO_REG(AX),
-    ID_TO_REG(CL),
-    ID_TO_REG(CH),
-    ID_TO_REG(CX),
-    ID_TO_REG(DL),
-    ID_TO_REG(DH),
-    ID_TO_REG(DX),
-    ID_TO_REG(BL),
-    ID_TO_REG(BH),
-    ID_TO_REG(BX),
-    ID_TO_REG(SI),
-    ID_TO_REG(DI),
-    ID_TO_REG(BP),
-    ID_TO_REG(SP),
-
-    ID_TO_REG(EAX),
-    ID_TO_REG(ECX),
-    ID_TO_REG(EDX),
-    ID_TO_REG(EBX),
-    ID_TO_REG(ESI),
-    ID_TO_REG(EDI),
-    ID_TO_REG(EBP),
-    ID_TO_REG(ESP),
-
-    ID_TO_REG(RAX),
-    ID_TO_REG(RCX),
-    ID_TO_REG(RDX),
-    ID_TO_REG(RBX),
-    ID_TO_REG(RSI),
-    ID_TO_REG(RDI),
-    ID_TO_REG(RBP),
-    ID_TO_REG(RSP),
-
-    ID_TO_REG(MM0),
-    ID_TO_REG(MM1),
-    ID_TO_REG(MM2),
-    ID_TO_REG(MM3),
-    ID_TO_REG(MM4),
-    ID_TO_REG(MM5),
-    ID_TO_REG(MM6),
-    ID_TO_REG(MM7),
-
-    ID_TO_REG(XMM0),
-    ID_TO_REG(XMM1),
-    ID_TO_REG(XMM2),
-    ID_TO_REG(XMM3),
-    ID_TO_REG(XMM4),
-    ID_TO_REG(XMM5),
-    ID_TO_REG(XMM6),
-    ID_TO_REG(XMM7),
-
-    ID_TO_REG(ES),
-    ID_TO_REG(CS),
-    ID_TO_REG(SS),
-    ID_TO_REG(DS),
-    ID_TO_REG(FS),
-    ID_TO_REG(GS),
-
-    ID_TO_REG(CR0),
-    ID_TO_REG(CR1),
-    ID_TO_REG(CR2),
-    ID_TO_REG(CR3),
-    ID_TO_REG(CR4),
-    ID_TO_REG(CR5),
-    ID_TO_REG(CR6),
-    ID_TO_REG(CR7)
-};
+    std::array<uint8_t, 256> table{};
+    table.fill(Lexer::notDigit);
+
+    for (unsigned int c = '0'; c <= '9'; ++c)
+        table[c] = c - '0';
+    for (unsigned int c = 'A'; c <= 'F'; ++c)
+        table[c] = table[c + ('a' - 'A')] = c - 'A' + 10;
+
+    return table;
+}
+
+const std::array<uint8_t, 256> Lexer::DigitValues = MakeDigitValuesTable();
 
 #undef SS_TO_KIND
-#undef KW_TO_KIND
-#undef ID_TO_REG
 
-Lexer::Lexer(AssemblyContext& context) : context(&context)
+Lexer::Lexer(AssemblyContext& context) : Lexer(context, context.GetSource())
+{}
+
+Lexer::Lexer(AssemblyContext& context, std::string_view range) : context(&context)
 {
-    cursor = context.GetSource().data();
-    cursor.line = 0;
+    begin = range.data();
+    end = range.data() + range.size();
+    cursor = begin;
 }
 
 void Lexer::TokenReinit(Token& token)
 {
-    token.data.reset();
+    token.value = 0;
     token.kind = TokKind::unknown;
     token.length = 0;
     token.location = cursor;
@@ -143,26 +77,28 @@ bool Lexer::IsValid() const
     return (cursor != nullptr);
 }
 
-void Lexer::SkipLine()
+bool Lexer::SkipTrivia()
 {
-    while (*cursor != '\n' && *cursor != '\0')
-        ++cursor;
+    unsigned int lines = 0;
 
-    if (*cursor == '\n')
-    {
-        ++cursor.line;
-        ++cursor;
-    }
+    cursor = Scanner::SkipWhitespace(cursor, lines);
+
+    while (*cursor == commentSym)
+        cursor = Scanner::SkipWhitespace(Scanner::SkipToLineEnd(cursor), lines);
+
+    return (lines > 0);
 }
 
 TokKind Lexer::LexSpecificSymbol(Token& result)
 {
-    if (SpecialSymbolsToKind.count(*cursor) == 0)
+    const TokKind symbolKind = SpecialSymbolsToKind[static_cast<uint8_t>(*cursor)];
+
+    if (symbolKind == TokKind::unknown)
         return TokKind::unknown;
 
     TokKind& kind = result.kind;
 
-    kind = SpecialSymbolsToKind.at(*cursor);
+    kind = symbolKind;
 
     switch (kind)
     {
@@ -201,15 +137,118 @@ TokKind Lexer::LexSpecificSymbol(Token& result)
     return kind;
 }
 
-TokKind Lexer::LexKeyword(Token& result)
+TokKind Lexer::LexReservedWord(Token& result)
 {
-    const std::string& value = reinterpret_cast<TokenString*>(result.data.get())->GetValue();
+    const ReservedWordId id = ReservedWords::Find(result.location, result.length);
+    const ReservedWord& word = ReservedWords::Get(id);
 
-    if (KeywordsToKind.count(value) == 0)
+    switch (word.kind)
+    {
+    case ReservedWord::Kind::Keyword:
+        result.kind = static_cast<TokKind>(word.value);
+        break;
+    case ReservedWord::Kind::Register:
+        result.kind = TokKind::reg;
+        result.value = static_cast<int64_t>(word.GetRegId());
+        break;
+    default:
+    {
+        //Mnemonics and directives can be used as label names, parser decides
+        SymbolId symbolId = InvalidSymbolId;
+
+        if (id == ReservedWords::None)
+        {
+            nameBuffer.assign(result.location, result.length);
+
+            for (auto& c : nameBuffer)
+                c = std::toupper(c);
+
+            symbolId = context->GetInterner().Intern(nameBuffer);
+        }
+
+        result.kind = TokKind::identifier;
+        result.value = static_cast<int64_t>(id) | static_cast<int64_t>(static_cast<uint64_t>(symbolId) << 32);
+        break;
+    }
+    }
+
+    return result.kind;
+}
+
+bool Lexer::ParseDigits(const char* begin, const char* end, unsigned int base, uint64_t& value, bool& overflow)
+{
+    if (begin == end)
+        return false;
+
+    value = 0;
+    overflow = false;
+
+    for (; begin != end; ++begin)
+    {
+        const uint8_t digit = DigitValues[static_cast<uint8_t>(*begin)];
+
+        if (digit >= base)
+            return false;
+
+        overflow |= __builtin_mul_overflow(value, base, &value);
+        overflow |= __builtin_add_overflow(value, digit, &value);
+    }
+
+    return true;
+}
+
+bool Lexer::ParseDecimalFraction(const char* begin, const char* end, uint64_t& value, bool& overflow)
+{
+    double number = 0;
+    const auto [pointer, error] = std::from_chars(begin, end, number, std::chars_format::general);
+
+    if (pointer != end || (error != std::errc() && error != std::errc::result_out_of_range))
+        return false;
+
+    //2^64 is the first value that doesn't fit
+    overflow = (error == std::errc::result_out_of_range || number >= 0x1p64);
+    value = (overflow ? 0 : static_cast<uint64_t>(number));
+
+    return true;
+}
+
+TokKind Lexer::LexNumber(Token& result)
+{
+    const char* begin = result.location;
+    const char* end = begin + result.length;
+
+    //Setting 0x20 bit turns letters into lower case
+    const char prefix = (result.length > 2 && begin[0] == '0') ? (begin[1] | 0x20) : '\0';
+    const char suffix = (result.length > 1) ? (end[-1] | 0x20) : '\0';
+
+    unsigned int base = 10;
+
+    if (prefix == 'x')
+        base = 16, begin += 2;
+    else if (suffix == 'h')
+        base = 16, --end;
+    else if (prefix == 'b')
+        base = 2, begin += 2;
+    else if (suffix == 'b')
+        base = 2, --end;
+    else if (prefix == 'o' || prefix == 'q')
+        base = 8, begin += 2;
+    else if (suffix == 'o' || suffix == 'q')
+        base = 8, --end;
+
+    uint64_t value = 0;
+    bool overflow = false;
+
+    //Not a number, lexed as identifier
+    if (ParseDigits(begin, end, base, value, overflow) == false && (base != 10 || ParseDecimalFraction(begin, end, value, overflow) == false))
         return TokKind::unknown;
 
-    result.kind = KeywordsToKind.at(value);
-    result.data.reset();
+    if (overflow) [[unlikely]]
+        context->Error("Numeric constant doesn't fit in 64 bits", result.location, result.length);
+
+    //Values above INT64_MAX keep their two's complement bit pattern
+    result.kind = TokKind::num_constant;
+    result.value = static_cast<int64_t>(value);
 
     return result.kind;
 }
@@ -231,7 +270,7 @@ TokKind Lexer::LexIdentifierOrLiteral(Token& result)
         
         result.kind = TokKind::char_constant;
         result.length = 3;
-        result.data = std::make_unique<TokenNumeric>(asciiChar);
+        result.value = asciiChar;
 
         return TokKind::char_constant;
     }
@@ -249,103 +288,36 @@ TokKind Lexer::LexIdentifierOrLiteral(Token& result)
 
         result.kind = TokKind::string_literal;
         result.length = cursor - result.location;
-        result.data = std::make_unique<TokenString>(result.location + 1, result.length - 2);
 
         return TokKind::string_literal;
     }
 
     //Identifier
-    while (std::isalnum(*cursor) || *cursor == '.' || *cursor == '_')
-        ++cursor;
+    cursor = Scanner::SkipIdentifier(cursor);
 
     result.length = cursor - result.location;
 
     if (result.length == 0)
         return TokKind::unknown;
 
-    std::string value(result.location, result.length);
-
-    for (auto& c : value)
-        c = std::toupper(c);
-
-    if (std::isdigit(value[0])) 
-    {
-        try
-        {
-            int base = 0;
-            const size_t lastPos = value.size() - 1;
-            const char* pos = value.c_str();
-
-            if (value.size() > 1) {
-                if (value.find("0X") == 0 || (value.find('H') == lastPos)) {
-                    base = 16;
-                }
-                else if (value.find("0B") == 0 || value.find('B') == lastPos) {
-                    base = 2;
-
-                    if (value[1] == 'B') [[likely]]
-                        pos += 2;
-                }
-                else if (value.find("0O") == 0 ||
-                        value.find("0Q") == 0 ||
-                        value.find('Q') == lastPos ||
-                        value.find('O') == lastPos) {
-                    base = 8;
-
-                    if (value[1] > '9' && value.back() <= '9') [[likely]]
-                        pos += 2;
-                }
-            }
-
-            double numericValue;
-
-            if (base == 0)
-                numericValue = std::stold(pos);
-            else
-                numericValue = std::stoull(pos, nullptr, base);
-
-            result.kind = TokKind::num_constant;
-            result.data = std::make_unique<TokenNumeric>(numericValue);
-        }
-        catch (std::out_of_range& e) {
-            return TokKind::unknown;
-        }
-        catch (...) {
-            goto parse_identifier;
-        }
-    }
-    else {
-        parse_identifier:
-        if (IdentifierToRegId.count(value) == 0)
-        {
-            result.kind = TokKind::identifier;
-            result.data = std::make_unique<TokenString>(std::move(value));
-            return TokKind::identifier;
-        }
-
-        result.kind = TokKind::reg;
-        result.data = std::make_unique<TokenNumeric>(IdentifierToRegId.at(value));
-    }
+    if (Scanner::Is(*result.location, Scanner::Digit) && LexNumber(result) == TokKind::num_constant)
+        return result.kind;
 
-    return result.kind;
+    return LexReservedWord(result);
 }
 
 bool Lexer::GetNextToken(Token& result)
 {
     assert(IsValid());
 
-    while (std::isspace(*cursor))
-        Next();
-
-    if (*cursor == commentSym)
-    {
-        SkipLine();
-        return GetNextToken(result);
-    }
+    const bool sourceStart = (cursor == begin);
+    const bool newLine = SkipTrivia() || sourceStart;
 
     TokenReinit(result);
 
-    if (*cursor == '\0')
+    result.firstOnLine = newLine;
+
+    if (*cursor == '\0' || cursor >= end)
     {
         result.kind = TokKind::eof;
         return false;
@@ -354,15 +326,9 @@ bool Lexer::GetNextToken(Token& result)
     if (LexSpecificSymbol(result) != TokKind::unknown || result.length > 0)
         return true;
 
-    if (LexIdentifierOrLiteral(result) != TokKind::unknown)
-    {
-        if (result.Is(TokKind::identifier))
-            LexKeyword(result);
-    }
-    else
+    if (LexIdentifierOrLiteral(result) == TokKind::unknown)
     {
-        while (std::isspace(*cursor) == false && *cursor != '\0')
-            Next();
+        cursor = Scanner::SkipUntilWhitespace(cursor);
 
         return false;
     }
@@ -1,11 +1,13 @@
 #ifndef __LEXER_H
 #define __LEXER_H
 
+#include <array>
 #include <sstream>
-#include <unordered_map>
 
 #include "context/context.h"
 #include "token.h"
+#include "scanner.h"
+#include "reserved-words.h"
 
 namespace ASM
 {
@@ -15,25 +17,40 @@ namespace ASM
         AssemblyContext* context = nullptr;
         SourceLocation cursor;
 
+        //Lexed range, eof is returned at its end
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        //Upper case copy of an identifier being interned
+        std::string nameBuffer;
+
         static constexpr char commentSym = ';';
 
         bool IsValid() const;
 
         void TokenReinit(Token& token);
 
-        inline void Next() { if (*(cursor++) == '\n') ++cursor.line; }
-
-        void SkipLine();
+        //Returns true if a newline was skipped
+        bool SkipTrivia();
 
         TokKind LexSpecificSymbol(Token& result);
-        TokKind LexKeyword(Token& result);
+        TokKind LexReservedWord(Token& result);
+        TokKind LexNumber(Token& result);
+
+        //Accumulates digits of [begin, end) in the given base, returns false if any of them isn't a valid digit
+        static bool ParseDigits(const char* begin, const char* end, unsigned int base, uint64_t& value, bool& overflow);
+        //Decimals with a fraction or an exponent, like 1.5 or 1e3, are truncated toward zero
+        static bool ParseDecimalFraction(const char* begin, const char* end, uint64_t& value, bool& overflow);
         TokKind LexIdentifierOrLiteral(Token& result);
     public:
         Lexer(AssemblyContext& context);
+        //Range must start at the beginning of a line and end right after a line break or at the end of source
+        Lexer(AssemblyContext& context, std::string_view range);
+
+        static constexpr uint8_t notDigit = 0xFF;
 
-        static const std::unordered_map<char, TokKind> SpecialSymbolsToKind;
-        static const std::unordered_map<std::string, TokKind> KeywordsToKind;
-        static const std::unordered_map<std::string, Arch::RegisterIdentifier> IdentifierToRegId;
+        static const std::array<TokKind, 256> SpecialSymbolsToKind;
+        static const std::array<uint8_t, 256> DigitValues;
 
         bool GetNextToken(Token& result);
     };
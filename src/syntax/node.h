@@ -1,36 +1,84 @@
 #ifndef __AST_NODE_H
 #define __AST_NODE_H
 
+#include <cassert>
+#include <cstdint>
 #include <type_traits>
 
 #include "context/source-location.h"
 
 namespace ASM { class Parser; }
 
+//Concrete node types, grouped so each base class covers a contiguous range of kinds
+#define ASM_AST_NODE_KINDS(X) \
+    X(NumberExpr)       \
+    X(RegisterExpr)     \
+    X(LiteralExpr)      \
+    X(UnaryExpr)        \
+    X(BinaryExpr)       \
+    X(ParenExpr)        \
+    X(MemoryExpr)       \
+    X(SymbolExpr)       \
+    X(DuplicateExpr)    \
+    X(SectionDecl)      \
+    X(SymbolDecl)       \
+    X(ConstantDecl)     \
+    X(LableDecl)        \
+    X(InstructionStmt)  \
+    X(DefineDataStmt)   \
+    X(OrgStmt)          \
+    X(OffsetStmt)       \
+    X(AlignStmt)        \
+    X(StackStmt)
+
+//Range of kinds that are instances of the declaring type, checked by Node::Is
+#define AST_NODE_KIND_RANGE(first, last) \
+    static constexpr NodeKind FirstKind = NodeKind::first; \
+    static constexpr NodeKind LastKind = NodeKind::last;
+
+#define AST_NODE_KIND(kind) AST_NODE_KIND_RANGE(kind, kind)
+
 namespace ASM::AST
 {
+    enum class NodeKind : uint8_t
+    {
+    #define NODE_TO_KIND(name) name,
+        ASM_AST_NODE_KINDS(NODE_TO_KIND)
+    #undef NODE_TO_KIND
+
+        Count
+    };
+
     struct Node
     {
     protected:
         SourceLocation location;
         unsigned int length = 0;
+    private:
+        NodeKind kind;
+    protected:
+        Node(NodeKind kind) : kind(kind) {}
 
         friend class ASM::Parser;
     public:
+        AST_NODE_KIND_RANGE(NumberExpr, StackStmt)
+
         template<typename T>
-        bool Is() const noexcept
+        inline bool Is() const noexcept
         {
             static_assert(std::is_base_of<Node, T>::value);
-            return (dynamic_cast<const T*>(this) != nullptr);
+            return (kind >= T::FirstKind && kind <= T::LastKind);
         }
 
         template<typename T>
         inline T* GetAs()
-        { static_assert(std::is_base_of<Node, T>::value); return reinterpret_cast<T*>(this); }
+        { static_assert(std::is_base_of<Node, T>::value); assert(Is<T>()); return static_cast<T*>(this); }
 
         template<typename T>
         inline const T* GetAs() const
-        { static_assert(std::is_base_of<Node, T>::value); return reinterpret_cast<const T*>(this); }
+        { static_assert(std::is_base_of<Node, T>::value); assert(Is<T>()); return static_cast<const T*>(this); }
+
+        inline NodeKind GetKind() const { return kind; }
 
         inline const SourceLocation& GetLocation() const { return location; }
         inline unsigned int GetLength() const { return length; }
@@ -39,4 +87,4 @@ namespace ASM::AST
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,124 +1,319 @@
 #include "parser.h"
 
 #include <iostream>
+#include <thread>
+#include <deque>
+#include <algorithm>
+#include <cassert>
 
 #include "arch/arch.h"
 
 using namespace ASM;
 using namespace ASM::AST;
 
-const std::unordered_map<char, uint8_t> Parser::operatorPriorities =
-{
-    {'|', 0},
-    {'^', 1},
-    {'&', 2},
-    {'>', 3},
-    {'<', 3},
-    {'+', 4},
-    {'-', 4},
-    {'*', 5},
-    {'/', 5},
-    {'~', 6}
-};
-
-const std::unordered_map<TokKind, char> Parser::kindOperatorToChar = 
-{
-    {TokKind::minus,      '-'},
-    {TokKind::plus,       '+'},
-    {TokKind::slash,      '/'},
-    {TokKind::star,       '*'},
-    {TokKind::tilda,      '~'},
-    {TokKind::amp,        '&'},
-    {TokKind::pipe,       '|'},
-    {TokKind::caret,      '^'},
-    {TokKind::greatgreat, '>'},
-    {TokKind::lessless,   '<'}
-};
+#define OPERATOR_TO_ENTRY(kind, symbol, priority) table[static_cast<size_t>(TokKind::kind)] = { symbol, priority }
 
-Token& Parser::NextToken()
+static constexpr std::array<Parser::Operator, static_cast<size_t>(TokKind::unknown) + 1> MakeOperatorsTable()
 {
-    if (tokenStream.empty() == false && tokenStream.front().Is(TokKind::eof))
-        return tokenStream.front();
+    std::array<Parser::Operator, static_cast<size_t>(TokKind::unknown) + 1> table{};
+
+    OPERATOR_TO_ENTRY(pipe,       '|', 0);
+    OPERATOR_TO_ENTRY(caret,      '^', 1);
+    OPERATOR_TO_ENTRY(amp,        '&', 2);
+    OPERATOR_TO_ENTRY(greatgreat, '>', 3);
+    OPERATOR_TO_ENTRY(lessless,   '<', 3);
+    OPERATOR_TO_ENTRY(plus,       '+', 4);
+    OPERATOR_TO_ENTRY(minus,      '-', 4);
+    OPERATOR_TO_ENTRY(star,       '*', 5);
+    OPERATOR_TO_ENTRY(slash,      '/', 5);
+    OPERATOR_TO_ENTRY(tilda,      '~', 6);
+
+    return table;
+}
 
-    if (context->IsCurrentMode(AssemblyMode::Direct))
-    {
-        tokenStream.pop_front();
+#undef OPERATOR_TO_ENTRY
 
-        return tokenStream.front();
-    }
+const std::array<Parser::Operator, static_cast<size_t>(TokKind::unknown) + 1> Parser::Operators = MakeOperatorsTable();
+
+Parser::Parser(AssemblyContext& context, Lexer& lexer) :
+    context(&context), lexer(&lexer), nodeArena(&context.GetTranslationUnit().GetNodeArena())
+{
+    if (context.IsCurrentMode(AssemblyMode::Parallel))
+        tokenRing = std::make_unique<TokenRing>();
+}
+
+Parser::Parser(AssemblyContext& context, Lexer& lexer, Arena& arena) :
+    context(&context), lexer(&lexer), nodeArena(&arena), chunk(std::make_unique<ChunkState>())
+{}
+
+void Parser::LexAll()
+{
+    Token token;
+
+    while (lexer->GetNextToken(token) || token.Is(TokKind::eof) == false)
+        tokenRing->Push(token);
 
-    uint64_t i = 0;
+    tokenRing->Push(token);
+}
+
+Token Parser::PullToken()
+{
+    if (context->IsCurrentMode(AssemblyMode::Parallel))
+        return tokenRing->Pop();
+
+    Token token;
+
+    //Unknown tokens are passed too, parser reports them
+    lexer->GetNextToken(token);
+
+    return token;
+}
+
+void Parser::FetchTokens(size_t count)
+{
+    assert(count <= tokenWindowSize);
+
+    //Nothing follows eof
+    while (windowEnd - windowBegin < count && (windowEnd == windowBegin || tokenWindow[(windowEnd - 1) & windowMask].Is(TokKind::eof) == false))
+        tokenWindow[windowEnd++ & windowMask] = PullToken();
+}
 
-    while (tokenStream.size() < 2);
+Token& Parser::NextToken()
+{
+    if (CurrentToken().Is(TokKind::eof))
+        return CurrentToken();
 
-    tokenStreamMutex.lock();
-    tokenStream.pop_front();
-    tokenStreamMutex.unlock();
+    FetchTokens(2);
+    ++windowBegin;
 
     //Debug
-    //std::cout << "Tok: " << std::string(tokenStream.front().GetLocation().sourcePointer, tokenStream.front().GetLength()) << std::endl;
+    //std::cout << "Tok: " << std::string(CurrentToken().GetLocation().sourcePointer, CurrentToken().GetLength()) << std::endl;
 
-    return tokenStream.front();
+    return CurrentToken();
 }
 
 Token& Parser::LookAhead()
 {
-    if (tokenStream.empty() == false && tokenStream.front().Is(TokKind::eof))
-        return tokenStream.front();
+    if (CurrentToken().Is(TokKind::eof))
+        return CurrentToken();
 
-    if (context->IsCurrentMode(AssemblyMode::Direct))
-        return *(++tokenStream.begin());
-    
-    //wait for lexer (async)
-    while (tokenStream.size() < 2);
+    FetchTokens(2);
 
-    return *(++tokenStream.begin());
+    return tokenWindow[(windowBegin + 1) & windowMask];
 }
 
-bool Parser::HasNextToken() const
+bool Parser::HasNextToken()
 {
-    if (tokenStream.empty() == false && tokenStream.front().Is(TokKind::eof))
-        return false;
+    FetchTokens(1);
+
+    return (CurrentToken().Is(TokKind::eof) == false);
+}
+
+SymbolId Parser::GetIdentifierId(const Token& token)
+{
+    if (token.GetSymbolId() != InvalidSymbolId) [[likely]]
+        return token.GetSymbolId();
+
+    //Reserved word used as a name
+    std::string name(token.GetString());
+
+    for (auto& c : name)
+        c = std::toupper(c);
+
+    return context->GetInterner().Intern(name);
+}
 
-    return (context->IsCurrentMode(AssemblyMode::Direct) && tokenStream.empty() == false);
+SymbolId Parser::MakeLocalName(const LableDecl& parent, SymbolId localName)
+{
+    return context->GetInterner().Intern(parent.GetName() + context->GetInterner().Get(localName));
 }
 
-void Parser::PushToken(Token&& token)
+//Splits source into ranges of about the same size, each one ends right after a line break
+static std::vector<std::string_view> SplitSource(std::string_view source, size_t count)
 {
-    if (context->IsCurrentMode(AssemblyMode::Direct))
+    std::vector<std::string_view> ranges;
+
+    const char* begin = source.data();
+    const char* const end = source.data() + source.size();
+
+    for (size_t i = 1; i <= count && begin != end; ++i)
     {
-        tokenStream.push_back(std::move(token));    
-        return;
+        const char* rangeEnd = std::max(begin, source.data() + source.size() * i / count);
+
+        if (i < count)
+        {
+            rangeEnd = std::find(rangeEnd, end, '\n');
+
+            if (rangeEnd != end)
+                ++rangeEnd;
+        }
+
+        ranges.emplace_back(begin, rangeEnd - begin);
+        begin = rangeEnd;
     }
 
-    tokenStreamMutex.lock();
-    tokenStream.push_back(std::move(token));
-    tokenStreamMutex.unlock();
+    return ranges;
 }
 
 AbstractSyntaxTree Parser::Parse()
 {
+    if (context->IsCurrentMode(AssemblyMode::Chunked))
+        return ParseChunked();
+
     AbstractSyntaxTree result;
 
-    result.push_back(std::make_unique<SectionDecl>(context->UnnamedSection.data()));
+    result.push_back(MakeNode<SectionDecl>());
     currentSection = result.back()->GetAs<SectionDecl>();
+    SetName(*currentSection, context->GetInterner().Intern(context->UnnamedSection));
+
+    //Lexer thread stops only after eof is pushed, parser always reads up to it
+    std::thread lexerThread;
+
+    if (context->IsCurrentMode(AssemblyMode::Parallel))
+        lexerThread = std::thread(&Parser::LexAll, this);
+
+    ParseStatements(result);
+
+    if (lexerThread.joinable())
+        lexerThread.join();
+
+    return std::move(result);
+}
+
+AbstractSyntaxTree Parser::ParseChunked()
+{
+    const std::string_view source = context->GetSource();
+    const size_t chunksCount = std::clamp<size_t>(source.size() / minChunkSize, 1, context->GetWorkersCount());
+
+    //Lexers are referenced by parsers, deque keeps them in place
+    std::deque<Lexer> lexers;
+    std::vector<std::unique_ptr<Parser>> chunkParsers;
+
+    for (auto range : SplitSource(source, chunksCount))
+    {
+        Lexer& chunkLexer = lexers.emplace_back(*context, range);
+
+        chunkParsers.emplace_back(new Parser(*context, chunkLexer, context->GetTranslationUnit().MakeNodeArena()));
+    }
+
+    std::vector<std::thread> workers;
+
+    if (chunkParsers.empty() == false)
+    {
+        chunkParsers.front()->chunk->isLeading = true;
+
+        for (size_t i = 1; i < chunkParsers.size(); ++i)
+            workers.emplace_back(&Parser::ParseStatements, chunkParsers[i].get(), std::ref(chunkParsers[i]->chunk->ast));
+
+        chunkParsers.front()->ParseStatements(chunkParsers.front()->chunk->ast);
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    AbstractSyntaxTree result;
+    size_t nodesCount = 1;
+
+    for (auto& chunkParser : chunkParsers)
+        nodesCount += chunkParser->chunk->ast.size();
+
+    result.reserve(nodesCount);
+    result.push_back(MakeNode<SectionDecl>());
+    currentSection = result.back()->GetAs<SectionDecl>();
+    SetName(*currentSection, context->GetInterner().Intern(context->UnnamedSection));
+
+    for (auto& chunkParser : chunkParsers)
+        MergeChunk(*chunkParser, result);
+
+    return result;
+}
+
+void Parser::MergeChunk(Parser& chunkParser, AbstractSyntaxTree& result)
+{
+    ChunkState& state = *chunkParser.chunk;
+
+    //Current state is the one left by all preceding chunks
+    for (LableDecl* lable : state.orphanLables)
+    {
+        if (currentParentLable == nullptr)
+        {
+            context->Error("Local lable declaration is outside of any parent lable", lable->location, lable->length);
+            continue;
+        }
+
+        SetName(*lable, MakeLocalName(*currentParentLable, lable->id));
+        currentParentLable->childLables.push_back(lable);
+    }
+
+    for (SymbolExpr* symbolExpr : state.orphanSymbols)
+    {
+        if (currentParentLable == nullptr)
+        {
+            context->Error("Using local lable symbol ouside of any parent lable", symbolExpr->location, symbolExpr->length);
+            continue;
+        }
+
+        SetName(*symbolExpr, MakeLocalName(*currentParentLable, symbolExpr->id));
+    }
+
+    //Cached dependencies still have the chunk-local names
+    for (Expression* expression : state.orphanDependents)
+        CacheDependencies(*expression);
+
+    currentSection->maxCodeSize += state.leadingCodeSize;
 
-    if (tokenStream.empty())
+    //Offsets inside of the chunk start from zero
+    for (Node* node : state.ast)
     {
-        if (context->IsCurrentMode(AssemblyMode::Parallel)) {
-            while(tokenStream.empty());
+        if (node->Is<SectionDecl>())
+        {
+            currentSection = node->GetAs<SectionDecl>();
         }
-        else {
-            return std::move(result);
+        else if (node->Is<LableDecl>())
+        {
+            LableDecl* lable = node->GetAs<LableDecl>();
+
+            if (lable->relatedSection == nullptr)
+                lable->relatedSection = currentSection;
+
+            lable->sectionStmtOffset += currentStmtOffset;
+        }
+        else if (node->Is<InstructionStmt>())
+        {
+            node->GetAs<InstructionStmt>()->sectionStmtOffset += currentStmtOffset;
         }
     }
+
+    for (SymbolDecl* declaration : state.symbols)
+        context->GetSymbolTable().AddSymbol(Symbol(declaration));
+
+    currentStmtOffset += chunkParser.currentStmtOffset;
+
+    if (chunkParser.currentParentLable != nullptr)
+        currentParentLable = chunkParser.currentParentLable;
+
+    result.insert(result.end(), state.ast.begin(), state.ast.end());
+}
+
+void Parser::AddSymbol(SymbolDecl& declaration)
+{
+    if (chunk != nullptr)
+        chunk->symbols.push_back(&declaration);
+    else
+        context->GetSymbolTable().AddSymbol(Symbol(&declaration));
+}
+
+void Parser::ParseStatements(AbstractSyntaxTree& result)
+{
+    FetchTokens(1);
   
-    Token* token = &tokenStream.front();
+    Token* token = &CurrentToken();
 
     while (token->Is(TokKind::eof) == false)
     {
         bool success = false;
-        bool isChanged = true;
+        //Failed statements that weren't pushed, like unknown identifiers, are not accounted
+        const size_t sizeBefore = result.size();
 
         try 
         {
@@ -128,16 +323,18 @@ AbstractSyntaxTree Parser::Parse()
             {
                 Token& nextTok = LookAhead();
 
-                bool nextTokSameLine = token->GetLocation().line == nextTok.GetLocation().line;
-                bool hasMnemonicWithSuchName = Arch::Arch8086::HasMnemonic(token->GetAsString()->GetValue());
+                const ReservedWord& word = token->GetReservedWord();
+
+                bool nextTokSameLine = token->IsSameLine(nextTok);
+                bool hasMnemonicWithSuchName = word.Is(ReservedWord::Kind::Mnemonic);
 
                 if (nextTokSameLine && nextTok.Is(TokKind::colon))
                 {
                     if (hasMnemonicWithSuchName)
                         context->Warn("Lable has the same name as mnemonic", token->GetLocation(), token->GetLength());
 
-                    result.push_back(std::make_unique<LableDecl>("", currentSection));
-                    success = ParseLableDecl(*reinterpret_cast<LableDecl*>(result.back().get()));
+                    result.push_back(MakeNode<LableDecl>(currentSection));
+                    success = ParseLableDecl(*reinterpret_cast<LableDecl*>(result.back()));
 
                     break;  
                 }
@@ -146,35 +343,34 @@ AbstractSyntaxTree Parser::Parse()
                     if (hasMnemonicWithSuchName)
                         context->Warn("Constant has the same name as mnemonic", token->GetLocation(), token->GetLength( ));
 
-                    result.push_back(std::make_unique<ConstantDecl>("", nullptr));
-                    success = ParseConstantDecl(*reinterpret_cast<ConstantDecl*>(result.back().get()));
+                    result.push_back(MakeNode<ConstantDecl>(nullptr));
+                    success = ParseConstantDecl(*reinterpret_cast<ConstantDecl*>(result.back()));
 
                     break;
                 }
                 else if (hasMnemonicWithSuchName)
                 {
-                    result.push_back(std::make_unique<InstructionStmt>());
-                    success = ParseInstructionStmt(*reinterpret_cast<InstructionStmt*>(result.back().get()));
+                    result.push_back(MakeNode<InstructionStmt>());
+                    success = ParseInstructionStmt(*reinterpret_cast<InstructionStmt*>(result.back()));
 
                     break;
                 }
-                else if (Arch::Arch8086::DefineDataMnemonics.count(token->GetAsString()->GetValue()) > 0)
+                else if (word.Is(ReservedWord::Kind::DefineData))
                 {
-                    result.push_back(std::make_unique<DefineDataStmt>());
-                    success = ParseDefineDataStmt(*reinterpret_cast<DefineDataStmt*>(result.back().get()));
+                    result.push_back(MakeNode<DefineDataStmt>());
+                    success = ParseDefineDataStmt(*reinterpret_cast<DefineDataStmt*>(result.back()));
 
                     break;
                 }
 
                 context->Error("Unknown identifier", token->GetLocation(), token->GetLength());
-                isChanged = false;
 
                 break;
             }
             case TokKind::kw_section: case TokKind::kw_segment:
             {
-                result.push_back(std::make_unique<SectionDecl>(""));
-                success = ParseSectionDecl(*reinterpret_cast<SectionDecl*>(result.back().get()));
+                result.push_back(MakeNode<SectionDecl>());
+                success = ParseSectionDecl(*reinterpret_cast<SectionDecl*>(result.back()));
 
                 currentSection = result.back()->GetAs<SectionDecl>();
 
@@ -182,35 +378,35 @@ AbstractSyntaxTree Parser::Parse()
             }
             case TokKind::kw_stack:
             {
-                result.push_back(std::make_unique<StackStmt>());
+                result.push_back(MakeNode<StackStmt>());
                 success = ParseParametricStmt(*result.back()->GetAs<ParametricStmt>());
 
                 break;
             }
             case TokKind::kw_extern: case TokKind::kw_global:
             {
-                result.push_back(std::make_unique<SymbolDecl>(""));
-                success = ParseSymbolDecl(*reinterpret_cast<SymbolDecl*>(result.back().get()));
+                result.push_back(MakeNode<SymbolDecl>());
+                success = ParseSymbolDecl(*reinterpret_cast<SymbolDecl*>(result.back()));
 
                 break;
             }
             case TokKind::kw_align:
             {
-                result.push_back(std::make_unique<AlignStmt>());
+                result.push_back(MakeNode<AlignStmt>());
                 success = ParseParametricStmt(*result.back()->GetAs<ParametricStmt>());
 
                 break;
             }
             case TokKind::kw_offset:
             {
-                result.push_back(std::make_unique<OffsetStmt>());
+                result.push_back(MakeNode<OffsetStmt>());
                 success = ParseParametricStmt(*result.back()->GetAs<ParametricStmt>());
 
                 break;
             }
             case TokKind::kw_org: 
             {
-                result.push_back(std::make_unique<OrgStmt>());
+                result.push_back(MakeNode<OrgStmt>());
                 success = ParseParametricStmt(*result.back()->GetAs<ParametricStmt>());
 
                 break;
@@ -219,17 +415,14 @@ AbstractSyntaxTree Parser::Parse()
             {
                 context->Error("Unknown syntax", token->GetLocation());
 
-                unsigned int currentLine = token->GetLocation().line;
                 Token* next = &LookAhead();
 
-                while (currentLine == next->GetLocation().line && next->Is(TokKind::eof) == false)
+                while (next->IsFirstOnLine() == false && next->Is(TokKind::eof) == false)
                 {
                     NextToken();
                     next = &LookAhead();
                 }
 
-                isChanged = false;
-
                 break;
             }
             }
@@ -241,93 +434,345 @@ AbstractSyntaxTree Parser::Parse()
             success = false;
         }
 
-        if (!success && isChanged)
+        const bool isPushed = (result.size() > sizeBefore);
+
+        if (isPushed && !success)
             result.pop_back();
-        else if (result.back()->Is<Statement>())
-            currentStmtOffset += result.back()->GetAs<Statement>()->GetMaxStmtByteSize();
+        else if (isPushed && result.back()->Is<Statement>())
+        {
+            const size_t maxStmtByteSize = result.back()->GetAs<Statement>()->GetMaxStmtByteSize();
+
+            currentStmtOffset += maxStmtByteSize;
+
+            //Chunk may start in the middle of a section declared by preceding chunks
+            if (currentSection != nullptr)
+                currentSection->maxCodeSize += maxStmtByteSize;
+            else
+                chunk->leadingCodeSize += maxStmtByteSize;
+        }
 
         token = &NextToken();
     }
-
-    return std::move(result);
 }
 
 bool Parser::ParsePrimary(Expression*& result)
 {
-    if (ParseExpression(result) == false)
+    assert(exprStack.empty() && operandStack.empty());
+
+    if (ParseExpressionStack(result, false) == false)
         return false;
 
-    Token* token = &LookAhead();
-    uint8_t operatorPriority = std::numeric_limits<uint8_t>::max();
+    CacheDependencies(*result);
+
+    return true;
+}
+
+void Parser::CacheDependencies(Expression& expression)
+{
+    //Scratch storage is per thread, chunks are parsed concurrently
+    thread_local std::vector<const Expression*> pending;
+    thread_local std::vector<SymbolId> dependencies;
 
-    while (token->GetLocation().line == tokenStream.front().GetLocation().line &&
-        (token->IsBinaryOperator() || token->IsUnaryOperator()))
+    bool dependent = false;
+
+    pending.clear();
+    dependencies.clear();
+    pending.push_back(&expression);
+
+    while (pending.empty() == false)
     {
-        if (token->IsUnaryOperator() && token->Is(TokKind::minus) == false)
+        const Expression* node = pending.back();
+        pending.pop_back();
+
+        //Subexpressions cached earlier aren't walked again
+        if (node != &expression && node->IsCached())
         {
-            delete result;
-            context->Error("Invalid expression, expected binary operator between", tokenStream.front().GetLocation());
-            return false;
+            auto cached = node->GetDependencies();
+
+            dependencies.insert(dependencies.end(), cached.begin(), cached.end());
+            dependent |= (node->IsConstant() == false);
+
+            continue;
         }
 
-        token = &NextToken();
+        switch (node->GetKind())
+        {
+        case NodeKind::SymbolExpr:
+            dependencies.push_back(node->GetAs<SymbolExpr>()->GetId());
+            dependent = true;
+            break;
+        case NodeKind::LiteralExpr:
+            dependent |= node->IsDependent();
+            break;
+        case NodeKind::UnaryExpr:
+            pending.push_back(node->GetAs<UnaryExpr>()->GetExpression());
+            break;
+        case NodeKind::BinaryExpr:
+            pending.push_back(node->GetAs<BinaryExpr>()->rhs);
+            pending.push_back(node->GetAs<BinaryExpr>()->lhs);
+            break;
+        case NodeKind::ParenExpr: case NodeKind::MemoryExpr:
+            pending.push_back(node->GetAs<ParenExpr>()->GetExpression());
+            break;
+        case NodeKind::DuplicateExpr:
+            pending.push_back(node->GetAs<DuplicateExpr>()->GetValueExpression());
+            pending.push_back(node->GetAs<DuplicateExpr>()->GetCountExpression());
+            break;
+        default:
+            break;
+        }
+    }
 
-        uint8_t currentOperatorPriority = operatorPriorities.at(kindOperatorToChar.at(token->GetKind()));
+    std::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
 
-        Token* next = &LookAhead();
+    //Orphan symbols are renamed by the merge, it caches the expression again
+    if (chunk != nullptr && currentParentLable == nullptr && chunk->orphanSymbols.empty() == false)
+    {
+        const StringInterner& interner = context->GetInterner();
 
-        if (token->GetLocation().line != next->GetLocation().line ||
-            next->IsKeyword() || next->IsBinaryOperator() ||
-            next->IsUnaryOperator())
-        {
-            delete result;
-            context->Error("Invalid binary expression", token->GetLocation());
+        if (std::any_of(dependencies.begin(), dependencies.end(), [&interner](SymbolId id) { return interner.Get(id)[0] == '.'; }))
+            chunk->orphanDependents.push_back(&expression);
+    }
 
-            return false;
-        }
+    if (dependencies.empty() == false)
+    {
+        SymbolId* storage = static_cast<SymbolId*>(nodeArena->Allocate(dependencies.size() * sizeof(SymbolId), alignof(SymbolId)));
+
+        std::copy(dependencies.begin(), dependencies.end(), storage);
+
+        expression.dependencies = storage;
+        expression.dependenciesCount = dependencies.size();
+    }
+
+    expression.flags = Expression::Cached | (dependent ? Expression::Dependent : 0);
+}
+
+bool Parser::ParseExpressionStack(Expression*& result, bool singleOperand)
+{
+    Expression* operand = nullptr;
 
-        if (operatorPriority < currentOperatorPriority)
+    for (;;)
+    {
+        //Prefix operators and opening parens are pushed until an operand is met
+        if (ParseExpression(operand) == false)
+            break;
+
+        if (operand == nullptr)
+            continue;
+
+        for (;;)
         {
-            BinaryExpr* currentBinaryExpr = reinterpret_cast<BinaryExpr*>(result);
-            Expression* currentRhs = currentBinaryExpr->rhs.release();
-            BinaryExpr* binaryExpr = new BinaryExpr();
+            CompleteOperand(operand);
 
-            if (ParseBinaryExpr(*binaryExpr, currentRhs) == false)
+            if (singleOperand && exprStack.empty())
             {
-                delete result;
-                delete currentRhs;
-                delete binaryExpr;
+                result = operandStack.back();
+                operandStack.pop_back();
 
-                return false;
+                return true;
             }
 
-            currentBinaryExpr->rhs.reset(binaryExpr);
-        }
-        else
-        {
-            BinaryExpr* binaryExpr = new BinaryExpr();
+            Token& next = LookAhead();
+
+            if (next.IsSameLine(CurrentToken()) && (next.IsBinaryOperator() || next.IsUnaryOperator()))
+                break;
+
+            ReduceBinaryExpr(0);
 
-            if (ParseBinaryExpr(*binaryExpr, result) == false)
+            if (exprStack.empty())
             {
-                delete binaryExpr;
-                delete result;
+                result = operandStack.back();
+                operandStack.pop_back();
 
-                return false;
+                return true;
             }
 
-            result = binaryExpr;
+            if (CloseParenExpr(operand) == false)
+                goto failed;
         }
 
-        operatorPriority = currentOperatorPriority;
-        token = &LookAhead();
+        if (PushBinaryOperator() == false)
+            break;
+    }
+
+failed:
+    exprStack.clear();
+    operandStack.clear();
+
+    return false;
+}
+
+void Parser::CompleteOperand(Expression* operand)
+{
+    //Prefix operators apply to a single operand
+    while (exprStack.empty() == false && exprStack.back().kind == PendingExpr::Kind::Unary)
+    {
+        UnaryExpr* unaryExpr = exprStack.back().node->GetAs<UnaryExpr>();
+
+        unaryExpr->expression = operand;
+        unaryExpr->length =
+            (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - unaryExpr->location.sourcePointer);
+
+        operand = unaryExpr;
+        exprStack.pop_back();
+    }
+
+    //Binary expression spans from its operator to the end of the operand right after it
+    if (exprStack.empty() == false && exprStack.back().kind == PendingExpr::Kind::Binary)
+    {
+        Expression* binaryExpr = exprStack.back().node;
+
+        binaryExpr->length =
+            (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - binaryExpr->location.sourcePointer);
+    }
+
+    operandStack.push_back(operand);
+}
+
+void Parser::ReduceBinaryExpr(uint8_t minPriority)
+{
+    while (exprStack.empty() == false && exprStack.back().kind == PendingExpr::Kind::Binary &&
+        exprStack.back().priority >= minPriority)
+    {
+        BinaryExpr* binaryExpr = exprStack.back().node->GetAs<BinaryExpr>();
+
+        binaryExpr->rhs = operandStack.back();
+        operandStack.pop_back();
+        binaryExpr->lhs = operandStack.back();
+        operandStack.back() = binaryExpr;
+
+        exprStack.pop_back();
+    }
+}
+
+bool Parser::PushBinaryOperator()
+{
+    Token* token = &LookAhead();
+
+    if (token->IsUnaryOperator() && token->Is(TokKind::minus) == false)
+    {
+        context->Error("Invalid expression, expected binary operator between", CurrentToken().GetLocation());
+        return false;
+    }
+
+    token = &NextToken();
+
+    const Operator& op = GetOperator(token->GetKind());
+    Token* next = &LookAhead();
+
+    if (token->IsSameLine(*next) == false ||
+        next->IsKeyword() || next->IsBinaryOperator() ||
+        next->IsUnaryOperator())
+    {
+        context->Error("Invalid binary expression", token->GetLocation());
+
+        return false;
+    }
+
+    //Operators of the same priority are left associative
+    ReduceBinaryExpr(op.priority);
+
+    BinaryExpr* binaryExpr = MakeNode<BinaryExpr>();
+
+    binaryExpr->location = token->GetLocation();
+    binaryExpr->operation = op.symbol;
+
+    exprStack.push_back({ PendingExpr::Kind::Binary, op.priority, TokKind::unknown, binaryExpr });
+
+    //'a - b' is parsed as 'a + (-b)'
+    if (token->Is(TokKind::minus))
+    {
+        binaryExpr->operation = GetOperator(TokKind::plus).symbol;
+
+        return OpenUnaryExpr();
     }
 
+    NextToken();
+
+    return true;
+}
+
+bool Parser::OpenUnaryExpr()
+{
+    assert(CurrentToken().IsUnaryOperator());
+
+    UnaryExpr* unaryExpr = MakeNode<UnaryExpr>();
+
+    unaryExpr->location = CurrentToken().GetLocation();
+    unaryExpr->operation = GetOperator(CurrentToken().GetKind()).symbol;
+
+    exprStack.push_back({ PendingExpr::Kind::Unary, 0, TokKind::unknown, unaryExpr });
+
+    NextToken();
+
+    return true;
+}
+
+bool Parser::OpenParenExpr(ParenExpr& result)
+{
+    assert(CurrentToken().Is(Token::Kind::l_paren) || CurrentToken().Is(Token::Kind::l_square));
+
+    result.location = CurrentToken().GetLocation();
+
+    if (LookAhead().IsSameLine(CurrentToken()) == false)
+    {
+        context->Error("Invalid paren expression", CurrentToken().GetLocation());
+
+        return false;
+    }
+
+    //Closing paren kind follows the opening one
+    const TokKind closing = static_cast<TokKind>(static_cast<uint8_t>(CurrentToken().GetKind()) + 1);
+
+    exprStack.push_back({ PendingExpr::Kind::Paren, 0, closing, &result });
+
+    NextToken();
+
+    return true;
+}
+
+bool Parser::CloseParenExpr(Expression*& result)
+{
+    assert(exprStack.back().kind == PendingExpr::Kind::Paren);
+
+    ParenExpr* parenExpr = exprStack.back().node->GetAs<ParenExpr>();
+    Token& next = LookAhead();
+
+    if (next.IsSameLine(CurrentToken()) == false || next.Is(exprStack.back().closing) == false)
+    {
+        if (exprStack.back().closing == Token::Kind::r_paren)
+            context->Error("Expected \')\', but paren is missing", parenExpr->location);
+        else
+            context->Error("Expected \']\', but paren is missing", parenExpr->location);
+
+        return false;
+    }
+
+    NextToken();
+
+    parenExpr->expression = operandStack.back();
+    operandStack.pop_back();
+
+    //Displacement is resolved and linked apart from the memory operand
+    if (parenExpr->Is<MemoryExpr>())
+    {
+        CacheDependencies(*parenExpr->expression);
+        parenExpr->GetAs<MemoryExpr>()->EvaluateAddressing();
+    }
+
+    parenExpr->length =
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - parenExpr->location.sourcePointer);
+
+    exprStack.pop_back();
+    result = parenExpr;
+
     return true;
 }
 
 bool Parser::ParseExpression(Expression*& result)
 {
-    Token* firstToken = &tokenStream.front();
+    Token* firstToken = &CurrentToken();
 
     //used only when parsing memory expression
     uint8_t memExprSizeOverride = 0;
@@ -338,7 +783,7 @@ bool Parser::ParseExpression(Expression*& result)
     case Token::Kind::reg:
     {
     parse_reg_expr:
-        result = new RegisterExpr(firstToken->GetAsNum()->GetRegId());
+        result = MakeNode<RegisterExpr>(firstToken->GetRegId());
         result->location = firstToken->GetLocation();
         result->length = firstToken->GetLength();
 
@@ -356,8 +801,6 @@ bool Parser::ParseExpression(Expression*& result)
             if (firstToken->Is(TokKind::l_square) == false) [[unlikely]]
             {
                 context->Error("Memory expression expected after segment register override", result->location);
-                delete result;
-
                 return false;
             }
 
@@ -368,7 +811,7 @@ bool Parser::ParseExpression(Expression*& result)
     }
     case Token::Kind::num_constant: case Token::Kind::char_constant:
     {
-        result = new NumberExpr(firstToken->GetAsNum()->GetValue());
+        result = MakeNode<NumberExpr>(firstToken->GetNum());
         result->location = firstToken->GetLocation();
         result->length = firstToken->GetLength();
 
@@ -404,52 +847,58 @@ bool Parser::ParseExpression(Expression*& result)
     parse_mem_expr:
         if (firstToken->Is(Token::Kind::l_square))
         {
-            MemoryExpr* memoryExpr = new MemoryExpr(nullptr);
+            MemoryExpr* memoryExpr = MakeNode<MemoryExpr>(nullptr);
             result = memoryExpr;
 
             if (memExprSizeOverride != 0)
                 memoryExpr->sizeOverride = memExprSizeOverride;
             if (memExprSegOverride != nullptr)
-                memoryExpr->segOverride.reset(memExprSegOverride);
+                memoryExpr->segOverride = memExprSegOverride;
         }
         else
         {
-            result = new ParenExpr(nullptr);
+            result = MakeNode<ParenExpr>(nullptr);
         }
 
-        if (ParseParenExpr(*reinterpret_cast<ParenExpr*>(result)) == false)
-        {
-            delete result;
+        if (OpenParenExpr(*result->GetAs<ParenExpr>()) == false)
             return false;
-        }
+
+        //Content is parsed on the expression stack
+        result = nullptr;
 
         break;
     }
     case Token::Kind::identifier:
     {
-        result = new SymbolExpr(firstToken->GetAsString()->GetValue());
+        SymbolExpr* symbolExpr = MakeNode<SymbolExpr>();
+        SetName(*symbolExpr, GetIdentifierId(*firstToken));
+
+        result = symbolExpr;
         result->location = firstToken->GetLocation();
         result->length = firstToken->GetLength();
 
-        if (result->GetAs<SymbolExpr>()->name[0] == '.')
+        if (symbolExpr->GetName()[0] == '.')
         {
-            if (currentParentLable == nullptr)
+            if (currentParentLable == nullptr && IsLeadingChunk() == false)
+            {
+                //Resolved when the chunk is merged
+                chunk->orphanSymbols.push_back(symbolExpr);
+                break;
+            }
+            else if (currentParentLable == nullptr)
             {
                 context->Error("Using local lable symbol ouside of any parent lable", result->location, result->length);
-                delete result;
-
                 return false;
             }
 
-            SymbolExpr* symbolExpr = result->GetAs<SymbolExpr>();
-            symbolExpr->name.insert(symbolExpr->name.begin(), currentParentLable->name.begin(), currentParentLable->name.end());
+            SetName(*symbolExpr, MakeLocalName(*currentParentLable, symbolExpr->id));
         }
 
         break;
     }
     case Token::Kind::string_literal:
     {
-        result = new LiteralExpr(firstToken->GetAsString()->GetValue());
+        result = MakeNode<LiteralExpr>(std::string(firstToken->GetString()));
         result->location = firstToken->GetLocation();
         result->length = firstToken->GetLength();
         break;
@@ -458,22 +907,28 @@ bool Parser::ParseExpression(Expression*& result)
     {
         NextToken();
 
-        if (tokenStream.front().Is(Token::Kind::identifier) == false)
+        if (CurrentToken().Is(Token::Kind::identifier) == false)
         {
-            context->Error("Unexpected token, segment name expected after \'@\'", tokenStream.front().GetLocation(), tokenStream.front().GetLength());
+            context->Error("Unexpected token, segment name expected after \'@\'", CurrentToken().GetLocation(), CurrentToken().GetLength());
             return false;
         }
 
-        result = new SymbolExpr('@' + tokenStream.front().GetAsString()->GetValue());
+        SymbolExpr* symbolExpr = MakeNode<SymbolExpr>();
+        SetName(*symbolExpr, context->GetInterner().Intern('@' + context->GetInterner().Get(GetIdentifierId(CurrentToken()))));
+
+        result = symbolExpr;
 
-        result->location = tokenStream.front().GetLocation();
-        result->length = tokenStream.front().GetLength();
+        result->location = CurrentToken().GetLocation();
+        result->length = CurrentToken().GetLength();
 
         break;
     }
     case Token::Kind::dolar: case Token::Kind::dolardolar:
     {
-        result = new SymbolExpr((firstToken->Is(Token::Kind::dolar) ? "$" : "$$"));
+        SymbolExpr* symbolExpr = MakeNode<SymbolExpr>();
+        SetName(*symbolExpr, context->GetInterner().Intern(firstToken->Is(Token::Kind::dolar) ? "$" : "$$"));
+
+        result = symbolExpr;
         result->location = firstToken->GetLocation();
         result->length = firstToken->GetLength();
 
@@ -481,7 +936,10 @@ bool Parser::ParseExpression(Expression*& result)
     }
     case Token::Kind::question:
     {
-        result = new SymbolExpr("?");
+        SymbolExpr* symbolExpr = MakeNode<SymbolExpr>();
+        SetName(*symbolExpr, context->GetInterner().Intern("?"));
+
+        result = symbolExpr;
         result->location = firstToken->GetLocation();
         result->length = firstToken->GetLength();
 
@@ -491,15 +949,9 @@ bool Parser::ParseExpression(Expression*& result)
     {
         if (firstToken->IsUnaryOperator())
         {
-            result = new UnaryExpr();
-
-            if (ParseUnaryExpr(*reinterpret_cast<UnaryExpr*>(result)) == false)
-            {
-                delete result;
-                return false;
-            }
+            result = nullptr;
 
-            break;
+            return OpenUnaryExpr();
         }
 
         context->Error("Invalid syntax", firstToken->GetLocation(), firstToken->GetLength());
@@ -512,154 +964,60 @@ bool Parser::ParseExpression(Expression*& result)
     return true;
 }
 
-bool Parser::ParseUnaryExpr(UnaryExpr& result)
-{
-    Token& token = tokenStream.front();
-
-    assert(token.IsUnaryOperator());
-
-    result.location = tokenStream.front().GetLocation();
-    result.operation = kindOperatorToChar.at(token.GetKind());
-
-    NextToken();
-
-    Expression* expression;
-
-    if (ParseExpression(expression) == false)
-        return false;
-
-    result.expression.reset(expression);
-
-    result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
-
-    return true;
-}
-
-bool Parser::ParseBinaryExpr(BinaryExpr& result, Expression* lhs)
-{
-    result.location = tokenStream.front().GetLocation();
-    result.operation = kindOperatorToChar.at(tokenStream.front().GetKind());
-    result.lhs.reset(lhs);
-
-    Expression* rhs;
-
-    if (tokenStream.front().Is(TokKind::minus))
-    {
-        result.operation = kindOperatorToChar.at(TokKind::plus);
-
-        rhs = new UnaryExpr();
-
-        if (ParseUnaryExpr(*reinterpret_cast<UnaryExpr*>(rhs)) == false)
-        {
-            result.lhs.release();
-            delete rhs;
-
-            return false;
-        }
-    }
-    else
-    {
-        NextToken();
-
-        if (ParseExpression(rhs) == false)
-        {
-            result.lhs.release();
-
-            return false;
-        }
-    }
-
-    result.rhs.reset(rhs);
-
-    result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
-
-    return true;
-}
-
 bool Parser::ParseRegExpr(RegisterExpr& result)
 {
-    result = RegisterExpr(tokenStream.front().GetAsNum()->GetRegId());
+    result = RegisterExpr(CurrentToken().GetRegId());
 
-    result.location = tokenStream.front().GetLocation();
-    result.length = tokenStream.front().GetLength();
+    result.location = CurrentToken().GetLocation();
+    result.length = CurrentToken().GetLength();
 
     return true;
 }
 
 bool Parser::ParseParenExpr(ParenExpr& result)
 {
-    assert(tokenStream.front().Is(Token::Kind::l_paren) || tokenStream.front().Is(Token::Kind::l_square));
-
-    result.location = tokenStream.front().GetLocation();
-
-    if (LookAhead().IsSameLine(tokenStream.front()) == false)
-    {
-        context->Error("Invalid paren expression", tokenStream.front().GetLocation());
+    assert(exprStack.empty() && operandStack.empty());
 
+    if (OpenParenExpr(result) == false)
         return false;
-    }
-
-    Token::Kind firstParen = tokenStream.front().GetKind();
-    SourceLocation beginLocation = tokenStream.front().GetLocation();
 
-    NextToken();
-
-    Expression* expression;
+    Expression* expression = nullptr;
 
-    if (ParsePrimary(expression) == false)
+    if (ParseExpressionStack(expression, true) == false)
         return false;
 
-    result.expression.reset(expression);
-
-    Token& next = LookAhead();
-
-    if (next.IsSameLine(tokenStream.front()) == false ||
-        next.Is(static_cast<Token::Kind>(static_cast<uint8_t>(firstParen) + 1)) == false)
-    {
-        if (firstParen == Token::Kind::l_paren)
-            context->Error("Expected \')\', but paren is missing", beginLocation);
-        else
-            context->Error("Expected \']\', but paren is missing", beginLocation);
-
-        return false;
-    }
-
-    NextToken();
-
-    result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+    CacheDependencies(result);
 
     return true;
 }
 
 bool Parser::ParseLiteralExpr(LiteralExpr& result)
 {
-    result = LiteralExpr(tokenStream.front().GetAsString()->GetValue());
+    result = LiteralExpr(std::string(CurrentToken().GetString()));
 
-    result.location = tokenStream.front().GetLocation();
-    result.length = tokenStream.front().GetLength();
+    result.location = CurrentToken().GetLocation();
+    result.length = CurrentToken().GetLength();
 
     return true;
 }
 
 bool Parser::ParseSymbolExpr(SymbolExpr& result)
 {
-    result = SymbolExpr(tokenStream.front().GetAsString()->GetValue());
+    result = SymbolExpr();
+    SetName(result, GetIdentifierId(CurrentToken()));
 
-    result.location = tokenStream.front().GetLocation();
-    result.length = tokenStream.front().GetLength();
+    result.location = CurrentToken().GetLocation();
+    result.length = CurrentToken().GetLength();
 
     return true;
 }
 
 bool Parser::ParseSymbolDecl(SymbolDecl& result)
 {
-    assert(tokenStream.front().IsKeyword());
+    assert(CurrentToken().IsKeyword());
 
-    result.location = tokenStream.front().GetLocation();
-    result.scope = static_cast<SymbolDecl::Scope>(tokenStream.front().GetKind());
+    result.location = CurrentToken().GetLocation();
+    result.scope = static_cast<SymbolDecl::Scope>(CurrentToken().GetKind());
 
     Token& identifier = NextToken();
 
@@ -670,50 +1028,58 @@ bool Parser::ParseSymbolDecl(SymbolDecl& result)
         return false;
     }
 
-    result.name = identifier.GetAsString()->GetValue();
+    SetName(result, GetIdentifierId(identifier));
     result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - result.location.sourcePointer);
 
-    context->GetSymbolTable().AddSymbol(Symbol(&result));
+    AddSymbol(result);
 
     return true;
 }
 
 bool Parser::ParseLableDecl(LableDecl& result)
 {
-    result.location = tokenStream.front().GetLocation();
-    result.name = tokenStream.front().GetAsString()->GetValue();
+    result.location = CurrentToken().GetLocation();
+    SetName(result, GetIdentifierId(CurrentToken()));
     result.sectionStmtOffset = currentStmtOffset;
 
     NextToken();
 
     result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - result.location.sourcePointer);
 
     //Local 
-    if (result.name[0] == '.') {
-        if (currentParentLable == nullptr)
+    if (result.GetName()[0] == '.') {
+        if (currentParentLable == nullptr && IsLeadingChunk() == false)
+        {
+            //Parent lable is in one of the preceding chunks
+            chunk->orphanLables.push_back(&result);
+            AddSymbol(result);
+
+            return true;
+        }
+        else if (currentParentLable == nullptr)
         {
             context->Error("Local lable declaration is outside of any parent lable", result.location, result.length);
             return false;
         }
 
-        result.name.insert(result.name.begin(), currentParentLable->name.begin(), currentParentLable->name.end());
+        SetName(result, MakeLocalName(*currentParentLable, result.id));
         currentParentLable->childLables.push_back(&result);
     }
     else {
         currentParentLable = &result;
     }
 
-    context->GetSymbolTable().AddSymbol(Symbol(&result));
+    AddSymbol(result);
 
     return true;
 }
 
 bool Parser::ParseConstantDecl(ConstantDecl& result)
 {
-    result.location = tokenStream.front().GetLocation();
-    result.name = tokenStream.front().GetAsString()->GetValue();
+    result.location = CurrentToken().GetLocation();
+    SetName(result, GetIdentifierId(CurrentToken()));
     
     //Skip equ
     NextToken();
@@ -724,46 +1090,48 @@ bool Parser::ParseConstantDecl(ConstantDecl& result)
     if (ParsePrimary(expression) == false)
         return false;
 
-    result.expression.reset(expression);
+    result.expression = expression;
 
-    context->GetSymbolTable().AddSymbol(Symbol(&result));
+    AddSymbol(result);
 
     result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - result.location.sourcePointer);
 
     return true;
 }
 
 bool Parser::ParseSectionDecl(SectionDecl& result)
 {
-    assert(tokenStream.front().Is(TokKind::kw_section) || tokenStream.front().Is(TokKind::kw_segment));
+    assert(CurrentToken().Is(TokKind::kw_section) || CurrentToken().Is(TokKind::kw_segment));
 
-    result.location = tokenStream.front().GetLocation();
+    result.location = CurrentToken().GetLocation();
 
     if (NextToken().Is(TokKind::identifier) == false)
     {
-        context->Error("Unexpected token or end of file", tokenStream.front().GetLocation(), tokenStream.front().GetLength());
+        context->Error("Unexpected token or end of file", CurrentToken().GetLocation(), CurrentToken().GetLength());
 
         return false;
     }
 
-    result.name = tokenStream.front().GetAsString()->GetValue();
+    SetName(result, GetIdentifierId(CurrentToken()));
     result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - result.location.sourcePointer);
 
     return true;
 }
 
 bool Parser::ParseInstructionStmt(InstructionStmt& result)
 {
-    assert(tokenStream.front().Is(TokKind::identifier));
+    assert(CurrentToken().Is(TokKind::identifier));
 
-    result.location = tokenStream.front().GetLocation();
-    result.mnemonic = tokenStream.front().GetAsString()->GetValue();
+    result.location = CurrentToken().GetLocation();
+    result.mnemonic = CurrentToken().GetReservedWord().GetMnemonic();
+    result.forms = &context->GetInstructionSet().at(result.mnemonic);
+    result.maxByteSize = context->GetInstructionSet().GetMaxByteSize(result.mnemonic);
 
     Token* next = &LookAhead();
 
-    while (next->Is(TokKind::eof) == false && next->GetLocation().line == tokenStream.front().GetLocation().line)
+    while (next->Is(TokKind::eof) == false && next->IsSameLine(CurrentToken()))
     {
         NextToken();
 
@@ -772,12 +1140,17 @@ bool Parser::ParseInstructionStmt(InstructionStmt& result)
         if (ParsePrimary(expression) == false)
             return false;
 
-        result.operands.push_back(nullptr);
-        result.operands.back().reset(expression);
+        if (result.operands.size() == result.operands.capacity())
+        {
+            context->Error("Too many operands", expression->GetLocation(), expression->GetLength());
+            return false;
+        }
+
+        result.operands.push_back(expression);
 
         next = &LookAhead();
 
-        if (next->Is(TokKind::comma) == false || next->GetLocation().line != tokenStream.front().GetLocation().line)
+        if (next->Is(TokKind::comma) == false || next->IsSameLine(CurrentToken()) == false)
             break;
 
         NextToken();
@@ -786,19 +1159,19 @@ bool Parser::ParseInstructionStmt(InstructionStmt& result)
 
     result.sectionStmtOffset = currentStmtOffset;
     result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - result.location.sourcePointer);
 
     return true;
 }
 
 bool Parser::ParseDefineDataStmt(DefineDataStmt& result)
 {
-    result.location = tokenStream.front().GetLocation();
-    result.dataUnitSize = Arch::Arch8086::DefineDataMnemonics.at(tokenStream.front().GetAsString()->GetValue());
+    result.location = CurrentToken().GetLocation();
+    result.dataUnitSize = CurrentToken().GetReservedWord().GetDataUnitSize();
 
     Token* next = &LookAhead();
 
-    while (next->Is(TokKind::eof) == false && next->GetLocation().line == tokenStream.front().GetLocation().line)
+    while (next->Is(TokKind::eof) == false && next->IsSameLine(CurrentToken()))
     {
         NextToken();
 
@@ -809,16 +1182,14 @@ bool Parser::ParseDefineDataStmt(DefineDataStmt& result)
 
         if (expression->Is<RegisterExpr>())
         {
-            delete expression;
-            context->Error("Register can't be a data unit", tokenStream.front().GetLocation());
+            context->Error("Register can't be a data unit", CurrentToken().GetLocation());
 
             NextToken();
 
             return false;
         }
 
-        result.units.push_back(nullptr);
-        result.units.back().reset(expression);
+        result.units.push_back(expression);
 
         next = &LookAhead();
 
@@ -826,14 +1197,13 @@ bool Parser::ParseDefineDataStmt(DefineDataStmt& result)
         {
             if (result.units.size() < 1)
             {
-                context->Error("Data define with \'dup\' requires count defenition before \'dup\' keyword", tokenStream.front().GetLocation());
+                context->Error("Data define with \'dup\' requires count defenition before \'dup\' keyword", CurrentToken().GetLocation());
 
                 return false;
             }
 
             //result.dupValue = std::make_unique<ParenExpr>(nullptr);
-            Expression* countExpr = result.units.back().get();
-            result.units.back().release();
+            Expression* countExpr = result.units.back();
 
             SourceLocation dupLocation = next->GetLocation();
 
@@ -842,7 +1212,7 @@ bool Parser::ParseDefineDataStmt(DefineDataStmt& result)
             //Skip kw_dup to '(' paren
             NextToken();
 
-            ParenExpr* valueExpr = new ParenExpr(nullptr);
+            ParenExpr* valueExpr = MakeNode<ParenExpr>(nullptr);
 
             if (ParseParenExpr(*valueExpr) == false)
             {
@@ -850,17 +1220,18 @@ bool Parser::ParseDefineDataStmt(DefineDataStmt& result)
                 return false;
             }
 
-            DuplicateExpr* dupExpr = new DuplicateExpr(countExpr, valueExpr);
+            DuplicateExpr* dupExpr = MakeNode<DuplicateExpr>(countExpr, valueExpr);
+            CacheDependencies(*dupExpr);
 
             dupExpr->location = dupLocation;
             dupExpr->length = valueExpr->GetLocation().sourcePointer + valueExpr->GetLength() - dupLocation.sourcePointer;
 
-            result.units.back().reset(dupExpr);
+            result.units.back() = dupExpr;
 
             next = &LookAhead();
         }
 
-        if (next->Is(TokKind::comma) == false || next->GetLocation().line != tokenStream.front().GetLocation().line)
+        if (next->Is(TokKind::comma) == false || next->IsSameLine(CurrentToken()) == false)
             break;
 
         NextToken();
@@ -868,14 +1239,14 @@ bool Parser::ParseDefineDataStmt(DefineDataStmt& result)
     }
 
     result.length =
-        (tokenStream.front().GetLocation().sourcePointer + tokenStream.front().GetLength() - result.location.sourcePointer);
+        (CurrentToken().GetLocation().sourcePointer + CurrentToken().GetLength() - result.location.sourcePointer);
 
     return true;
 }
 
 bool Parser::ParseParametricStmt(AST::ParametricStmt& result)
 {
-    result.location = tokenStream.front().GetLocation();
+    result.location = CurrentToken().GetLocation();
 
     Expression* value = nullptr;
 
@@ -885,7 +1256,7 @@ bool Parser::ParseParametricStmt(AST::ParametricStmt& result)
 
     if (success)
     {
-        result.value.reset(value);
+        result.value = value;
         result.length = value->GetLocation().sourcePointer + value->GetLength() - result.location.sourcePointer;
     }
 
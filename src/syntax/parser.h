@@ -1,13 +1,14 @@
 #ifndef __PARSER_H
 #define __PARSER_H
 
-#include <queue>
-#include <mutex>
+#include <array>
+#include <memory>
 #include <unordered_map>
-#include <list>
 
 #include "context/context.h"
 #include "token.h"
+#include "lexer.h"
+#include "token-ring.h"
 #include "ast.h"
 
 namespace ASM
@@ -17,33 +18,137 @@ namespace ASM
     private:
         AssemblyContext* context = nullptr;
 
-        std::list<Token> tokenStream;
-        std::mutex tokenStreamMutex;
+        Lexer* lexer = nullptr;
+        //Translation unit arena, all nodes are placed there
+        Arena* nodeArena = nullptr;
+
+        //Tokens are pulled on demand, only the current token and lookahead are kept
+        static constexpr size_t tokenWindowSize = 2;
+        static constexpr size_t windowMask = tokenWindowSize - 1;
+
+        std::array<Token, tokenWindowSize> tokenWindow;
+        size_t windowBegin = 0;
+        size_t windowEnd = 0;
+
+        //Filled by the lexer thread in parallel mode
+        std::unique_ptr<TokenRing> tokenRing;
 
         uint32_t currentStmtOffset = 0;
         AST::SectionDecl* currentSection = nullptr;
         AST::LableDecl* currentParentLable = nullptr;
 
-        static const std::unordered_map<char, uint8_t> operatorPriorities;
-        static const std::unordered_map<TokKind, char> kindOperatorToChar;
+        //Chunk parsers don't know the state left by preceding lines, it's fixed up when chunks are merged
+        struct ChunkState
+        {
+            AbstractSyntaxTree ast;
+            //First chunk starts at the beginning of source, there is no preceding state for it
+            bool isLeading = false;
+
+            //Local lables and local symbol references met before the first parent lable of the chunk
+            std::vector<AST::LableDecl*> orphanLables;
+            std::vector<AST::SymbolExpr*> orphanSymbols;
+            //Cached expressions with orphan symbols, cached again after the merge. Subexpressions come first.
+            std::vector<AST::Expression*> orphanDependents;
+            //Registered in the symbol table by the merge pass, in source order
+            std::vector<AST::SymbolDecl*> symbols;
+            //Max size of statements before the first section declaration of the chunk
+            size_t leadingCodeSize = 0;
+        };
+
+        //Set only for chunk parsers in chunked mode
+        std::unique_ptr<ChunkState> chunk;
+
+        //Chunks smaller than this aren't worth a thread
+        static constexpr size_t minChunkSize = 16 * 1024;
+
+        Parser(AssemblyContext& context, Lexer& lexer, Arena& arena);
+
+        inline bool IsLeadingChunk() const { return (chunk == nullptr || chunk->isLeading); }
+
+        void AddSymbol(AST::SymbolDecl& declaration);
+
+        void ParseStatements(AbstractSyntaxTree& result);
+        AbstractSyntaxTree ParseChunked();
+        void MergeChunk(Parser& chunkParser, AbstractSyntaxTree& result);
+
+        //Operator or paren waiting for its operands on the expression stack
+        struct PendingExpr
+        {
+            enum class Kind : uint8_t
+            {
+                Binary,
+                Unary,
+                Paren
+            };
+
+            Kind kind;
+            uint8_t priority = 0;
+            //Closing paren token kind
+            TokKind closing = TokKind::unknown;
+            AST::Expression* node = nullptr;
+        };
+
+        //Expressions are parsed iteratively, nesting depth doesn't grow the call stack.
+        //Kept between expressions to reuse storage.
+        std::vector<PendingExpr> exprStack;
+        std::vector<AST::Expression*> operandStack;
+
+        bool PushBinaryOperator();
+        void ReduceBinaryExpr(uint8_t minPriority);
+        void CompleteOperand(AST::Expression* operand);
+        bool CloseParenExpr(AST::Expression*& result);
+        //Runs until the expression is finished, or until the opened paren is closed if singleOperand is set
+        bool ParseExpressionStack(AST::Expression*& result, bool singleOperand);
+        //Collects symbols and flags of a complete expression once, codegen and linker read them from the node
+        void CacheDependencies(AST::Expression& expression);
+
+        //Interned upper case name of an identifier token
+        SymbolId GetIdentifierId(const Token& token);
+        //Local lable name prefixed with the parent one
+        SymbolId MakeLocalName(const AST::LableDecl& parent, SymbolId localName);
+
+        //Declarations and symbol expressions keep both the id and the interned string
+        template<typename T>
+        inline void SetName(T& node, SymbolId id) { node.id = id; node.name = &context->GetInterner().Get(id); }
+
+        template<typename T, typename... Args>
+        inline T* MakeNode(Args&&... args) { return nodeArena->Make<T>(std::forward<Args>(args)...); }
+
+        //Lexer thread body in parallel mode
+        void LexAll();
+
+        Token PullToken();
+        void FetchTokens(size_t count);
+
+        inline Token& CurrentToken() { return tokenWindow[windowBegin & windowMask]; }
 
         Token& NextToken();
         Token& LookAhead();
 
-        bool HasNextToken() const;
-        inline bool IsNextTokSameLine() { return (tokenStream.back().GetLocation().line == LookAhead().GetLocation().line); }
+        bool HasNextToken();
+        inline bool IsNextTokSameLine() { return (LookAhead().IsFirstOnLine() == false); }
     public:
-        Parser(AssemblyContext& context) : context(&context) {}
+        Parser(AssemblyContext& context, Lexer& lexer);
+
+        struct Operator
+        {
+            char symbol = '\0';
+            uint8_t priority = 0;
+        };
+
+        //Indexed by token kind, symbol is '\0' for tokens that aren't operators
+        static const std::array<Operator, static_cast<size_t>(TokKind::unknown) + 1> Operators;
 
-        void PushToken(Token&& token);
+        inline static const Operator& GetOperator(TokKind kind) { return Operators[static_cast<size_t>(kind)]; }
 
         AbstractSyntaxTree Parse();
 
         bool ParsePrimary(AST::Expression*& result);
+        //Parses single operand, result is null if a prefix operator or an opening paren was pushed instead
         bool ParseExpression(AST::Expression*& result);
 
-        bool ParseUnaryExpr(AST::UnaryExpr& result);
-        bool ParseBinaryExpr(AST::BinaryExpr& result, AST::Expression* lhs);
+        bool OpenUnaryExpr();
+        bool OpenParenExpr(AST::ParenExpr& result);
         bool ParseNumberExpr(AST::NumberExpr& result);
         bool ParseRegExpr(AST::RegisterExpr& result);
         bool ParseParenExpr(AST::ParenExpr& result);
@@ -0,0 +1,208 @@
+#include "reserved-words.h"
+
+#include <array>
+
+#include "token.h"
+
+using namespace ASM;
+
+using WordKind = ReservedWord::Kind;
+
+#define KW_TO_WORD(x, y)   { x,  WordKind::Keyword,     static_cast<uint8_t>(TokKind::kw_ ## y) }
+#define ID_TO_WORD(x)      { #x, WordKind::Register,    static_cast<uint8_t>(Arch::RegisterIdentifier::x) }
+#define MNEMONIC_TO_WORD(x){ #x, WordKind::Mnemonic,    static_cast<uint8_t>(Arch::Mnemonic::x) },
+#define DD_TO_WORD(x, y)   { x,  WordKind::DefineData,  y }
+#define RD_TO_WORD(x, y)   { x,  WordKind::ReserveData, y }
+
+static constexpr ReservedWord WordList[] =
+{
+    //Id 0 is reserved for "not a reserved word"
+    {},
+
+    KW_TO_WORD("SECTION", section),
+    KW_TO_WORD("SEGMENT", segment),
+    KW_TO_WORD("STACK",   stack),
+    KW_TO_WORD("OFFSET",  offset),
+    KW_TO_WORD("ORG",     org),
+    KW_TO_WORD("GLOBAL",  global),
+    KW_TO_WORD("EXTERN",  extern),
+    KW_TO_WORD("ALIGN",   align),
+    KW_TO_WORD("DUP",     dup),
+    KW_TO_WORD("EQU",     equ),
+    KW_TO_WORD("PTR",     ptr),
+    KW_TO_WORD("BYTE",    byte),
+    KW_TO_WORD("WORD",    word),
+    KW_TO_WORD("DWORD",   dword),
+    KW_TO_WORD("QWORD",   qword),
+
+    ID_TO_WORD(AL),  ID_TO_WORD(AH),  ID_TO_WORD(AX),
+    ID_TO_WORD(CL),  ID_TO_WORD(CH),  ID_TO_WORD(CX),
+    ID_TO_WORD(DL),  ID_TO_WORD(DH),  ID_TO_WORD(DX),
+    ID_TO_WORD(BL),  ID_TO_WORD(BH),  ID_TO_WORD(BX),
+    ID_TO_WORD(SI),  ID_TO_WORD(DI),  ID_TO_WORD(BP),  ID_TO_WORD(SP),
+
+    ID_TO_WORD(EAX), ID_TO_WORD(ECX), ID_TO_WORD(EDX), ID_TO_WORD(EBX),
+    ID_TO_WORD(ESI), ID_TO_WORD(EDI), ID_TO_WORD(EBP), ID_TO_WORD(ESP),
+
+    ID_TO_WORD(RAX), ID_TO_WORD(RCX), ID_TO_WORD(RDX), ID_TO_WORD(RBX),
+    ID_TO_WORD(RSI), ID_TO_WORD(RDI), ID_TO_WORD(RBP), ID_TO_WORD(RSP),
+
+    ID_TO_WORD(MM0), ID_TO_WORD(MM1), ID_TO_WORD(MM2), ID_TO_WORD(MM3),
+    ID_TO_WORD(MM4), ID_TO_WORD(MM5), ID_TO_WORD(MM6), ID_TO_WORD(MM7),
+
+    ID_TO_WORD(XMM0), ID_TO_WORD(XMM1), ID_TO_WORD(XMM2), ID_TO_WORD(XMM3),
+    ID_TO_WORD(XMM4), ID_TO_WORD(XMM5), ID_TO_WORD(XMM6), ID_TO_WORD(XMM7),
+
+    ID_TO_WORD(ES),  ID_TO_WORD(CS),  ID_TO_WORD(SS),
+    ID_TO_WORD(DS),  ID_TO_WORD(FS),  ID_TO_WORD(GS),
+
+    ID_TO_WORD(CR0), ID_TO_WORD(CR1), ID_TO_WORD(CR2), ID_TO_WORD(CR3),
+    ID_TO_WORD(CR4), ID_TO_WORD(CR5), ID_TO_WORD(CR6), ID_TO_WORD(CR7),
+
+    ASM_8086_MNEMONICS(MNEMONIC_TO_WORD)
+
+    DD_TO_WORD("DB", 1), DD_TO_WORD("DW", 2), DD_TO_WORD("DD", 4), DD_TO_WORD("DQ", 8), DD_TO_WORD("DT", 10),
+    RD_TO_WORD("RESB", 1), RD_TO_WORD("RESW", 2), RD_TO_WORD("RESD", 4), RD_TO_WORD("RESQ", 8), RD_TO_WORD("REST", 10)
+};
+
+#undef KW_TO_WORD
+#undef ID_TO_WORD
+#undef MNEMONIC_TO_WORD
+#undef DD_TO_WORD
+#undef RD_TO_WORD
+
+static constexpr size_t wordsCount = std::size(WordList);
+
+static_assert(wordsCount <= 256, "ReservedWordId is too narrow");
+
+//Hash and displace scheme: the first level hash selects a bucket,
+//bucket displacement is chosen at compile time so that no two words share a slot
+static constexpr size_t bucketsCount = 64;
+static constexpr size_t slotsCount = 256;
+
+static_assert(wordsCount <= slotsCount);
+
+struct PerfectHash
+{
+    std::array<uint16_t, bucketsCount> displacements{};
+    std::array<ReservedWordId, slotsCount> slots{};
+    size_t maxWordLength = 0;
+};
+
+//Setting 0x20 bit folds letter case, other identifier characters stay distinct
+static constexpr inline uint8_t FoldCase(char c) { return static_cast<uint8_t>(c) | 0x20; }
+
+static constexpr inline uint32_t Hash(const char* text, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= FoldCase(text[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static constexpr inline size_t GetSlot(uint32_t hash, uint16_t displacement)
+{
+    hash ^= displacement * 0x9E3779B9u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+
+    return hash & (slotsCount - 1);
+}
+
+static constexpr PerfectHash MakePerfectHash()
+{
+    PerfectHash result;
+
+    std::array<uint32_t, wordsCount> hashes{};
+    std::array<size_t, bucketsCount> bucketSizes{};
+    std::array<size_t, bucketsCount> order{};
+    std::array<bool, slotsCount> used{};
+
+    for (size_t id = 1; id < wordsCount; ++id)
+    {
+        hashes[id] = Hash(WordList[id].name.data(), WordList[id].name.size());
+        ++bucketSizes[hashes[id] & (bucketsCount - 1)];
+
+        if (WordList[id].name.size() > result.maxWordLength)
+            result.maxWordLength = WordList[id].name.size();
+    }
+
+    //Place largest buckets first
+    for (size_t i = 0; i < bucketsCount; ++i)
+        order[i] = i;
+
+    for (size_t i = 0; i < bucketsCount; ++i)
+        for (size_t j = i + 1; j < bucketsCount; ++j)
+            if (bucketSizes[order[j]] > bucketSizes[order[i]])
+                std::swap(order[i], order[j]);
+
+    for (size_t bucket : order)
+    {
+        if (bucketSizes[bucket] == 0)
+            break;
+
+        bool placed = false;
+
+        for (uint32_t displacement = 0; displacement <= UINT16_MAX && placed == false; ++displacement)
+        {
+            std::array<bool, slotsCount> taken = used;
+            placed = true;
+
+            for (size_t id = 1; id < wordsCount && placed; ++id)
+            {
+                if ((hashes[id] & (bucketsCount - 1)) != bucket)
+                    continue;
+
+                const size_t slot = GetSlot(hashes[id], displacement);
+
+                placed = (taken[slot] == false);
+                taken[slot] = true;
+            }
+
+            if (placed == false)
+                continue;
+
+            for (size_t id = 1; id < wordsCount; ++id)
+                if ((hashes[id] & (bucketsCount - 1)) == bucket)
+                    result.slots[GetSlot(hashes[id], displacement)] = id;
+
+            result.displacements[bucket] = displacement;
+            used = taken;
+        }
+
+        //Duplicate words never get separate slots
+        if (placed == false)
+            throw "Reserved words perfect hash can't be built";
+    }
+
+    return result;
+}
+
+static constexpr PerfectHash WordsHash = MakePerfectHash();
+
+const ReservedWord* const ReservedWords::words = WordList;
+
+ReservedWordId ReservedWords::Find(const char* text, size_t length)
+{
+    if (length > WordsHash.maxWordLength) [[unlikely]]
+        return None;
+
+    const uint32_t hash = Hash(text, length);
+    const ReservedWordId id = WordsHash.slots[GetSlot(hash, WordsHash.displacements[hash & (bucketsCount - 1)])];
+    const std::string_view name = WordList[id].name;
+
+    if (name.size() != length)
+        return None;
+
+    for (size_t i = 0; i < length; ++i)
+        if (FoldCase(text[i]) != FoldCase(name[i]))
+            return None;
+
+    return id;
+}
@@ -0,0 +1,64 @@
+#ifndef __RESERVED_WORDS_H
+#define __RESERVED_WORDS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <string_view>
+
+#include "arch/8086/regs.h"
+#include "arch/8086/mnemonics.h"
+
+namespace ASM
+{
+    //Index of a reserved word, 0 is never assigned to a word
+    using ReservedWordId = uint8_t;
+
+    struct ReservedWord
+    {
+        enum class Kind : uint8_t
+        {
+            None,
+            Keyword,
+            Register,
+            Mnemonic,
+            DefineData,
+            ReserveData
+        };
+
+        std::string_view name;
+        Kind kind = Kind::None;
+
+        //Token kind of a keyword, register identifier, mnemonic or data unit size
+        uint8_t value = 0;
+
+        inline bool Is(Kind intendentKind) const { return (kind == intendentKind); }
+
+        inline Arch::RegisterIdentifier GetRegId() const
+        { assert(kind == Kind::Register); return static_cast<Arch::RegisterIdentifier>(value); }
+
+        inline Arch::Mnemonic GetMnemonic() const
+        { assert(kind == Kind::Mnemonic); return static_cast<Arch::Mnemonic>(value); }
+
+        inline uint8_t GetDataUnitSize() const
+        { assert(kind == Kind::DefineData || kind == Kind::ReserveData); return value; }
+    };
+
+    //Keywords, registers, mnemonics and data directives looked up through a perfect hash
+    //generated at compile time. Matching is case insensitive and works on source bytes directly.
+    class ReservedWords
+    {
+    private:
+        static const ReservedWord* const words;
+    public:
+        static constexpr ReservedWordId None = 0;
+
+        //Returns None if the text isn't a reserved word
+        static ReservedWordId Find(const char* text, size_t length);
+        static inline ReservedWordId Find(std::string_view text) { return Find(text.data(), text.size()); }
+
+        static inline const ReservedWord& Get(ReservedWordId id) { return words[id]; }
+    };
+}
+
+#endif
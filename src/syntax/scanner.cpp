@@ -0,0 +1,299 @@
+#include "scanner.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define ASM_SCANNER_X86
+    #include <immintrin.h>
+#endif
+
+using namespace ASM;
+
+//Scalar fallback
+
+static const char* SkipWhitespaceScalar(const char* pos, unsigned int& lines)
+{
+    while (Scanner::Is(*pos, Scanner::Whitespace))
+    {
+        if (*pos == '\n')
+            ++lines;
+
+        ++pos;
+    }
+
+    return pos;
+}
+
+static const char* SkipToLineEndScalar(const char* pos)
+{
+    while (*pos != '\n' && *pos != '\0')
+        ++pos;
+
+    return pos;
+}
+
+static const char* SkipIdentifierScalar(const char* pos)
+{
+    while (Scanner::Is(*pos, Scanner::Identifier))
+        ++pos;
+
+    return pos;
+}
+
+#ifdef ASM_SCANNER_X86
+
+//Block implementations use only aligned loads: an aligned block never crosses a page boundary,
+//so reading the whole block that contains the terminating '\0' is always safe.
+//Bits of the first block that lie before 'pos' are masked out.
+
+#ifdef __SSE2__
+
+static inline uint32_t WhitespaceMaskSSE2(__m128i data)
+{
+    const __m128i space = _mm_cmpeq_epi8(data, _mm_set1_epi8(' '));
+    //'\t', '\n', '\v', '\f', '\r' are in [9, 13], bytes >= 0x80 are negative and never match
+    const __m128i control = _mm_and_si128(
+        _mm_cmpgt_epi8(data, _mm_set1_epi8('\t' - 1)),
+        _mm_cmplt_epi8(data, _mm_set1_epi8('\r' + 1))
+    );
+
+    return _mm_movemask_epi8(_mm_or_si128(space, control));
+}
+
+static const char* SkipWhitespaceSSE2(const char* pos, unsigned int& lines)
+{
+    const uintptr_t misalign = reinterpret_cast<uintptr_t>(pos) & 15;
+    const char* block = pos - misalign;
+    uint32_t validMask = (0xFFFFu << misalign) & 0xFFFFu;
+
+    while (true)
+    {
+        const __m128i data = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        const uint32_t newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(data, _mm_set1_epi8('\n'))) & validMask;
+        const uint32_t stop = ~WhitespaceMaskSSE2(data) & validMask;
+
+        if (stop != 0)
+        {
+            const unsigned int index = __builtin_ctz(stop);
+
+            lines += __builtin_popcount(newlines & ((1u << index) - 1));
+            return block + index;
+        }
+
+        lines += __builtin_popcount(newlines);
+        block += 16;
+        validMask = 0xFFFF;
+    }
+}
+
+static const char* SkipToLineEndSSE2(const char* pos)
+{
+    const uintptr_t misalign = reinterpret_cast<uintptr_t>(pos) & 15;
+    const char* block = pos - misalign;
+    uint32_t validMask = (0xFFFFu << misalign) & 0xFFFFu;
+
+    while (true)
+    {
+        const __m128i data = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        const __m128i stopBytes = _mm_or_si128(
+            _mm_cmpeq_epi8(data, _mm_set1_epi8('\n')),
+            _mm_cmpeq_epi8(data, _mm_setzero_si128())
+        );
+        const uint32_t stop = _mm_movemask_epi8(stopBytes) & validMask;
+
+        if (stop != 0)
+            return block + __builtin_ctz(stop);
+
+        block += 16;
+        validMask = 0xFFFF;
+    }
+}
+
+static inline uint32_t IdentifierMaskSSE2(__m128i data)
+{
+    //Setting 0x20 bit maps 'A'-'Z' onto 'a'-'z' and nothing else onto that range
+    const __m128i lower = _mm_or_si128(data, _mm_set1_epi8(0x20));
+    const __m128i alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))
+    );
+    const __m128i digit = _mm_and_si128(
+        _mm_cmpgt_epi8(data, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(data, _mm_set1_epi8('9' + 1))
+    );
+    const __m128i other = _mm_or_si128(
+        _mm_cmpeq_epi8(data, _mm_set1_epi8('.')),
+        _mm_cmpeq_epi8(data, _mm_set1_epi8('_'))
+    );
+
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), other));
+}
+
+static const char* SkipIdentifierSSE2(const char* pos)
+{
+    const uintptr_t misalign = reinterpret_cast<uintptr_t>(pos) & 15;
+    const char* block = pos - misalign;
+    uint32_t validMask = (0xFFFFu << misalign) & 0xFFFFu;
+
+    while (true)
+    {
+        const __m128i data = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        const uint32_t stop = ~IdentifierMaskSSE2(data) & validMask;
+
+        if (stop != 0)
+            return block + __builtin_ctz(stop);
+
+        block += 16;
+        validMask = 0xFFFF;
+    }
+}
+
+#endif
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET static inline uint32_t WhitespaceMaskAVX2(__m256i data)
+{
+    const __m256i space = _mm256_cmpeq_epi8(data, _mm256_set1_epi8(' '));
+    const __m256i control = _mm256_and_si256(
+        _mm256_cmpgt_epi8(data, _mm256_set1_epi8('\t' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), data)
+    );
+
+    return _mm256_movemask_epi8(_mm256_or_si256(space, control));
+}
+
+AVX2_TARGET static const char* SkipWhitespaceAVX2(const char* pos, unsigned int& lines)
+{
+    const uintptr_t misalign = reinterpret_cast<uintptr_t>(pos) & 31;
+    const char* block = pos - misalign;
+    uint32_t validMask = ~0u << misalign;
+
+    while (true)
+    {
+        const __m256i data = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+        const uint32_t newlines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('\n'))) & validMask;
+        const uint32_t stop = ~WhitespaceMaskAVX2(data) & validMask;
+
+        if (stop != 0)
+        {
+            const unsigned int index = __builtin_ctz(stop);
+
+            lines += __builtin_popcount(newlines & ((1u << index) - 1));
+            return block + index;
+        }
+
+        lines += __builtin_popcount(newlines);
+        block += 32;
+        validMask = ~0u;
+    }
+}
+
+AVX2_TARGET static const char* SkipToLineEndAVX2(const char* pos)
+{
+    const uintptr_t misalign = reinterpret_cast<uintptr_t>(pos) & 31;
+    const char* block = pos - misalign;
+    uint32_t validMask = ~0u << misalign;
+
+    while (true)
+    {
+        const __m256i data = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+        const __m256i stopBytes = _mm256_or_si256(
+            _mm256_cmpeq_epi8(data, _mm256_set1_epi8('\n')),
+            _mm256_cmpeq_epi8(data, _mm256_setzero_si256())
+        );
+        const uint32_t stop = _mm256_movemask_epi8(stopBytes) & validMask;
+
+        if (stop != 0)
+            return block + __builtin_ctz(stop);
+
+        block += 32;
+        validMask = ~0u;
+    }
+}
+
+AVX2_TARGET static inline uint32_t IdentifierMaskAVX2(__m256i data)
+{
+    const __m256i lower = _mm256_or_si256(data, _mm256_set1_epi8(0x20));
+    const __m256i alpha = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower)
+    );
+    const __m256i digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(data, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), data)
+    );
+    const __m256i other = _mm256_or_si256(
+        _mm256_cmpeq_epi8(data, _mm256_set1_epi8('.')),
+        _mm256_cmpeq_epi8(data, _mm256_set1_epi8('_'))
+    );
+
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), other));
+}
+
+AVX2_TARGET static const char* SkipIdentifierAVX2(const char* pos)
+{
+    const uintptr_t misalign = reinterpret_cast<uintptr_t>(pos) & 31;
+    const char* block = pos - misalign;
+    uint32_t validMask = ~0u << misalign;
+
+    while (true)
+    {
+        const __m256i data = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+        const uint32_t stop = ~IdentifierMaskAVX2(data) & validMask;
+
+        if (stop != 0)
+            return block + __builtin_ctz(stop);
+
+        block += 32;
+        validMask = ~0u;
+    }
+}
+
+#undef AVX2_TARGET
+
+#endif
+
+Scanner::Implementation Scanner::GetBestImplementation()
+{
+#ifdef ASM_SCANNER_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return Implementation::AVX2;
+#ifdef __SSE2__
+    return Implementation::SSE2;
+#endif
+#endif
+
+    return Implementation::Scalar;
+}
+
+Scanner::Dispatch Scanner::SelectDispatch(Implementation impl)
+{
+    switch (impl)
+    {
+#ifdef ASM_SCANNER_X86
+    case Implementation::AVX2:
+        return { SkipWhitespaceAVX2, SkipToLineEndAVX2, SkipIdentifierAVX2 };
+#ifdef __SSE2__
+    case Implementation::SSE2:
+        return { SkipWhitespaceSSE2, SkipToLineEndSSE2, SkipIdentifierSSE2 };
+#endif
+#endif
+    default:
+        return { SkipWhitespaceScalar, SkipToLineEndScalar, SkipIdentifierScalar };
+    }
+}
+
+Scanner::Implementation Scanner::implementation = Scanner::GetBestImplementation();
+Scanner::Dispatch Scanner::dispatch = Scanner::SelectDispatch(Scanner::implementation);
+
+bool Scanner::SetImplementation(Implementation impl)
+{
+    if (static_cast<uint8_t>(impl) > static_cast<uint8_t>(GetBestImplementation()))
+        return false;
+
+    implementation = impl;
+    dispatch = SelectDispatch(impl);
+
+    return true;
+}
@@ -0,0 +1,129 @@
+#ifndef __SCANNER_H
+#define __SCANNER_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace ASM
+{
+    //Character classification and block skipping primitives used by lexer hot loops.
+    //All skip functions stop at '\0', the source must be null terminated.
+    class Scanner
+    {
+    public:
+        enum CharClass : uint8_t
+        {
+            None       = 0,
+            Whitespace = 1 << 0,
+            Newline    = 1 << 1,
+            Identifier = 1 << 2,
+            Digit      = 1 << 3,
+            Symbol     = 1 << 4,
+            Quote      = 1 << 5,
+            Comment    = 1 << 6,
+            Terminator = 1 << 7
+        };
+
+        enum class Implementation : uint8_t
+        {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+    private:
+        struct Dispatch
+        {
+            const char* (*skipWhitespace)(const char* pos, unsigned int& lines);
+            const char* (*skipToLineEnd)(const char* pos);
+            const char* (*skipIdentifier)(const char* pos);
+        };
+
+        static Dispatch dispatch;
+        static Implementation implementation;
+
+        static constexpr unsigned int shortRunLength = 8;
+
+        static constexpr std::array<uint8_t, 256> MakeCharClassTable()
+        {
+            std::array<uint8_t, 256> table{};
+
+            for (unsigned int c = '0'; c <= '9'; ++c)
+                table[c] = Identifier | Digit;
+            for (unsigned int c = 'A'; c <= 'Z'; ++c)
+                table[c] = Identifier;
+            for (unsigned int c = 'a'; c <= 'z'; ++c)
+                table[c] = Identifier;
+
+            table['.']  = Identifier;
+            table['_']  = Identifier;
+
+            table[' ']  = Whitespace;
+            table['\t'] = Whitespace;
+            table['\v'] = Whitespace;
+            table['\f'] = Whitespace;
+            table['\r'] = Whitespace;
+            table['\n'] = Whitespace | Newline;
+
+            for (char c : std::string_view(",:[]()-~+*/?|&^@$<>"))
+                table[static_cast<uint8_t>(c)] = Symbol;
+
+            table['\''] = Quote;
+            table['\"'] = Quote;
+            table[';']  = Comment;
+            table['\0'] = Terminator;
+
+            return table;
+        }
+
+        static Dispatch SelectDispatch(Implementation impl);
+    public:
+        static const std::array<uint8_t, 256> CharClassTable;
+
+        static inline bool Is(char c, uint8_t classMask) { return (CharClassTable[static_cast<uint8_t>(c)] & classMask) != 0; }
+
+        //Skips whitespace, 'lines' is increased by the number of skipped newlines
+        static inline const char* SkipWhitespace(const char* pos, unsigned int& lines)
+        {
+            //Short runs are the common case, block scanning pays off only for long ones
+            for (unsigned int i = 0; i < shortRunLength; ++i, ++pos)
+            {
+                if (Is(*pos, Whitespace) == false)
+                    return pos;
+
+                lines += (*pos == '\n');
+            }
+
+            return dispatch.skipWhitespace(pos, lines);
+        }
+
+        //Returns position of the '\n' or '\0' that ends the current line
+        static inline const char* SkipToLineEnd(const char* pos) { return dispatch.skipToLineEnd(pos); }
+
+        static inline const char* SkipIdentifier(const char* pos)
+        {
+            for (unsigned int i = 0; i < shortRunLength; ++i, ++pos)
+                if (Is(*pos, Identifier) == false)
+                    return pos;
+
+            return dispatch.skipIdentifier(pos);
+        }
+
+        static inline const char* SkipUntilWhitespace(const char* pos)
+        {
+            while (Is(*pos, Whitespace | Terminator) == false)
+                ++pos;
+
+            return pos;
+        }
+
+        //Returns false if implementation isn't supported by the host CPU
+        static bool SetImplementation(Implementation impl);
+        static inline Implementation GetImplementation() { return implementation; }
+        static Implementation GetBestImplementation();
+    };
+
+    inline constexpr std::array<uint8_t, 256> Scanner::CharClassTable = Scanner::MakeCharClassTable();
+}
+
+#endif
@@ -12,49 +12,7 @@ using namespace ASM::AST;
 using namespace ASM::Codegen;
 using namespace ASM::Arch;
 
-bool InstructionStmt::IsCorrectMemoryExprPass(Expression* expression, bool registersCheck)
-{
-    bool result = true;
-
-    if (expression->Is<BinaryExpr>())
-    {
-        BinaryExpr* binaryExpr = expression->GetAs<BinaryExpr>();
-
-        bool lhsCheck = registersCheck;
-        bool rhsCheck = registersCheck;
-
-        if (binaryExpr->operation != '+' && binaryExpr->operation != '-')
-            lhsCheck = rhsCheck = true;
-        else if (binaryExpr->operation == '-')
-            rhsCheck = true; 
-
-        result = IsCorrectMemoryExprPass(binaryExpr->lhs.get(), lhsCheck);
-        result &= IsCorrectMemoryExprPass(binaryExpr->rhs.get(), rhsCheck);
-    }
-    else if (expression->Is<UnaryExpr>())
-    {
-        UnaryExpr* unaryExpr = expression->GetAs<UnaryExpr>();
-
-        result = IsCorrectMemoryExprPass(unaryExpr->GetExpression(), registersCheck || unaryExpr->GetOperation() != '+');
-    }
-    else if (registersCheck && expression->Is<RegisterExpr>())
-    {
-        result = false;
-    }
-    else if (expression->Is<ParenExpr>())
-    {
-        result = IsCorrectMemoryExprPass(expression->GetAs<ParenExpr>()->GetExpression(), registersCheck);
-    }
-
-    return result;
-}
-
-bool InstructionStmt::IsCorrectMemoryExpr(MemoryExpr* expression)
-{
-    return IsCorrectMemoryExprPass(expression->GetExpression());
-}
-
-void InstructionStmt::EncodeModRM(ModRM modrm, const std::unique_ptr<Expression>& operand, CodeGenerator& generator, MachineCode& code)
+void InstructionStmt::EncodeModRM(ModRM modrm, Expression* operand, CodeGenerator& generator, CodeEmitter& code)
 {
     int64_t displacement = 0;
     uint8_t dispSize = 0;
@@ -68,25 +26,17 @@ void InstructionStmt::EncodeModRM(ModRM modrm, const std::unique_ptr<Expression>
     {
         MemoryExpr* memoryExpr = operand->GetAs<MemoryExpr>();
 
-        if (IsCorrectMemoryExpr(memoryExpr) == false ||
-            Arch8086::RmRegsCombinations.count(memoryExpr->GetRmRegsCombination()) == 0)
+        if (memoryExpr->IsValidAddressing() == false)
         {
             generator.GetContext().Error("Invalid memory expression");
             return;
         }
 
-        if (memoryExpr->GetSegOverride() != nullptr)
-        {
-            InstructionPrefix segOverridePrefix = Arch8086::SregToSegOverride.at(memoryExpr->GetSegOverride()->GetIdentifier());
-            code->insert(code->begin(), { static_cast<uint8_t>(segOverridePrefix) });
-        }
-
-        auto regsCombination = memoryExpr->GetRmRegsCombination();
         auto dispValue = generator.ResolveExpression(memoryExpr->GetExpression());
 
         displacement = dispValue.value_or(0);
 
-        if (regsCombination.empty())
+        if (memoryExpr->HasRegisters() == false)
         {
             modrm.mod = Mod::MEM;
             modrm.rm = RM::DISP_16;
@@ -97,15 +47,15 @@ void InstructionStmt::EncodeModRM(ModRM modrm, const std::unique_ptr<Expression>
             if (dispValue.has_value() == false)
             {
                 if (generator.IsExpressionHasAddressSymbol(memoryExpr->GetExpression()))
-                    generator.MakeAbsoluteLinkTarget(memoryExpr->GetExpression(), code->size() + 1, maxModRm16DisplacementSize);
+                    generator.MakeAbsoluteLinkTarget(memoryExpr->GetExpression(), code.GetPosition() + 1, maxModRm16DisplacementSize);
                 else
-                    generator.MakeValueLinkTarget(memoryExpr->GetExpression(), code->size() + 1, maxModRm16DisplacementSize, LinkingTarget::Type::Integer);
+                    generator.MakeValueLinkTarget(memoryExpr->GetExpression(), code.GetPosition() + 1, maxModRm16DisplacementSize, LinkingTarget::Type::Integer);
             }
         }
         else
         {
             modrm.mod = Mod::MEM;
-            modrm.rm = Arch8086::RmRegsCombinations.at(regsCombination);
+            modrm.rm = memoryExpr->GetRm();
 
             //Disp
             if (dispValue.has_value() == false)
@@ -114,14 +64,14 @@ void InstructionStmt::EncodeModRM(ModRM modrm, const std::unique_ptr<Expression>
                 dispSize = maxModRm16DisplacementSize;
 
                 if (generator.IsExpressionHasAddressSymbol(memoryExpr->GetExpression()))
-                    generator.MakeAbsoluteLinkTarget(memoryExpr->GetExpression(), code->size() + 1, maxModRm16DisplacementSize);
+                    generator.MakeAbsoluteLinkTarget(memoryExpr->GetExpression(), code.GetPosition() + 1, maxModRm16DisplacementSize);
                 else
-                    generator.MakeValueLinkTarget(memoryExpr->GetExpression(), code->size() + 1, maxModRm16DisplacementSize, LinkingTarget::Type::Integer);
+                    generator.MakeValueLinkTarget(memoryExpr->GetExpression(), code.GetPosition() + 1, maxModRm16DisplacementSize, LinkingTarget::Type::Integer);
             }
             else
             {
                 if (displacement != 0 ||
-                    (regsCombination.size() == 1 && regsCombination.back() == RegisterIdentifier::BP))
+                    memoryExpr->GetRmRegsMask() == GetRmRegBit(RegisterIdentifier::BP))
                 {
                     dispSize = CodeGenerator::EvaluateLiteralByteSize(displacement);
 
@@ -146,7 +96,7 @@ void InstructionStmt::EncodeModRM(ModRM modrm, const std::unique_ptr<Expression>
     return;
 }
 
-void InstructionStmt::EncodeImm(Expression* operand, Operand operandPrototype, CodeGenerator& generator, MachineCode& code)
+void InstructionStmt::EncodeImm(Expression* operand, Operand operandPrototype, CodeGenerator& generator, CodeEmitter& code)
 {
     uint8_t size = operandPrototype.size / 8;
     int64_t value = 0;
@@ -154,21 +104,21 @@ void InstructionStmt::EncodeImm(Expression* operand, Operand operandPrototype, C
     if (operandPrototype.type == OpType::moffs || operandPrototype.type == OpType::ptr)
         size = 2;
 
-    if (operand->IsDependent())
+    if (operand->IsConstant() == false)
     {
         switch (operandPrototype.type)
         {
         case OpType::rel:
-            generator.MakeRelativeLinkTarget(operand, code->size(), size, code->size() + size);
+            generator.MakeRelativeLinkTarget(operand, code.GetPosition(), size, code.GetPosition() + size);
             break;
         case OpType::imm:
-            generator.MakeValueLinkTarget(operand, code->size(), size, ASM::LinkingTarget::Type::Integer);
+            generator.MakeValueLinkTarget(operand, code.GetPosition(), size, ASM::LinkingTarget::Type::Integer);
             break;
         case OpType::ptr:
-            generator.MakeAbsoluteLinkTarget(operand, code->size(), size);
+            generator.MakeAbsoluteLinkTarget(operand, code.GetPosition(), size);
             break;
         default:
-            generator.MakeAbsoluteLinkTarget(operand, code->size(), size);
+            generator.MakeAbsoluteLinkTarget(operand, code.GetPosition(), size);
             break;
         }
     }
@@ -180,18 +130,48 @@ void InstructionStmt::EncodeImm(Expression* operand, Operand operandPrototype, C
     code.Push(reinterpret_cast<uint8_t*>(&value), size);
 }
 
-MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const 
+void InstructionStmt::EncodePrefixes(const Instruction& instruction, CodeEmitter& code) const
+{
+    const Expression* modrmOperand = nullptr;
+
+    switch (instruction.opencode)
+    {
+    case OpEn::RM:
+        modrmOperand = operands[1];
+        break;
+    case OpEn::MR: case OpEn::MI: case OpEn::M: case OpEn::M1: case OpEn::MC:
+        modrmOperand = operands[0];
+        break;
+    default:
+        return;
+    }
+
+    if (modrmOperand->Is<MemoryExpr>() == false)
+        return;
+
+    const MemoryExpr* memoryExpr = modrmOperand->GetAs<MemoryExpr>();
+
+    //Invalid memory expressions are reported by EncodeModRM, nothing is written for them
+    if (memoryExpr->GetSegOverride() != nullptr && memoryExpr->IsValidAddressing())
+    {
+        InstructionPrefix segOverridePrefix = Arch8086::SregToSegOverride.at(memoryExpr->GetSegOverride()->GetIdentifier());
+        code << static_cast<uint8_t>(segOverridePrefix);
+    }
+}
+
+void InstructionStmt::CodeGen(CodeGenerator& generator, CodeEmitter& result) const 
 {
-    MachineCode result;
     const Instruction* instructionPrototype = generator.ChooseInstructionByOperands(mnemonic, operands, sectionStmtOffset);
 
     if (instructionPrototype == nullptr)
     {
         generator.GetContext().Error("Invalid operands combination", location, length);
 
-        return std::move(result);
+        return;
     }
 
+    EncodePrefixes(*instructionPrototype, result);
+
     result.Push(instructionPrototype->opcode.data(), instructionPrototype->opcode.size());
 
     switch (instructionPrototype->opencode)
@@ -234,7 +214,7 @@ MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const
         modrm.reg = static_cast<Register>(instructionPrototype->opcodeExtention);
 
         EncodeModRM(modrm, operands[0], generator, result);
-        EncodeImm(operands[1].get(), instructionPrototype->operands[1], generator, result);
+        EncodeImm(operands[1], instructionPrototype->operands[1], generator, result);
 
         break;
     }
@@ -252,9 +232,9 @@ MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const
     {
         //Opcode - Imm
 
-        result->back() += static_cast<uint8_t>(operands[0]->GetAs<RegisterExpr>()->GetEncoding());
+        result.Back() += static_cast<uint8_t>(operands[0]->GetAs<RegisterExpr>()->GetEncoding());
 
-        EncodeImm(operands[1].get(), instructionPrototype->operands[1], generator, result);
+        EncodeImm(operands[1], instructionPrototype->operands[1], generator, result);
 
         break;
     }
@@ -264,7 +244,7 @@ MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const
         //Relative encoding based on the end of instruction code, to calcule relative address use ('absolute address' - 'instruction end position')
         //Pointer encoding uses absolute address in memory
 
-        EncodeImm(operands[0].get(), instructionPrototype->operands[0], generator, result);
+        EncodeImm(operands[0], instructionPrototype->operands[0], generator, result);
 
         break;
     }
@@ -278,7 +258,7 @@ MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const
             if (instructionPrototype->operands[pos].type == OpType::imm)
                 break;
 
-        EncodeImm(operands[pos].get(), instructionPrototype->operands[pos], generator, result);
+        EncodeImm(operands[pos], instructionPrototype->operands[pos], generator, result);
 
         break;
     }
@@ -297,7 +277,7 @@ MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const
     {
         //Opcode
 
-        result->back() += static_cast<uint8_t>(operands[0]->GetAs<RegisterExpr>()->GetEncoding());
+        result.Back() += static_cast<uint8_t>(operands[0]->GetAs<RegisterExpr>()->GetEncoding());
 
         break;
     }
@@ -323,11 +303,9 @@ MachineCode InstructionStmt::CodeGen(CodeGenerator& generator) const
 
         break;
     }
-
-    return std::move(result);
 }
 
-void DefineDataStmt::CodeGenDataUnit(Expression* dataUnit, MachineCode& result, CodeGenerator& generator) const
+void DefineDataStmt::CodeGenDataUnit(Expression* dataUnit, CodeEmitter& result, CodeGenerator& generator) const
 {
     if (dataUnit->Is<LiteralExpr>()) {
         LiteralExpr* literal = dataUnit->GetAs<LiteralExpr>();
@@ -345,8 +323,8 @@ void DefineDataStmt::CodeGenDataUnit(Expression* dataUnit, MachineCode& result,
     else {
         int64_t value = 0;
 
-        if (dataUnit->IsDependent())
-            generator.MakeValueLinkTarget(dataUnit, result->size(), dataUnitSize, LinkingTarget::Type::Integer);
+        if (dataUnit->IsConstant() == false)
+            generator.MakeValueLinkTarget(dataUnit, result.GetPosition(), dataUnitSize, LinkingTarget::Type::Integer);
         else
             value = dataUnit->Resolve();
 
@@ -354,21 +332,8 @@ void DefineDataStmt::CodeGenDataUnit(Expression* dataUnit, MachineCode& result,
     }
 }
 
-size_t InstructionStmt::GetMaxStmtByteSize() const
-{
-    size_t result = 1;
-    
-    for (auto& instruction : Arch8086::InstructionSet.at(mnemonic))
-        if (instruction.GetMaxByteSize() > result)
-            result = instruction.GetMaxByteSize();
-
-    return result;
-}
-
-MachineCode DefineDataStmt::CodeGen(CodeGenerator& generator) const
+void DefineDataStmt::CodeGen(CodeGenerator& generator, CodeEmitter& result) const
 {
-    MachineCode result;
-
     for (auto& dataUnit : units)
     {
         if (dataUnit->Is<DuplicateExpr>()) [[unlikely]]
@@ -407,21 +372,20 @@ MachineCode DefineDataStmt::CodeGen(CodeGenerator& generator) const
                     result.Push(reinterpret_cast<uint8_t*>(&data), dataUnitSize);
             }
             else {
-                const uint8_t zero = 0;
+                //Placeholder of the whole unit size, it's filled by the linker
+                const int64_t zero = 0;
 
                 for (size_t i = 0; i < *count; ++i) {
-                    generator.MakeValueLinkTarget(dupExpr->GetValueExpression(), result->size(), dataUnitSize, LinkingTarget::Type::Integer);
-                    result.Push(&zero, dataUnitSize);
+                    generator.MakeValueLinkTarget(dupExpr->GetValueExpression(), result.GetPosition(), dataUnitSize, LinkingTarget::Type::Integer);
+                    result.Push(reinterpret_cast<const uint8_t*>(&zero), dataUnitSize);
                 }
             }
         }
         else
         {
-            CodeGenDataUnit(dataUnit.get(), result, generator);
+            CodeGenDataUnit(dataUnit, result, generator);
         }
     }
-
-    return std::move(result);
 }
 
 size_t DefineDataStmt::GetMaxStmtByteSize() const
@@ -438,7 +402,7 @@ size_t DefineDataStmt::GetMaxStmtByteSize() const
 
             int64_t count = 256;
 
-            if (dupExpr->GetCountExpression()->IsDependent() == false)
+            if (dupExpr->GetCountExpression()->IsConstant())
                 count = dupExpr->GetCountExpression()->Resolve();
 
             result += count * dataUnitSize;
@@ -451,22 +415,20 @@ size_t DefineDataStmt::GetMaxStmtByteSize() const
     return result;
 }
 
-MachineCode OrgStmt::CodeGen(Codegen::CodeGenerator& generator) const
+void OrgStmt::CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter&) const
 {
-    MachineCode result;
-
-    auto org = generator.ResolveExpression(value.get());
+    auto org = generator.ResolveExpression(value);
 
     if (org.has_value() == false) [[unlikely]]
     {
         generator.GetContext().Error("Can't resolve expression dependencies on code generation stage", location, length);
-        return result;
+        return;
     }
 
     if (*org < 0) [[unlikely]]
     {
         generator.GetContext().Error("Origin must be a positive integer value", location, length);
-        return result;
+        return;
     }
 
     size_t currentOrg = generator.GetContext().GetSymbolTable().GetOrigin();
@@ -474,35 +436,29 @@ MachineCode OrgStmt::CodeGen(Codegen::CodeGenerator& generator) const
     if (currentOrg != 0 && currentOrg != org)
     {
         generator.GetContext().Warn("Origin redefenition ingnored", location, length);
-        return result;
+        return;
     }
 
     generator.GetContext().GetSymbolTable().SetOrigin(*org);
-
-    return result;
 }
 
-MachineCode OffsetStmt::CodeGen(Codegen::CodeGenerator& generator) const
+void OffsetStmt::CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const
 {
-    MachineCode result;
-
-    auto offset = generator.ResolveExpression(value.get());
+    auto offset = generator.ResolveExpression(value);
 
     if (offset.has_value() == false) [[unlikely]]
     {
         generator.GetContext().Error("Can't resolve expression dependencies on code generation stage", location, length);
-        return result;
+        return;
     }
 
     if (*offset < 0) [[unlikely]]
     {
         generator.GetContext().Error("Offset must be a positive integer value", location, length);
-        return result;
+        return;
     }
 
-    result->resize(*offset, generator.GetNopInstructionOpcode());
-
-    return result;
+    code.Fill(*offset, generator.GetNopInstructionOpcode());
 }
 
 size_t OffsetStmt::GetMaxStmtByteSize() const
@@ -510,20 +466,18 @@ size_t OffsetStmt::GetMaxStmtByteSize() const
     return value->Resolve();
 }
 
-MachineCode AlignStmt::CodeGen(Codegen::CodeGenerator& generator) const
+void AlignStmt::CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const
 {
-    MachineCode result;
-
-    auto align = generator.ResolveExpression(value.get());
+    auto align = generator.ResolveExpression(value);
 
     if (align.has_value() == false) [[unlikely]]
     {
         generator.GetContext().Error("Can't resolve expression dependencies on code generation stage", location, length);
-        return result;
+        return;
     }
 
     if  (*align == 0 || *align == 1) [[unlikely]]
-        return result;
+        return;
 
     float logVal = std::log2(*align);
 
@@ -531,16 +485,13 @@ MachineCode AlignStmt::CodeGen(Codegen::CodeGenerator& generator) const
     if (align < 0 || std::ceil(logVal) != std::floor(logVal))
     {
         generator.GetContext().Error("Align must be a positive power of two", location, length);
-        return result;
+        return;
     }
 
-    const MachineCode& code = generator.GetCurrentSectionCode();
-    size_t mod = code->size() % *align;
+    size_t mod = code.GetPosition() % *align;
     
     if (mod > 0)
-        result->resize(*align - mod, generator.GetNopInstructionOpcode());
-
-    return result;
+        code.Fill(*align - mod, generator.GetNopInstructionOpcode());
 }
 
 size_t AlignStmt::GetMaxStmtByteSize() const
@@ -548,26 +499,22 @@ size_t AlignStmt::GetMaxStmtByteSize() const
     return value->Resolve();
 }
 
-MachineCode StackStmt::CodeGen(Codegen::CodeGenerator& generator) const
+void StackStmt::CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter&) const
 {
-    MachineCode result;
-
-    auto size = generator.ResolveExpression(value.get());
+    auto size = generator.ResolveExpression(value);
 
     if (size.has_value() == false) [[unlikely]]
     {
         generator.GetContext().Error("Can't resolve expression dependencies on code generation stage", location, length);
-        return result;
+        return;
     }
 
     if (generator.GetContext().GetTranslationUnit().GetRequiredStackSize() != 0 &&
         *size != generator.GetContext().GetTranslationUnit().GetRequiredStackSize())
     {
         generator.GetContext().Error("Stack size redefenition", location, length);
-        return result;
+        return;
     }
 
     generator.GetContext().GetTranslationUnit().SetStackSize(*size);
-
-    return result;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "expressions.h"
 #include "codegen/machine-code.h"
 #include "arch/arch.h"
+#include "utils/small-vector.h"
 
 namespace ASM
 {
@@ -21,8 +22,12 @@ namespace ASM::AST
 {
     struct Statement : public Node
     {
+    protected:
+        Statement(NodeKind kind) : Node(kind) {}
     public:
-        virtual Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const = 0;
+        AST_NODE_KIND_RANGE(InstructionStmt, StackStmt)
+
+        virtual void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const = 0;
         virtual size_t GetMaxStmtByteSize() const { return 0; }
     };
 
@@ -32,36 +37,46 @@ namespace ASM::AST
         static constexpr uint8_t minModRm16DisplacementSize = 1;
         static constexpr uint8_t maxModRm16DisplacementSize = 2;
 
-        std::string mnemonic;
-        std::vector<std::unique_ptr<Expression>> operands;
+        Arch::Mnemonic mnemonic = Arch::Mnemonic::NOP;
+        //Resolved by the parser, so codegen doesn't look the mnemonic up again
+        const Arch::InstructionTable::Forms_t* forms = nullptr;
+        uint8_t maxByteSize = 1;
+        //Stored inline, no instruction form has more operands
+        SmallVector<Expression*, 4> operands;
 
         size_t sectionStmtOffset = 0;
 
         friend class ASM::Parser;
 
-        static bool IsCorrectMemoryExprPass(AST::Expression* expression, bool registersCheck = false);
-        static bool IsCorrectMemoryExpr(AST::MemoryExpr* expression);
-
         static void EncodeModRM
         (
-            Arch::ModRM source, const std::unique_ptr<Expression>& operand,
-            Codegen::CodeGenerator& generator, Codegen::MachineCode& code
+            Arch::ModRM source, Expression* operand,
+            Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code
         );
 
         static void EncodeImm
         (
             Expression* operand,
             Arch::Operand operandPrototype, Codegen::CodeGenerator& generator,
-            Codegen::MachineCode& code
+            Codegen::CodeEmitter& code
         );
+
+        //Segment override of the operand encoded in ModRM, written before the opcode
+        void EncodePrefixes(const Arch::Instruction& instruction, Codegen::CodeEmitter& code) const;
     public:
+        AST_NODE_KIND(InstructionStmt)
+
+        InstructionStmt() : Statement(NodeKind::InstructionStmt) {}
+
         using Operands_t = decltype(InstructionStmt::operands);
 
-        inline const std::string& GetMnemonic() const { return mnemonic; }
-        inline std::vector<std::unique_ptr<Expression>>& GetOperands() { return operands; }
+        inline Arch::Mnemonic GetMnemonic() const { return mnemonic; }
+        inline const Arch::InstructionTable::Forms_t& GetForms() const { return *forms; }
+        inline Operands_t& GetOperands() { return operands; }
+        inline size_t GetSectionStmtOffset() const { return sectionStmtOffset; }
 
-        Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const override;
-        size_t GetMaxStmtByteSize() const override;
+        void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const override;
+        inline size_t GetMaxStmtByteSize() const override { return maxByteSize; }
     };
 
     struct DefineDataStmt : public Statement
@@ -71,14 +86,18 @@ namespace ASM::AST
 
         uint8_t dataUnitSize = 1;
 
-        std::vector<std::unique_ptr<Expression>> units;
+        std::vector<Expression*> units;
 
-        void CodeGenDataUnit(Expression* dataUnit, Codegen::MachineCode& result, Codegen::CodeGenerator& generator) const;
+        void CodeGenDataUnit(Expression* dataUnit, Codegen::CodeEmitter& code, Codegen::CodeGenerator& generator) const;
     public:
+        AST_NODE_KIND(DefineDataStmt)
+
+        DefineDataStmt() : Statement(NodeKind::DefineDataStmt) {}
+
         inline uint8_t GetDataUnitSize() const { return dataUnitSize; }
-        inline std::vector<std::unique_ptr<Expression>>& GetUnits() { return units; }
+        inline std::vector<Expression*>& GetUnits() { return units; }
 
-        Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const override;
+        void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const override;
         size_t GetMaxStmtByteSize() const override;
     };
 
@@ -87,35 +106,55 @@ namespace ASM::AST
     protected:
         friend class ASM::Parser;
 
-        std::unique_ptr<Expression> value;
+        Expression* value = nullptr;
+
+        ParametricStmt(NodeKind kind) : Statement(kind) {}
     public:
-        inline Expression* GetValueExpression() const { return value.get(); }
+        AST_NODE_KIND_RANGE(OrgStmt, StackStmt)
+
+        inline Expression* GetValueExpression() const { return value; }
     };
 
     struct OrgStmt : public ParametricStmt
     {
     public:
-        Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const override;
+        AST_NODE_KIND(OrgStmt)
+
+        OrgStmt() : ParametricStmt(NodeKind::OrgStmt) {}
+
+        void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const override;
     };
 
     struct OffsetStmt : public ParametricStmt
     {
     public:
-        Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const override;
+        AST_NODE_KIND(OffsetStmt)
+
+        OffsetStmt() : ParametricStmt(NodeKind::OffsetStmt) {}
+
+        void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const override;
         size_t GetMaxStmtByteSize() const override;
     };
 
     struct AlignStmt : public ParametricStmt
     {
     public:
-        Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const override;
+        AST_NODE_KIND(AlignStmt)
+
+        AlignStmt() : ParametricStmt(NodeKind::AlignStmt) {}
+
+        void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const override;
         size_t GetMaxStmtByteSize() const override;
     };
 
     struct StackStmt : public ParametricStmt
     {
     public:
-        Codegen::MachineCode CodeGen(Codegen::CodeGenerator& generator) const override;
+        AST_NODE_KIND(StackStmt)
+
+        StackStmt() : ParametricStmt(NodeKind::StackStmt) {}
+
+        void CodeGen(Codegen::CodeGenerator& generator, Codegen::CodeEmitter& code) const override;
     };
 }
 
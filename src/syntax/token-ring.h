@@ -0,0 +1,90 @@
+#ifndef __TOKEN_RING_H
+#define __TOKEN_RING_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+#include "token.h"
+
+namespace ASM
+{
+    //Bounded single producer/single consumer queue between the lexer thread and the parser.
+    //Indices are published in batches, so the other side is woken only once per batch,
+    //and a side that has nothing to do sleeps in atomic wait instead of spinning.
+    class TokenRing
+    {
+    public:
+        static constexpr size_t Capacity = 4096;
+        static constexpr size_t BatchSize = 64;
+    private:
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(Capacity % BatchSize == 0, "Capacity must be a multiple of batch size");
+
+        static constexpr size_t mask = Capacity - 1;
+        static constexpr size_t cacheLineSize = 64;
+
+        std::unique_ptr<Token[]> slots = std::make_unique<Token[]>(Capacity);
+
+        //Producer side
+        alignas(cacheLineSize) std::atomic<size_t> tail = 0;
+        size_t writeIndex = 0;
+        size_t cachedHead = 0;
+
+        //Consumer side
+        alignas(cacheLineSize) std::atomic<size_t> head = 0;
+        size_t readIndex = 0;
+        size_t cachedTail = 0;
+    public:
+        TokenRing() = default;
+        TokenRing(const TokenRing&) = delete;
+        TokenRing& operator=(const TokenRing&) = delete;
+
+        //Producer only, blocks while the ring is full
+        void Push(const Token& token)
+        {
+            if (writeIndex - cachedHead == Capacity) [[unlikely]]
+            {
+                //Consumer can't make progress on unpublished tokens
+                Flush();
+
+                while (writeIndex - (cachedHead = head.load(std::memory_order_acquire)) == Capacity)
+                    head.wait(cachedHead, std::memory_order_acquire);
+            }
+
+            slots[writeIndex & mask] = token;
+
+            if ((++writeIndex & (BatchSize - 1)) == 0 || token.Is(TokKind::eof))
+                Flush();
+        }
+
+        //Producer only, makes all pushed tokens visible to the consumer
+        void Flush()
+        {
+            tail.store(writeIndex, std::memory_order_release);
+            tail.notify_one();
+        }
+
+        //Consumer only, blocks while the ring is empty
+        Token Pop()
+        {
+            if (readIndex == cachedTail) [[unlikely]]
+            {
+                while ((cachedTail = tail.load(std::memory_order_acquire)) == readIndex)
+                    tail.wait(readIndex, std::memory_order_acquire);
+            }
+
+            const Token token = slots[readIndex & mask];
+
+            if ((++readIndex & (BatchSize - 1)) == 0)
+            {
+                head.store(readIndex, std::memory_order_release);
+                head.notify_one();
+            }
+
+            return token;
+        }
+    };
+}
+
+#endif
@@ -1,49 +1,21 @@
 #ifndef __TOKEN_H
 #define __TOKEN_H
 
-#include <string>
+#include <string_view>
 #include <cstdint>
-#include <memory>
 #include <cassert>
+#include <type_traits>
 
 #include "context/source-location.h"
+#include "context/string-interner.h"
 
 #include "arch/8086/regs.h"
+#include "reserved-words.h"
 
 namespace ASM
 {
     class Lexer;
 
-    struct TokenData 
-    {
-        virtual ~TokenData() = default;
-    };
-
-    struct TokenString final : public TokenData
-    {
-    private:
-        std::string value;
-    public:
-        TokenString(const char* const string, size_t length) : value(string, length) {}
-        TokenString(const std::string& string) : value(string) {}
-
-        inline const std::string& GetValue() const { return value; }
-    };
-
-    struct TokenNumeric final : public TokenData
-    {
-    private:
-        double value = 0;
-    public:
-        TokenNumeric(double val) : value(val) {}
-        TokenNumeric(Arch::RegisterIdentifier reg) : value(static_cast<uint8_t>(reg)) {}
-
-        inline double GetValue() const { return value; }
-        inline int64_t GetNum() const { return  static_cast<int64_t>(value); }
-        inline char GetAscii() const { return  static_cast<char>(value); }
-        inline Arch::RegisterIdentifier GetRegId() const { return static_cast<Arch::RegisterIdentifier>(value); }
-    };
-
     struct Token
     {
         enum class Kind : uint8_t
@@ -107,10 +79,16 @@ namespace ASM
         SourceLocation location;
         unsigned int length = 0;
 
-        std::unique_ptr<TokenData> data = nullptr;
-
         Kind kind = Kind::unknown;
 
+        //Token is preceded by a newline or starts the source
+        bool firstOnLine = false;
+
+        //Numeric value, character code or register identifier.
+        //Identifiers keep reserved word id in the low half and interned name id in the high half.
+        //Text of identifiers and string literals is taken from the source directly.
+        int64_t value = 0;
+
         friend class Lexer;
     public:
         inline Kind GetKind() const { return kind; }
@@ -121,21 +99,56 @@ namespace ASM
         inline bool IsKeyword() const { return (kind >= Kind::kw_global && kind < Kind::l_square); }
         inline bool IsBinaryOperator() const { return (kind >= Kind::plus && kind <= Kind::greatgreat); }
         inline bool IsUnaryOperator() const { return (kind >= Kind::minus && kind <= Kind::tilda); }
-        inline bool IsSameLine(const Token& other) const { return (location.line == other.location.line); }
+        inline bool IsFirstOnLine() const { return firstOnLine; }
+
+        //Tokens must be adjacent in the stream
+        inline bool IsSameLine(const Token& other) const
+        { return ((other.location.sourcePointer > location.sourcePointer ? other.firstOnLine : firstOnLine) == false); }
+
+        inline std::string_view GetText() const { return std::string_view(location.sourcePointer, length); }
+
+        //Identifier text or string literal content without quotes, points into the source
+        inline std::string_view GetString() const
+        {
+            assert(kind == Kind::identifier || kind == Kind::string_literal);
 
-        inline TokenString* GetAsString() const
-        { 
-            assert(dynamic_cast<TokenString*>(data.get()));
-            return reinterpret_cast<TokenString*>(data.get());
+            if (kind == Kind::string_literal)
+                return std::string_view(location.sourcePointer + 1, length - 2);
+
+            return GetText();
+        }
+
+        inline int64_t GetNum() const
+        {
+            assert(kind == Kind::num_constant || kind == Kind::char_constant);
+            return value;
         }
 
-        inline TokenNumeric* GetAsNum() const
+        inline Arch::RegisterIdentifier GetRegId() const
         {
-            assert(dynamic_cast<TokenNumeric*>(data.get()));
-            return reinterpret_cast<TokenNumeric*>(data.get());
+            assert(kind == Kind::reg);
+            return static_cast<Arch::RegisterIdentifier>(value);
         }
+
+        //Mnemonic or directive named by an identifier, ReservedWords::None for other identifiers
+        inline ReservedWordId GetReservedWordId() const
+        {
+            assert(kind == Kind::identifier);
+            return static_cast<ReservedWordId>(value);
+        }
+
+        //Interned upper case name, InvalidSymbolId for reserved words, they are interned only when used as names
+        inline SymbolId GetSymbolId() const
+        {
+            assert(kind == Kind::identifier);
+            return static_cast<SymbolId>(static_cast<uint64_t>(value) >> 32);
+        }
+
+        inline const ReservedWord& GetReservedWord() const { return ReservedWords::Get(GetReservedWordId()); }
     };
 
+    static_assert(std::is_trivially_copyable_v<Token>);
+
     using TokKind = Token::Kind;
 }
 
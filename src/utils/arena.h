@@ -0,0 +1,141 @@
+#ifndef __ASM_ARENA_H
+#define __ASM_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace ASM
+{
+    //Bump allocator, memory is given back only all at once when the arena is released.
+    //Objects with non trivial destructors are registered on creation and destroyed in reverse order.
+    class Arena
+    {
+    private:
+        static constexpr size_t defaultBlockSize = 64 * 1024;
+
+        //Header placed at the beginning of every block
+        struct Block
+        {
+            Block* previous;
+        };
+
+        struct Destructor
+        {
+            void (*destroy)(void*);
+            void* object;
+            Destructor* next;
+        };
+
+        Block* currentBlock = nullptr;
+        Destructor* destructors = nullptr;
+
+        uintptr_t cursor = 0;
+        uintptr_t limit = 0;
+
+        size_t blocksCount = 0;
+
+        void* AllocateSlow(size_t size, size_t alignment)
+        {
+            size_t blockSize = defaultBlockSize;
+
+            if (size + alignment + sizeof(Block) > blockSize)
+                blockSize = size + alignment + sizeof(Block);
+
+            Block* block = static_cast<Block*>(std::malloc(blockSize));
+
+            if (block == nullptr)
+                throw std::bad_alloc();
+
+            block->previous = currentBlock;
+            currentBlock = block;
+            ++blocksCount;
+
+            cursor = reinterpret_cast<uintptr_t>(block) + sizeof(Block);
+            limit = reinterpret_cast<uintptr_t>(block) + blockSize;
+
+            return Allocate(size, alignment);
+        }
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        Arena(Arena&& other) noexcept { *this = std::move(other); }
+
+        Arena& operator=(Arena&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Release();
+
+                std::swap(currentBlock, other.currentBlock);
+                std::swap(destructors, other.destructors);
+                std::swap(cursor, other.cursor);
+                std::swap(limit, other.limit);
+                std::swap(blocksCount, other.blocksCount);
+            }
+
+            return *this;
+        }
+
+        ~Arena() { Release(); }
+
+        //Alignment must be a power of two
+        inline void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+        {
+            const uintptr_t aligned = (cursor + alignment - 1) & ~(alignment - 1);
+
+            if (aligned + size > limit) [[unlikely]]
+                return AllocateSlow(size, alignment);
+
+            cursor = aligned + size;
+
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        template<typename T, typename... Args>
+        T* Make(Args&&... args)
+        {
+            T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+            if constexpr (std::is_trivially_destructible_v<T> == false)
+            {
+                Destructor* destructor = static_cast<Destructor*>(Allocate(sizeof(Destructor), alignof(Destructor)));
+
+                destructor->destroy = [](void* object) { static_cast<T*>(object)->~T(); };
+                destructor->object = object;
+                destructor->next = destructors;
+
+                destructors = destructor;
+            }
+
+            return object;
+        }
+
+        //Destroys all objects and frees all blocks, arena may be used again after
+        void Release()
+        {
+            for (; destructors != nullptr; destructors = destructors->next)
+                destructors->destroy(destructors->object);
+
+            while (currentBlock != nullptr)
+            {
+                Block* previous = currentBlock->previous;
+
+                std::free(currentBlock);
+                currentBlock = previous;
+            }
+
+            cursor = limit = 0;
+            blocksCount = 0;
+        }
+
+        inline size_t GetBlocksCount() const { return blocksCount; }
+    };
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef __ASM_CONTENT_HASH_H
+#define __ASM_CONTENT_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ASM
+{
+    //128-bit hash of content, for keys that name data outside of the process.
+    //Eight bytes are taken at a time and mixed into two independent lanes, so long inputs
+    //are hashed at memory speed. Not cryptographic, only unlikely to collide by accident.
+    //Each update is hashed on its own, equal hashes need the same data passed in the same pieces.
+    class ContentHash
+    {
+    private:
+        static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+        static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+
+        uint64_t low = 0x243F6A8885A308D3ull;
+        uint64_t high = 0x13198A2E03707344ull;
+        uint64_t length = 0;
+
+        static inline uint64_t Rotate(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+        static inline uint64_t Finalize(uint64_t value)
+        {
+            value ^= value >> 33;
+            value *= 0xFF51AFD7ED558CCDull;
+            value ^= value >> 33;
+            value *= 0xC4CEB9FE1A85EC53ull;
+            value ^= value >> 33;
+
+            return value;
+        }
+
+        inline void MixWord(uint64_t word)
+        {
+            low = Rotate(low ^ (word * prime1), 31) * prime2;
+            high = Rotate(high + (word * prime2), 27) * prime1;
+        }
+    public:
+        inline ContentHash& Update(const void* data, size_t size)
+        {
+            const char* bytes = static_cast<const char*>(data);
+            size_t i = 0;
+
+            for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, sizeof(word));
+
+                MixWord(word);
+            }
+
+            //Count of tail bytes goes to the last byte, so "a" and "a\0" differ
+            if (i < size)
+            {
+                uint64_t word = static_cast<uint64_t>(size - i) << 56;
+                std::memcpy(&word, bytes + i, size - i);
+
+                MixWord(word);
+            }
+
+            length += size;
+
+            return *this;
+        }
+
+        inline ContentHash& Update(std::string_view text) { return Update(text.data(), text.size()); }
+
+        template<typename T>
+        requires std::is_integral_v<T> || std::is_enum_v<T>
+        inline ContentHash& Update(T value) { return Update(&value, sizeof(value)); }
+
+        inline uint64_t GetLow() const { return Finalize(low ^ Rotate(high, 17) ^ length); }
+        inline uint64_t GetHigh() const { return Finalize(high ^ Rotate(low, 41) ^ (length * prime1)); }
+
+        //32 hex digits
+        std::string ToString() const
+        {
+            static constexpr char digits[] = "0123456789abcdef";
+
+            std::string result(32, '0');
+            const uint64_t halves[] = { GetHigh(), GetLow() };
+
+            for (size_t i = 0; i < 32; ++i)
+                result[i] = digits[(halves[i / 16] >> (60 - (i % 16) * 4)) & 0xF];
+
+            return result;
+        }
+    };
+}
+
+#endif
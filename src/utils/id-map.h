@@ -0,0 +1,74 @@
+#ifndef __ASM_ID_MAP_H
+#define __ASM_ID_MAP_H
+
+#include <cstdint>
+#include <cassert>
+#include <vector>
+
+namespace ASM
+{
+    //Map keyed by dense ids, values are stored in a flat array indexed by id.
+    //Keys are remembered in insertion order, so it can be iterated and cleared
+    //in time proportional to the number of entries instead of the largest id.
+    template<typename T>
+    class IdMap
+    {
+    private:
+        std::vector<T> values;
+        std::vector<uint8_t> present;
+        std::vector<uint32_t> keys;
+    public:
+        inline bool Contains(uint32_t id) const { return (id < present.size() && present[id] != 0); }
+
+        inline const T& At(uint32_t id) const { assert(Contains(id)); return values[id]; }
+        inline T& At(uint32_t id) { assert(Contains(id)); return values[id]; }
+
+        inline const T* Find(uint32_t id) const { return (Contains(id) ? &values[id] : nullptr); }
+
+        //Existing value is kept, returns false in that case
+        bool Insert(uint32_t id, const T& value)
+        {
+            if (Contains(id))
+                return false;
+
+            if (id >= present.size())
+            {
+                values.resize(id + 1);
+                present.resize(id + 1, 0);
+            }
+
+            values[id] = value;
+            present[id] = 1;
+            keys.push_back(id);
+
+            return true;
+        }
+
+        //Existing value is replaced
+        inline void Set(uint32_t id, const T& value)
+        {
+            if (Insert(id, value) == false)
+                values[id] = value;
+        }
+
+        //Storage is kept for reuse
+        void Clear()
+        {
+            for (uint32_t id : keys)
+            {
+                present[id] = 0;
+                values[id] = T();
+            }
+
+            keys.clear();
+        }
+
+        inline bool IsEmpty() const { return keys.empty(); }
+        inline size_t GetSize() const { return keys.size(); }
+
+        //Ids of all entries in insertion order
+        inline const std::vector<uint32_t>& GetKeys() const { return keys; }
+    };
+}
+
+#endif
@@ -50,6 +50,7 @@ namespace ASM
       }
 
       inline size_t size() const { return _size; }
+      static constexpr size_t capacity() { return N; }
 
       void clear() { while(_size > 0) { pop_back(); } }
 
@@ -62,8 +63,8 @@ namespace ASM
       inline iterator begin() { return storage.begin(); }
       inline const_iterator begin() const { return storage.begin(); }
 
-      inline iterator end() { return storage.end(); }
-      inline const_iterator end() const { return storage.end(); }
+      inline iterator end() { return storage.begin() + _size; }
+      inline const_iterator end() const { return storage.begin() + _size; }
 
       inline T& operator[](uint8_t index) { return storage[index]; }
       inline const T& operator[](uint8_t index) const { return storage[index]; }